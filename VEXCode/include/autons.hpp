@@ -1,5 +1,12 @@
 #pragma once
 
+#include <vector>
+
+// These are out of 127, shared by autons.cpp and pipeline_autons.cpp
+const int DRIVE_SPEED = 50;
+const int TURN_SPEED = 40;
+const int SWING_SPEED = 110;
+
 void default_constants();
 
 void drive_example();
@@ -15,7 +22,10 @@ void odom_pure_pursuit_example();
 void odom_pure_pursuit_wait_until_example();
 void odom_boomerang_example();
 void odom_boomerang_injected_pure_pursuit_example();
+void pipeline_boomerang_example();
+void pipeline_queue_example();
 void measure_offsets();
+void measure_offsets_fit();
 
 // ========== COMPETITION AUTONOMOUS ROUTINES ==========
 void autonomous_left_side();   // Left side scoring routine
@@ -24,3 +34,15 @@ void autonomous_right_side_full();
 void autonomous_right_side();  // Right side scoring routine
 void autonomous_safe();        // Safe fallback routine
 void autonomous_skills();      // Skills challenge routine
+
+/**
+ * One page of the auton selector.
+ */
+struct auton_page {
+  const char* name;  // title, then a blank line and what the routine does
+  void (*run)();
+  int limit;  // ms the routine has, 60 s for skills and 15 s for a match
+};
+
+// Every page of the auton selector, in order.  initialize() adds these and sim/pipeline_sim runs them
+extern const std::vector<auton_page> AUTON_PAGES;
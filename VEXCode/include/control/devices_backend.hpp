@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include "api.h"
+#include "control/drive_backend.hpp"
+#include "control/odometry.hpp"
+
+namespace control {
+/**
+ * Runs the pipeline on plain PROS motors and an IMU, without ez::Drive.  This has its own odometry from the drive motors and the IMU.
+ */
+class devices_backend : public drive_backend {
+ public:
+  /**
+   * Creates a drive from PROS devices, with the same arguments as ez::Drive.
+   *
+   * \param left_motor_ports
+   *        left motor ports, the first one is used for sensing.  Negative ports are reversed
+   * \param right_motor_ports
+   *        right motor ports, the first one is used for sensing.  Negative ports are reversed
+   * \param imu_port
+   *        IMU port
+   * \param wheel_diameter
+   *        diameter of the drive wheels in inches
+   * \param wheel_rpm
+   *        rpm of the drive wheels, cartridge * (motor gear / wheel gear)
+   */
+  devices_backend(std::vector<int> left_motor_ports, std::vector<int> right_motor_ports, int imu_port, double wheel_diameter, double wheel_rpm);
+
+  std::vector<pros::Motor> left_motors;
+  std::vector<pros::Motor> right_motors;
+  pros::Imu imu;
+
+  /**
+   * Sets how odometry integrates each update.  ODOM_EXPONENTIAL_ACCEL holds up at longer odometry periods and on fast
+   * swings.
+   *
+   * \param integrator
+   *        any odom_integrator, ODOM_MIDPOINT by default
+   */
+  void odom_integrator_set(odom_integrator integrator);
+
+  /**
+   * Returns how odometry integrates each update.
+   */
+  odom_integrator odom_integrator_get();
+
+  wheel_odometry* odometry_get() override;
+
+  void data_rate_set(int ms) override;
+  void zero() override;
+  drive_snapshot capture(bool batch) override;
+  ez::pose odom_update(const drive_snapshot& sensors) override;
+  ez::pose pose_get() override;
+  void pose_set(ez::pose itarget) override;
+  double imu_get() override;
+  void drive_set(double left, double right) override;
+
+ private:
+  double wheel_diameter;
+  double wheel_rpm;
+  double tick_per_inch = 1.0;
+  int left_sign = 1;
+  int right_sign = 1;
+  double left_offset = 0.0;
+  double right_offset = 0.0;
+  bool zeroed = false;
+  // Drive wheels are the same distance either side of center, so their offsets cancel
+  wheel_odometry odometry;
+  double imu_offset = 0.0;
+};
+}  // namespace control
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+
+#include "EZ-Template/util.hpp"
+#include "control/drive_snapshot.hpp"
+
+namespace control {
+struct motion_constants;
+class wheel_odometry;
+
+/**
+ * Everything the pipeline needs from a drive.  ez_backend runs an ez::Drive, devices_backend runs plain PROS devices.
+ */
+class drive_backend {
+ public:
+  virtual ~drive_backend() = default;
+
+  /**
+   * Runs when the pipeline takes over the drive.
+   */
+  virtual void enable() {}
+
+  /**
+   * Runs when the pipeline gives the drive back.
+   */
+  virtual void disable() {}
+
+  /**
+   * Copies tuned constants into the pipeline.  Backends without their own constants leave them alone.
+   *
+   * \param constants
+   *        constants to fill
+   */
+  virtual void constants_get(motion_constants& constants) {}
+
+  /**
+   * Returns the default way to turn.
+   */
+  virtual ez::e_angle_behavior turn_behavior_get() { return ez::shortest; }
+
+  /**
+   * Asks the odometry sensors to update every ms where they can.
+   *
+   * \param ms
+   *        update period
+   */
+  virtual void data_rate_set(int ms) {}
+
+  /**
+   * Lines sensors up with the drive's, after the drive sensors have been reset.
+   */
+  virtual void zero() = 0;
+
+  /**
+   * Reads every drive sensor.
+   *
+   * \param batch
+   *        true reads each device once, false reads every value separately
+   */
+  virtual drive_snapshot capture(bool batch) = 0;
+
+  /**
+   * Runs odometry with this tick's sensors and returns the new pose.
+   *
+   * \param sensors
+   *        this tick's snapshot
+   */
+  virtual ez::pose odom_update(const drive_snapshot& sensors) = 0;
+
+  /**
+   * Returns the odometry odom_update() runs, or nullptr when the drive runs odometry somewhere it can't be replayed.
+   */
+  virtual wheel_odometry* odometry_get() { return nullptr; }
+
+  /**
+   * Returns the current pose.
+   */
+  virtual ez::pose pose_get() = 0;
+
+  /**
+   * Moves odometry to a pose, it carries on from there.
+   *
+   * \param itarget
+   *        {x, y, theta} in inches and degrees
+   */
+  virtual void pose_set(ez::pose itarget) = 0;
+
+  /**
+   * Returns the current heading in degrees.
+   */
+  virtual double imu_get() = 0;
+
+  /**
+   * Sets the drive.
+   *
+   * \param left
+   *        -127 to 127
+   * \param right
+   *        -127 to 127
+   */
+  virtual void drive_set(double left, double right) = 0;
+
+  /**
+   * Counts device reads, so they show up in reads per tick.
+   *
+   * \param amount
+   *        amount of reads
+   */
+  void reads_add(int amount);
+
+  /**
+   * Ends a tick for the read counters.
+   */
+  void tick_end();
+
+  /**
+   * Counts reads separately until odom_tick_end(), for the odometry task.  It interrupts control ticks, so without this
+   * its reads would land in whichever tick it interrupted.
+   */
+  void odom_tick_begin();
+
+  /**
+   * Ends an odometry task update for the read counters, and goes back to counting the control tick.
+   */
+  void odom_tick_end();
+
+  /**
+   * Returns device reads in the last tick, or in the last odometry task update when called from inside one.
+   */
+  uint32_t reads_get();
+
+  /**
+   * Returns the average device reads per tick.
+   */
+  double reads_mean_get();
+
+  /**
+   * Clears the read counters.
+   */
+  void reads_reset();
+
+  /**
+   * Prints the read counters to the terminal.
+   */
+  void reads_print();
+
+ private:
+  struct read_counter {
+    uint32_t now = 0;
+    uint32_t last = 0;
+    uint64_t total = 0;
+    uint32_t ticks = 0;
+
+    void end();
+    double mean_get() const;
+  };
+
+  read_counter tick_reads;
+  read_counter odom_reads;
+  read_counter* counting = &tick_reads;
+};
+}  // namespace control
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace control {
+/**
+ * Every drive sensor, read once per tick.  Everything in a tick reads from this so values agree with each other.
+ */
+struct drive_snapshot {
+  // Drive sensors in inches.  These come from the left and right tracking wheels when they exist, like ez::Drive
+  double left = 0.0;
+  double right = 0.0;
+
+  // First motor on each side
+  double left_velocity = 0.0;  // rpm
+  double right_velocity = 0.0;
+  double left_mA = 0.0;
+  double right_mA = 0.0;
+  uint32_t left_timestamp = 0;  // ms, when the motor measured its position
+  uint32_t right_timestamp = 0;
+
+  // IMU, scaled the same as drive_imu_get()
+  double imu = 0.0;       // deg
+  double imu_rate = 0.0;  // deg/s, clockwise positive
+
+  // Tracking wheels in inches, 0 when the tracker doesn't exist
+  double tracker_left = 0.0;
+  double tracker_right = 0.0;
+  double tracker_front = 0.0;
+  double tracker_back = 0.0;
+
+  // micros() when the snapshot was taken
+  uint64_t timestamp = 0;
+};
+}  // namespace control
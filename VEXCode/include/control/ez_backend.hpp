@@ -0,0 +1,68 @@
+#pragma once
+
+#include "EZ-Template/drive/drive.hpp"
+#include "control/drive_backend.hpp"
+#include "control/odometry.hpp"
+
+namespace control {
+/**
+ * Runs the pipeline on an ez::Drive.  Odometry, trackers and tuned constants all come from the drive.
+ */
+class ez_backend : public drive_backend {
+ public:
+  /**
+   * \param drive
+   *        drive to run
+   */
+  ez_backend(ez::Drive& drive);
+
+  /**
+   * Pauses EZ-Template's autonomous task so it doesn't fight over the motors or run odometry a second time.
+   */
+  void enable() override;
+
+  /**
+   * Resumes EZ-Template's autonomous task.
+   */
+  void disable() override;
+
+  /**
+   * Runs odometry here from the snapshot, in double, instead of ez::Drive's tracking task.  ez::Drive's solve_xy_vert()
+   * and solve_xy_horiz() work in float.  The pose is set on the drive after every update, so everything reading
+   * odom_current still agrees.  Until this is called ez::Drive runs odometry.
+   *
+   * \param integrator
+   *        any odom_integrator
+   */
+  void odom_integrator_set(odom_integrator integrator);
+
+  void constants_get(motion_constants& constants) override;
+  ez::e_angle_behavior turn_behavior_get() override;
+  void data_rate_set(int ms) override;
+  void zero() override;
+  drive_snapshot capture(bool batch) override;
+  ez::pose odom_update(const drive_snapshot& sensors) override;
+  wheel_odometry* odometry_get() override;
+  ez::pose pose_get() override;
+  void pose_set(ez::pose itarget) override;
+  double imu_get() override;
+  void drive_set(double left, double right) override;
+
+ private:
+  ez::Drive& drive;
+  int left_sign = 1;
+  int right_sign = 1;
+  double left_offset = 0.0;
+  double right_offset = 0.0;
+  bool zeroed = false;
+
+  // Odometry run here instead of by ez::Drive
+  bool integrating = false;
+  bool integrator_primed = false;  // odometry has started from the drive's pose
+  wheel_odometry odometry;
+
+  void trackers_read(drive_snapshot& output);
+  odom_wheels wheels_read();
+  drive_snapshot capture_direct();
+};
+}  // namespace control
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "api.h"
+#include "control/drive_snapshot.hpp"
+#include "control/odometry.hpp"
+
+namespace control {
+/**
+ * What a flight_record holds.
+ */
+enum flight_record_type : uint32_t {
+  FLIGHT_UPDATE,  // one odometry update, the sensors it read and the pose it made
+  FLIGHT_MOVED,   // odometry's state, after the first update and whenever it's moved between updates
+};
+
+/**
+ * Sensors and pose from one odometry update.
+ */
+struct flight_update {
+  // Drive sensors in inches, as odometry reads them.  These are the left and right trackers when they exist
+  double left;
+  double right;
+  double imu;  // deg
+  // Tracking wheels in inches, 0 when the tracker doesn't exist
+  double tracker_left;
+  double tracker_right;
+  double tracker_front;
+  double tracker_back;
+  float imu_rate;  // deg/s
+  uint32_t reads;  // device reads the tick before this one
+  // Pose odometry made from these sensors
+  double x;
+  double y;
+  double theta;
+};
+
+/**
+ * One fixed size record.  The file is a flight_header then these, little endian as both the brain and a PC are.
+ */
+struct flight_record {
+  uint32_t timestamp = 0;  // us, micros() when the sensors were read, wrapping every 71 minutes
+  flight_record_type type = FLIGHT_UPDATE;
+  union {
+    flight_update update;        // FLIGHT_UPDATE
+    wheel_odometry_state moved;  // FLIGHT_MOVED
+  };
+
+  flight_record() : update() {}
+};
+
+/**
+ * Start of a recording.
+ */
+struct flight_header {
+  char magic[8];             // "FLIGHT" then 2 zeros
+  uint32_t version;          // flight_recorder::VERSION
+  uint32_t record_size;      // sizeof(flight_record)
+  uint32_t replayable;       // 1 when odometry ran through wheel_odometry, so updates replay through it
+  uint32_t integrator;       // odom_integrator, the enum's size isn't fixed
+  odom_wheels wheels;
+};
+
+/**
+ * Returns the sensors a FLIGHT_UPDATE record holds, as odometry read them.  Motor velocity and current aren't recorded.
+ */
+drive_snapshot flight_snapshot(const flight_record& record);
+
+static_assert(sizeof(flight_record) == 96, "the record layout is the file format");
+static_assert(sizeof(flight_header) == 64, "the header layout is the file format");
+
+/**
+ * Records every odometry update to the SD card, so a run that drifted can be replayed and looked at afterwards.
+ *
+ * Records go into one of two buffers.  When it fills, a low priority task writes it to the file while records go into
+ * the other one.  add() only copies, it never waits on the card.  If the card falls a whole buffer behind, records are
+ * dropped and counted rather than blocking odometry.  Each buffer is flushed after it's written, so losing power loses
+ * one buffer at most.
+ */
+class flight_recorder {
+ public:
+  /**
+   * Records per buffer.
+   */
+  static const int BUFFER = 64;
+
+  /**
+   * File format version.
+   */
+  static const uint32_t VERSION = 1;
+
+  flight_recorder();
+
+  /**
+   * Closes the file and waits for the writer task to end, so a recorder can be a local.  Detach the pipeline from it
+   * first.
+   */
+  ~flight_recorder();
+
+  flight_recorder(const flight_recorder&) = delete;
+  flight_recorder& operator=(const flight_recorder&) = delete;
+
+  /**
+   * Starts a new recording.  The header goes in with the first record.
+   *
+   * \param path
+   *        file to write, on the SD card that's "/usd/" then the name
+   *
+   * \return false if the file couldn't be opened, like with no SD card in
+   */
+  bool open(const char* path);
+
+  /**
+   * Writes whatever is buffered and closes the file.  Waits for the card, so don't call it from the control task.
+   */
+  void close();
+
+  /**
+   * Returns if a file is open.
+   */
+  bool recording();
+
+  /**
+   * Notes odometry's state before an update, so a move since the last update gets its own record.  Call before the
+   * update that add() records.
+   *
+   * \param odometry
+   *        odometry about to update, nullptr when it can't be replayed
+   */
+  void odometry_check(const wheel_odometry* odometry);
+
+  /**
+   * Records one odometry update.  Never blocks.
+   *
+   * \param sensors
+   *        what odometry read
+   * \param pose
+   *        what odometry made of it
+   * \param reads
+   *        device reads the tick before
+   * \param odometry
+   *        odometry that just updated, nullptr when it can't be replayed
+   */
+  void add(const drive_snapshot& sensors, const ez::pose& pose, uint32_t reads, const wheel_odometry* odometry);
+
+  /**
+   * Returns records written to the file so far.
+   */
+  uint32_t written_get();
+
+  /**
+   * Returns records dropped because the card fell behind.
+   */
+  uint32_t dropped_get();
+
+ private:
+  FILE* file = nullptr;
+  std::atomic<bool> is_open{false};
+  std::atomic<bool> closing{false};
+  std::atomic<bool> stopping{false};
+  bool started = false;         // the header has been filled in
+  bool header_written = false;  // by the writer
+  flight_header header;
+
+  std::array<flight_record, BUFFER> buffers[2];
+  int active = 0;
+  int fill = 0;
+  std::atomic<int> full{-1};  // buffer waiting for the writer, -1 for none
+
+  bool following = false;         // a FLIGHT_MOVED record has the state replay starts from
+  wheel_odometry_state expected;  // odometry's state after the last update
+  std::atomic<uint32_t> written{0};
+  std::atomic<uint32_t> dropped{0};
+
+  void push(const flight_record& record);
+  void write(const flight_record* records, int count);
+  void writer();
+
+  // Declared last so everything above exists before the task starts
+  pros::Task task;
+};
+}  // namespace control
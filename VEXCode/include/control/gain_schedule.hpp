@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include "EZ-Template/PID.hpp"
+
+namespace control {
+/**
+ * PID constants for one motion size and speed.
+ */
+struct gain_point {
+  double target;  // size of the motion, inches or degrees
+  double speed;   // max speed, 0 to 127
+  ez::PID::Constants constants;
+};
+
+/**
+ * PID constants that change with how big and how fast a motion is.
+ *
+ * Points with the same target make a row.  Constants are interpolated between the two rows around a motion's target,
+ * and inside each row between the two points around its speed.  Past the ends they hold the closest point.  Motions
+ * look up their constants once when they start, not every tick.
+ */
+class gain_schedule {
+ public:
+  /**
+   * Replaces every point.  An empty schedule leaves motions on their single set of constants.
+   *
+   * \param points
+   *        {{target, speed, {kp, ki, kd, start_i}}, ...} in any order
+   */
+  void set(std::vector<gain_point> points);
+
+  /**
+   * Returns true if there are no points.
+   */
+  bool empty() const;
+
+  /**
+   * Returns constants for a motion.
+   *
+   * \param target
+   *        size of the motion, the sign is ignored
+   * \param speed
+   *        max speed, 0 to 127
+   */
+  ez::PID::Constants get(double target, double speed) const;
+
+ private:
+  // Sorted by target, then speed
+  std::vector<gain_point> points;
+  ez::PID::Constants row_get(size_t first, size_t last, double speed) const;
+};
+}  // namespace control
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace control {
+class histogram {
+ public:
+  /**
+   * Amount of bins.
+   */
+  static const int BINS = 64;
+
+  /**
+   * Creates a histogram of microsecond samples.
+   *
+   * \param bin_width
+   *        width of each bin in microseconds.  Samples past the last bin are counted in overflow
+   */
+  histogram(int bin_width = 500);
+
+  /**
+   * Clears every sample.
+   */
+  void reset();
+
+  /**
+   * Adds a sample.
+   *
+   * \param us
+   *        sample in microseconds
+   */
+  void add(uint32_t us);
+
+  /**
+   * Returns the amount of samples.
+   */
+  uint32_t count_get();
+
+  /**
+   * Returns the average sample in microseconds.
+   */
+  double mean_get();
+
+  /**
+   * Returns the smallest sample in microseconds.
+   */
+  uint32_t min_get();
+
+  /**
+   * Returns the largest sample in microseconds.
+   */
+  uint32_t max_get();
+
+  /**
+   * Returns an approximate percentile in microseconds.  This is the top of the bin the percentile lands in, or the
+   * largest sample when it lands past the last bin.
+   *
+   * \param percent
+   *        0.0 to 1.0
+   */
+  uint32_t percentile_get(double percent);
+
+  /**
+   * Returns the width of each bin in microseconds.
+   */
+  int bin_width_get();
+
+  /**
+   * Prints a one line summary and every non-empty bin to the terminal.
+   *
+   * \param name
+   *        name of the histogram that prints
+   */
+  void print(const char* name);
+
+  /**
+   * Bin n counts samples in [n * bin_width, (n + 1) * bin_width).
+   */
+  std::array<uint32_t, BINS> bins;
+
+  /**
+   * Counts samples at or past BINS * bin_width, which no bin holds.
+   */
+  uint32_t overflow;
+
+ private:
+  int bin_width;
+  uint32_t count = 0;
+  uint64_t sum = 0;
+  uint32_t min = UINT32_MAX;
+  uint32_t max = 0;
+};
+}  // namespace control
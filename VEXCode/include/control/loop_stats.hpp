@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+
+#include "control/histogram.hpp"
+
+namespace control {
+class loop_stats {
+ public:
+  /**
+   * Creates timing statistics for a loop.
+   *
+   * \param target_period
+   *        the period the loop is meant to run at in ms
+   */
+  loop_stats(int target_period = 10);
+
+  /**
+   * Clears every sample.  This does not reset the target period.
+   */
+  void reset();
+
+  /**
+   * Adds a measured period, the time between the start of two consecutive iterations.
+   *
+   * \param us
+   *        period in microseconds
+   */
+  void period_add(uint32_t us);
+
+  /**
+   * Adds a measured execution time, the time the loop body took to run.
+   *
+   * \param us
+   *        execution time in microseconds
+   */
+  void exec_add(uint32_t us);
+
+  /**
+   * Counts an iteration that took longer than the target period.
+   */
+  void overrun_add();
+
+  /**
+   * Sets the period the loop is meant to run at.
+   *
+   * \param ms
+   *        period in ms
+   */
+  void target_period_set(int ms);
+
+  /**
+   * Returns the period the loop is meant to run at in ms.
+   */
+  int target_period_get();
+
+  /**
+   * Returns the average distance between the measured and target period in microseconds.
+   */
+  double jitter_mean_get();
+
+  /**
+   * Returns the amount of iterations that took longer than the target period.
+   */
+  uint32_t overruns_get();
+
+  /**
+   * Measured periods, the time between the start of two consecutive iterations.
+   */
+  histogram period;
+
+  /**
+   * Measured execution times, the time the loop body took to run.
+   */
+  histogram exec;
+
+  /**
+   * Prints a summary and both histograms to the terminal.
+   *
+   * \param name
+   *        name of the loop that prints
+   */
+  void print(const char* name);
+
+ private:
+  int target_period = 10;
+  uint64_t jitter_sum = 0;
+  uint32_t overruns = 0;
+};
+}  // namespace control
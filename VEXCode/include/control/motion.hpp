@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "EZ-Template/PID.hpp"
+#include "EZ-Template/slew.hpp"
+#include "EZ-Template/util.hpp"
+#include "control/drive_snapshot.hpp"
+#include "control/gain_schedule.hpp"
+#include "control/pid.hpp"
+#include "control/profile.hpp"
+#include "control/settle.hpp"
+#include "control/slew.hpp"
+
+namespace control {
+/**
+ * Everything a motion needs for one tick.  The pipeline fills this once per tick, after odometry has run.
+ */
+struct drive_state : drive_snapshot {
+  ez::pose pose;
+};
+
+/**
+ * Output of a motion, -127 to 127 for each side.
+ */
+struct drive_output {
+  double left = 0.0;
+  double right = 0.0;
+};
+
+/**
+ * Tuned constants for every motion.  Motions copy what they need when they're created.
+ */
+struct motion_constants {
+  ez::PID drive;
+  ez::PID heading;
+  ez::PID turn;
+  ez::PID odom_xy;
+  ez::PID odom_angular;
+  ez::PID boomerang;
+  ez::slew slew_drive;
+  ez::slew slew_turn;
+  // Time-based slew, used instead of slew_drive and slew_turn when it has an acceleration limit
+  slew_limits slew_drive_limits;
+  slew_limits slew_turn_limits;
+  double turn_bias = 0.9;
+  double look_ahead = 7.0;
+  double spacing = 0.5;
+  double dlead = 0.625;
+  double boomerang_distance = 16.0;
+  double smooth_weight_smooth = 0.75;
+  double smooth_weight_data = 0.03;
+  double smooth_tolerance = 0.0001;
+
+  // Profiled drives, inches.  The tracking PID only corrects error from the profile, its D damps that error.  A jerk
+  // limit makes an S-curve, smoother but slower than PID and slew in motion_bench, so the default is a trapezoid
+  profile_constraints drive_limits = {62.0, 400.0, 0.0};
+  feedforward drive_feedforward = {0.2, 0.19, 0.02};
+  ez::PID drive_tracking = ez::PID(60.0, 0.0, 150.0);
+
+  // Profiled turns, degrees.  turn_rate_kp corrects the gyro rate against the profile's velocity
+  profile_constraints turn_limits = {540.0, 3500.0, 0.0};
+  feedforward turn_feedforward = {0.9, 0.0197, 0.0016};
+  ez::PID turn_tracking = ez::PID(8.0, 0.0, 0.0);
+  double turn_rate_kp = 0.4;
+
+  // Predictive settling for every motion, off by default
+  settle_constants settle;
+
+  // Derivative mode and filter for every motion's PIDs, unfiltered on the measurement by default
+  derivative_constants derivative;
+
+  // ms between ticks, for the derivative filters and exit timers.  The pipeline sets this to its period at enable()
+  int period = ez::util::DELAY_TIME;
+
+  // Drive and turn constants by motion size and speed.  Empty uses drive and turn as they are
+  gain_schedule drive_schedule;
+  gain_schedule turn_schedule;
+};
+
+class motion {
+ public:
+  virtual ~motion() = default;
+
+  /**
+   * Does the slow part of setting up before the motion starts.  The motion queue runs this on a background task while the motion before it is still running.
+   *
+   * \param start
+   *        where the robot is expected to be when this motion starts
+   */
+  virtual void prepare(const ez::pose& start) {}
+
+  /**
+   * Returns where the robot should be once this motion is done.  The motion queue uses this as the start of the next motion.
+   *
+   * \param start
+   *        where the robot is when this motion starts
+   */
+  virtual ez::pose end_get(const ez::pose& start) = 0;
+
+  /**
+   * Runs once on the tick the motion takes over, with the state at that moment.  This should be quick when prepare() already ran.
+   *
+   * \param state
+   *        current drive state
+   */
+  virtual void initialize(const drive_state& state) = 0;
+
+  /**
+   * Runs every tick and returns what the drive should be set to.
+   *
+   * This keeps running after the motion exits so the robot holds its position until the next motion.
+   *
+   * \param state
+   *        current drive state, with this tick's pose
+   */
+  virtual drive_output iterate(const drive_state& state) = 0;
+
+  /**
+   * Returns RUNNING until the motion has settled, then how it exited.
+   */
+  virtual ez::exit_output exit_condition() = 0;
+
+  /**
+   * Returns the last point index the robot has passed.  Motions without points return -1.
+   */
+  virtual int index_get() { return -1; }
+
+  /**
+   * Returns ms predictive settling saved over the exit timers, 0 when the timers exited the motion.
+   */
+  virtual int saved_get() { return 0; }
+
+  /**
+   * Returns the name of the motion that prints.
+   */
+  virtual const char* name_get() = 0;
+};
+}  // namespace control
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <vector>
+
+#include "control/motion.hpp"
+
+namespace control {
+/**
+ * Drives forward or backward, holding a heading with the IMU.
+ */
+class drive_motion : public motion {
+ public:
+  /**
+   * \param constants
+   *        tuned constants
+   * \param target
+   *        distance to travel in inches, negative drives backward
+   * \param speed
+   *        max speed, 0 to 127
+   * \param slew_on
+   *        ramp up from the slew min speed
+   * \param heading
+   *        heading to hold in degrees
+   */
+  drive_motion(const motion_constants& constants, double target, int speed, bool slew_on, double heading);
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  ez::exit_output exit_condition() override;
+  int saved_get() override;
+  const char* name_get() override;
+
+ private:
+  motion_pid drivePID;
+  motion_pid headingPID;
+  slew_limiter slew;
+  double target;
+  int speed;
+  bool slew_on;
+  double heading;
+  settle_predictor settle;
+  ez::exit_output exit = ez::RUNNING;
+};
+
+/**
+ * Drives forward or backward along a motion profile, holding a heading with the IMU.
+ *
+ * Feedforward does most of the work, the tracking PID only corrects error from the profile.  Once the profile ends
+ * the drive PID's exit conditions decide when the motion is done.
+ */
+class profiled_drive_motion : public motion {
+ public:
+  /**
+   * \param constants
+   *        tuned constants
+   * \param target
+   *        distance to travel in inches, negative drives backward
+   * \param speed
+   *        0 to 127, scales the profile's max velocity
+   * \param heading
+   *        heading to hold in degrees
+   */
+  profiled_drive_motion(const motion_constants& constants, double target, int speed, double heading);
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  ez::exit_output exit_condition() override;
+  int saved_get() override;
+  const char* name_get() override;
+
+ private:
+  motion_pid drivePID;
+  motion_pid trackingPID;
+  motion_pid headingPID;
+  feedforward ff;
+  motion_profile profile;
+  double target;
+  double heading;
+  double start = 0.0;
+  uint64_t start_time = 0;
+  settle_predictor settle;
+  ez::exit_output exit = ez::RUNNING;
+};
+
+/**
+ * Turns in place to an absolute heading.
+ */
+class turn_motion : public motion {
+ public:
+  /**
+   * \param constants
+   *        tuned constants
+   * \param target
+   *        absolute heading in degrees
+   * \param speed
+   *        max speed, 0 to 127
+   * \param behavior
+   *        which way to turn to get to target
+   * \param slew_on
+   *        ramp up from the slew min speed
+   */
+  turn_motion(const motion_constants& constants, double target, int speed, ez::e_angle_behavior behavior, bool slew_on);
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  ez::exit_output exit_condition() override;
+  int saved_get() override;
+  const char* name_get() override;
+
+ private:
+  motion_pid turnPID;
+  slew_limiter slew;
+  double target;
+  int speed;
+  ez::e_angle_behavior behavior;
+  bool slew_on;
+  gain_schedule schedule;
+  settle_predictor settle;
+  ez::exit_output exit = ez::RUNNING;
+};
+
+/**
+ * Turns in place to an absolute heading along a motion profile.
+ *
+ * Feedforward drives the planned angular velocity and acceleration, the gyro rate is held to the profile's velocity, and
+ * the tracking PID corrects the heading.  Once the profile ends the turn PID's exit conditions decide when it's done.
+ */
+class profiled_turn_motion : public motion {
+ public:
+  /**
+   * \param constants
+   *        tuned constants
+   * \param target
+   *        absolute heading in degrees
+   * \param speed
+   *        0 to 127, scales the profile's max velocity
+   * \param behavior
+   *        which way to turn to get to target
+   */
+  profiled_turn_motion(const motion_constants& constants, double target, int speed, ez::e_angle_behavior behavior);
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  ez::exit_output exit_condition() override;
+  int saved_get() override;
+  const char* name_get() override;
+
+ private:
+  motion_pid turnPID;
+  motion_pid trackingPID;
+  feedforward ff;
+  profile_constraints limits;
+  double rate_kp;
+  motion_profile profile;
+  double target;
+  ez::e_angle_behavior behavior;
+  double start = 0.0;
+  uint64_t start_time = 0;
+  settle_predictor settle;
+  ez::exit_output exit = ez::RUNNING;
+};
+
+/**
+ * Shared point to point controller for every odom motion.
+ */
+class odom_motion : public motion {
+ public:
+  ez::exit_output exit_condition() override;
+  int saved_get() override;
+
+ protected:
+  odom_motion(const motion_constants& constants, const ez::PID& angular, bool slew_on);
+
+  /**
+   * Drives towards a point, turning to face it while driving.
+   *
+   * \param state
+   *        current drive state
+   * \param target
+   *        point to drive to
+   * \param dir
+   *        fwd or rev
+   * \param speed
+   *        max speed, 0 to 127
+   * \param final
+   *        true when this is the last point, this is when exit conditions run
+   * \param heading
+   *        heading to hold once the robot is close to target, ez::ANGLE_NOT_SET holds the current heading
+   */
+  drive_output ptp_output(const drive_state& state, ez::pose target, ez::drive_directions dir, int speed, bool final, double heading = ez::ANGLE_NOT_SET);
+
+  /**
+   * Starts slew for a motion that travels distance.
+   */
+  void slew_initialize(int speed, double distance);
+
+  motion_pid xyPID;
+  motion_pid angularPID;
+  slew_limiter slew;
+  double turn_bias;
+  bool slew_on;
+  ez::pose start = {0.0, 0.0, 0.0};
+  settle_predictor settle;
+  ez::exit_output exit = ez::RUNNING;
+
+ private:
+  double locked_heading = ez::ANGLE_NOT_SET;
+  bool started = false;
+};
+
+/**
+ * Drives to a point, facing the point the whole way.
+ */
+class point_motion : public odom_motion {
+ public:
+  point_motion(const motion_constants& constants, ez::odom imovement, bool slew_on);
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  const char* name_get() override;
+
+ private:
+  ez::odom movement;
+};
+
+/**
+ * Drives to a point and ends at an angle by chasing a carrot point behind the target.
+ */
+class boomerang_motion : public odom_motion {
+ public:
+  boomerang_motion(const motion_constants& constants, ez::odom imovement, bool slew_on);
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  const char* name_get() override;
+
+ private:
+  ez::odom movement;
+  double dlead;
+  double max_carrot;
+};
+
+/**
+ * Follows a path through every point with pure pursuit.
+ */
+class pursuit_motion : public odom_motion {
+ public:
+  pursuit_motion(const motion_constants& constants, std::vector<ez::odom> imovements, bool slew_on);
+  void prepare(const ez::pose& start) override;
+  ez::pose end_get(const ez::pose& start) override;
+  void initialize(const drive_state& state) override;
+  drive_output iterate(const drive_state& state) override;
+  int index_get() override;
+  const char* name_get() override;
+
+ private:
+  std::vector<ez::odom> movements;
+  std::vector<ez::odom> path;
+  std::vector<int> injected_index;
+  motion_constants path_constants;
+  ez::pose prepared_start = {0.0, 0.0, 0.0};
+  bool prepared = false;
+  int look_index = 0;
+  int closest_index = 0;
+  int passed_index = -1;
+};
+
+/**
+ * Returns a path with points injected every spacing inches.  Every injected point takes the speed and direction of the point it leads to.
+ *
+ * \param imovements
+ *        points on the path, including the start
+ * \param spacing
+ *        distance between injected points
+ * \param injected_index
+ *        filled with the index each input point ends up at
+ */
+std::vector<ez::odom> path_inject(const std::vector<ez::odom>& imovements, double spacing, std::vector<int>* injected_index = nullptr);
+
+/**
+ * Returns a smoothed copy of a path.  The first and last points never move.
+ *
+ * \param ipath
+ *        injected path
+ * \param weight_smooth
+ *        how much points are pulled towards their neighbors
+ * \param weight_data
+ *        how much points are pulled towards where they started
+ * \param tolerance
+ *        smoothing stops once a pass moves every point less than this in total
+ */
+std::vector<ez::odom> path_smooth(const std::vector<ez::odom>& ipath, double weight_smooth, double weight_data, double tolerance);
+
+/**
+ * Returns the heading to turn to for a turn behavior.
+ *
+ * \param target
+ *        target in degrees
+ * \param current
+ *        current heading in degrees
+ * \param behavior
+ *        which way to turn
+ */
+double turn_target_get(double target, double current, ez::e_angle_behavior behavior);
+}  // namespace control
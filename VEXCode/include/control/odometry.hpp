@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cmath>
+
+#include "EZ-Template/util.hpp"
+#include "control/drive_snapshot.hpp"
+
+namespace control {
+/**
+ * How odometry turns one update's motion into a new pose.
+ */
+enum odom_integrator {
+  ODOM_EULER,        // straight along the heading the update started at
+  ODOM_MIDPOINT,     // straight along the average heading of the update
+  ODOM_EXPONENTIAL,  // along the arc, the SE(2) exponential map.  Exact while speed and turn rate hold over the update
+  ODOM_EXPONENTIAL_ACCEL,  // the exponential map, with the heading bent by the change in turn rate since the last update
+};
+
+/**
+ * A pose for odometry to integrate, in float or double.
+ *
+ * \tparam T
+ *         float or double
+ */
+template <typename T>
+struct odom_pose {
+  T x = 0;      // in
+  T y = 0;      // in
+  T theta = 0;  // deg, 0 is +y and clockwise is positive
+};
+
+/**
+ * Returns sin(a) / a, without dividing by 0.
+ */
+template <typename T>
+T odom_sinc(T a) {
+  // Under this the series is exact to a double, and dividing would lose bits
+  if (std::fabs(a) < T(1e-2)) return T(1) - a * a / T(6) + a * a * a * a / T(120);
+  return std::sin(a) / a;
+}
+
+/**
+ * Returns how far the center of the robot rolled forward, from a wheel parallel to the drive.
+ *
+ * \param travel
+ *        in the wheel rolled this update
+ * \param offset
+ *        in the wheel is right of the center of rotation, negative for the left
+ * \param turn
+ *        deg the robot turned this update
+ */
+template <typename T>
+T odom_forward(T travel, T offset, T turn) {
+  return travel + offset * turn * T(M_PI / 180.0);
+}
+
+/**
+ * Returns how far the center of the robot slid right, from a wheel perpendicular to the drive.
+ *
+ * \param travel
+ *        in the wheel rolled this update, right positive
+ * \param offset
+ *        in the wheel is forward of the center of rotation, negative for behind
+ * \param turn
+ *        deg the robot turned this update
+ */
+template <typename T>
+T odom_sideways(T travel, T offset, T turn) {
+  return travel - offset * turn * T(M_PI / 180.0);
+}
+
+/**
+ * Moves a pose by one update of motion.
+ *
+ * Forward and right are how far the center rolled in the robot's own frame, so along the arc when the robot turns.  The
+ * exponential map moves along the average heading like the midpoint does, but by the chord of the arc, sinc(turn / 2)
+ * of its length.  Midpoint is off by the square of the turn each update, which adds up on fast swings and long updates.
+ *
+ * When the turn rate changes during the update, the heading spends longer near where it started than the arc assumes.
+ * ODOM_EXPONENTIAL_ACCEL fits a parabola through this turn and the last one and moves along its average heading, which
+ * is (turn - last_turn) / 12 behind the middle.  On a robot swinging back and forth this error doesn't cancel out.
+ *
+ * \param pose
+ *        pose to move
+ * \param right
+ *        in the center slid right
+ * \param forward
+ *        in the center rolled forward
+ * \param turn
+ *        deg the robot turned, clockwise positive
+ * \param integrator
+ *        how to integrate
+ * \param last_turn
+ *        deg the robot turned the update before, only ODOM_EXPONENTIAL_ACCEL uses it
+ */
+template <typename T>
+void odom_integrate(odom_pose<T>& pose, T right, T forward, T turn, odom_integrator integrator, T last_turn = 0) {
+  T turn_rad = turn * T(M_PI / 180.0);
+  T heading = pose.theta * T(M_PI / 180.0);
+  T scale = 1;
+  if (integrator != ODOM_EULER) heading += turn_rad / T(2);
+  if (integrator == ODOM_EXPONENTIAL_ACCEL) heading -= (turn - last_turn) * T(M_PI / 180.0) / T(12);
+  if (integrator == ODOM_EXPONENTIAL || integrator == ODOM_EXPONENTIAL_ACCEL) scale = odom_sinc(turn_rad / T(2));
+  T s = std::sin(heading), c = std::cos(heading);
+  pose.x += scale * (forward * s + right * c);
+  pose.y += scale * (forward * c - right * s);
+  pose.theta += turn;
+}
+/**
+ * Where the wheels odometry reads are on the robot.
+ */
+struct odom_wheels {
+  double left = 0.0;   // in the left wheel is right of center, so negative.  0 on both sides when they're equally far out
+  double right = 0.0;  // in the right wheel is right of center
+  double front = 0.0;  // in the front horizontal tracker is forward of center
+  double back = 0.0;   // in the back horizontal tracker is forward of center, so negative
+  bool front_used = false;
+  bool back_used = false;
+};
+
+/**
+ * Everything wheel_odometry carries from one update to the next.
+ */
+struct wheel_odometry_state {
+  odom_pose<double> pose;
+  double heading_offset = 0.0;  // deg from the IMU to the pose's heading
+  double last_turn = 0.0;       // deg turned in the last update
+  // Sensors at the last update
+  double left = 0.0;
+  double right = 0.0;
+  double imu = 0.0;
+  double front = 0.0;
+  double back = 0.0;
+};
+
+/**
+ * Odometry from the drive sensors in a snapshot, two vertical wheels, up to two horizontal trackers and the IMU.
+ *
+ * Each update only reads the snapshot and its own state, so recorded snapshots replay through it to the same bits.
+ * Heading comes from the IMU, not from adding up turns.
+ */
+class wheel_odometry {
+ public:
+  /**
+   * \param wheels
+   *        where the wheels are
+   * \param integrator
+   *        how each update integrates
+   */
+  wheel_odometry(const odom_wheels& wheels = {}, odom_integrator integrator = ODOM_MIDPOINT);
+
+  /**
+   * Sets where the wheels are.
+   */
+  void wheels_set(const odom_wheels& wheels);
+
+  /**
+   * Returns where the wheels are.
+   */
+  odom_wheels wheels_get() const;
+
+  /**
+   * Sets how each update integrates.
+   */
+  void integrator_set(odom_integrator integrator);
+
+  /**
+   * Returns how each update integrates.
+   */
+  odom_integrator integrator_get() const;
+
+  /**
+   * Starts over at a pose, with the sensors reading what they read there.
+   *
+   * \param pose
+   *        {x, y, theta} in inches and degrees
+   * \param sensors
+   *        sensors at that pose.  The IMU's difference from theta is kept, so later headings follow the IMU from there
+   */
+  void reset(const ez::pose& pose, const drive_snapshot& sensors);
+
+  /**
+   * Moves by the sensors' change since the last update and returns the new pose.
+   *
+   * \param sensors
+   *        this update's snapshot
+   */
+  ez::pose update(const drive_snapshot& sensors);
+
+  /**
+   * Returns the current pose.
+   */
+  ez::pose pose_get() const;
+
+  /**
+   * Returns everything the next update depends on.
+   */
+  wheel_odometry_state state_get() const;
+
+  /**
+   * Carries on from a state from state_get().
+   */
+  void state_set(const wheel_odometry_state& state);
+
+ private:
+  odom_wheels wheels;
+  odom_integrator integrator;
+  wheel_odometry_state state;
+};
+}  // namespace control
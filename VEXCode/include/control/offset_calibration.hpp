@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+#include "control/drive_backend.hpp"
+#include "control/drive_snapshot.hpp"
+
+namespace control {
+/**
+ * One tracking wheel's fit.
+ */
+struct offset_fit {
+  bool used = false;      // the tracker read something other than 0
+  double offset = 0.0;    // in the tracker rolls per radian of clockwise turn, what distance_to_center_set() takes
+  double std_error = 0.0; // in, 1 standard deviation of offset, treating samples as independent
+  double residual = 0.0;  // in, RMS of what turning doesn't explain.  Big when the robot slid or the wheel slipped
+};
+
+/**
+ * Every tracker's fit from one set of samples.
+ */
+struct offset_calibration_result {
+  bool solved = false;  // enough samples and turning to fit
+  int samples = 0;
+  double turned = 0.0;   // deg turned either way, added up
+  double latency = 0.0;  // ms the IMU's heading lags the trackers
+  offset_fit left;
+  offset_fit right;
+  offset_fit front;
+  offset_fit back;
+};
+
+/**
+ * Finds how far each tracking wheel is from the turning center, all at once, by least squares over samples taken while
+ * the robot turns.
+ *
+ * Each tracker's distance is fit as a line in the IMU's heading, offset * heading, plus a term in the IMU's rate that
+ * soaks up the IMU reading a little behind the trackers.  Every sample goes in, so noise on any one heading reading
+ * averages out, and the turns don't need to stop on any angle.  Only running sums are kept, so samples can come from a
+ * live robot or a recording of any length.  Turn in both directions at a couple of different speeds so the heading and
+ * rate terms can be told apart.
+ */
+class offset_calibration {
+ public:
+  /**
+   * Least turning a fit needs, in deg.  Less than this and heading noise is too big a part of it.
+   */
+  static constexpr double TURN_MIN = 90.0;
+
+  /**
+   * Forgets every sample.
+   */
+  void clear();
+
+  /**
+   * Adds one sample.  Tracker distances and the IMU have to keep counting from the first sample, don't reset them
+   * partway.
+   *
+   * \param sensors
+   *        trackers in inches, IMU heading and rate, as the backend captures them
+   */
+  void add(const drive_snapshot& sensors);
+
+  /**
+   * Returns the amount of samples added.
+   */
+  int samples_get() const;
+
+  /**
+   * Fits every tracker that read something.
+   */
+  offset_calibration_result solve() const;
+
+  /**
+   * Fits and prints each tracker's offset, its uncertainty and what's left over.
+   */
+  void print() const;
+
+ private:
+  // Sums of each term, relative to the first sample so they stay small
+  struct sums {
+    double d = 0.0;   // tracker distance
+    double dd = 0.0;  // distance squared
+    double td = 0.0;  // heading * distance
+    double rd = 0.0;  // rate * distance
+    bool used = false;
+  };
+
+  int n = 0;
+  drive_snapshot first;
+  double last_imu = 0.0;
+  double turned = 0.0;  // deg
+  double t = 0.0;       // heading, rad
+  double r = 0.0;       // rate, rad/s
+  double tt = 0.0;
+  double tr = 0.0;
+  double rr = 0.0;
+  sums trackers[4];  // left, right, front, back
+
+  offset_fit fit(const sums& s) const;
+};
+
+/**
+ * Spins the robot in place one way then the other at a couple of speeds, adding a sample every 10 ms.  Takes about 3
+ * seconds.  Call with the pipeline disabled, the backend is enabled for the spin so EZ-Template's task lets go of the
+ * motors.
+ *
+ * \param backend
+ *        drive to spin, whose capture() reads the trackers
+ * \param calibration
+ *        where samples go, cleared first
+ * \param speed
+ *        fastest spin, out of 127
+ *
+ * \return the fit, solved is false if the robot didn't turn enough
+ */
+offset_calibration_result offsets_measure(drive_backend& backend, offset_calibration& calibration, int speed = 90);
+}  // namespace control
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "api.h"
+#include "control/drive_backend.hpp"
+#include "control/pose_ekf.hpp"
+
+namespace control {
+class pipeline;
+
+/**
+ * How much the particle filter trusts each sensor, as 1 standard deviation.
+ */
+struct particle_constants {
+  double tracker = 0.02;            // in of error per inch odometry moves
+  double heading = 0.01;            // deg of error per deg odometry turns
+  double jitter = 0.05;             // in every particle wanders each prediction, so they stay apart while the robot is still
+  double jitter_heading = 0.1;      // deg every particle wanders each prediction
+  double distance_floor = 0.6;      // in, the distance sensor's error up close
+  double distance_fraction = 0.05;  // of the range, the distance sensor's error past 200 mm
+  double outlier = 3.0;             // standard deviations, a reading further off than this counts as blocked
+  field_walls field;
+};
+
+/**
+ * Monte Carlo localization off the field walls with distance sensors.
+ *
+ * Each particle is a guess at the pose.  Odometry moves every particle with some noise, then each distance reading
+ * weighs the particles by how well the range to the nearest wall from that particle matches.  Particles that don't match
+ * get resampled away.  Unlike pose_ekf this holds several guesses at once, so it can find the pose from a few inches
+ * and degrees off, where a wall reading alone could match more than one place.
+ *
+ * Particles are stored as separate arrays of x, y, heading and weight, and the range to the walls is worked out four
+ * particles at a time with GCC vector types, NEON on the brain.  Headings are kept as a sine and cosine so nothing per
+ * particle needs a trig call.  Fixed size, nothing allocates after construction.
+ */
+class particle_filter {
+ public:
+  /**
+   * Most particles the filter can hold.
+   */
+  static const int CAPACITY = 512;
+
+  /**
+   * Most distance sensors one update can use.
+   */
+  static const int SENSORS = 4;
+
+  /**
+   * \param count
+   *        amount of particles, rounded up to a multiple of 4 and capped at CAPACITY
+   * \param constants
+   *        sensor noise and field walls
+   * \param seed
+   *        seed for the particle noise
+   */
+  particle_filter(int count = 300, const particle_constants& constants = {}, uint32_t seed = 1);
+
+  /**
+   * Sets sensor noise and field walls.
+   */
+  void constants_set(const particle_constants& constants);
+
+  /**
+   * Returns sensor noise and field walls.
+   */
+  particle_constants constants_get();
+
+  /**
+   * Returns the amount of particles.
+   */
+  int count_get();
+
+  /**
+   * Scatters the particles around a pose with equal weights.
+   *
+   * \param pose
+   *        {x, y, theta} in inches and degrees, usually odometry's pose
+   * \param position_std
+   *        in, how far odometry could be off
+   * \param heading_std
+   *        deg, how far odometry's heading could be off
+   */
+  void reset(const ez::pose& pose, double position_std, double heading_std);
+
+  /**
+   * Moves every particle by odometry's motion, plus noise.
+   *
+   * \param motion
+   *        {right, forward, turn} in inches and degrees, relative to where the robot was before moving
+   */
+  void predict(const ez::pose& motion);
+
+  /**
+   * Weighs the particles by distance readings taken at the same time, then resamples once too few particles carry the
+   * weight.
+   *
+   * \param mounts
+   *        where each sensor is on the robot
+   * \param ranges
+   *        in, what each sensor read.  0 or less skips that sensor
+   * \param count
+   *        amount of sensors, up to SENSORS
+   */
+  void update(const distance_mount* mounts, const double* ranges, int count);
+
+  /**
+   * Returns the weighted average pose, {x, y, theta} in inches and degrees.
+   */
+  ez::pose estimate_get();
+
+  /**
+   * Returns how spread out the particles are in inches, their weighted standard deviation from the average.
+   */
+  double spread_get();
+
+  /**
+   * Returns how far readings are from what a sensor at the average pose would read, RMS in standard deviations of each
+   * reading's noise.  Particles can bunch up on a pose the readings don't fit, this catches that.
+   *
+   * \param mounts
+   *        where each sensor is on the robot
+   * \param ranges
+   *        in, what each sensor read.  0 or less skips that sensor
+   * \param count
+   *        amount of sensors, up to SENSORS
+   *
+   * \return 0 if no sensor read anything
+   */
+  double residual_get(const distance_mount* mounts, const double* ranges, int count);
+
+  /**
+   * Returns the standard deviation of a reading, in inches.
+   *
+   * \param range
+   *        in, what the sensor read
+   */
+  double noise_get(double range);
+
+ private:
+  particle_constants constants;
+  int count;
+  uint32_t random_state;
+
+  // Structure of arrays, one set being read while resampling writes the other
+  struct particles {
+    alignas(16) std::array<float, CAPACITY> x;
+    alignas(16) std::array<float, CAPACITY> y;
+    alignas(16) std::array<float, CAPACITY> sin;  // of the heading
+    alignas(16) std::array<float, CAPACITY> cos;
+    alignas(16) std::array<float, CAPACITY> weight;
+  };
+  particles sets[2];
+  int current = 0;
+
+  // Squared error of every reading so far this update, in standard deviations
+  alignas(16) std::array<float, CAPACITY> error;
+
+  float uniform();
+  float gaussian();
+  void resample();
+};
+
+/**
+ * A distance sensor for relocalize().
+ */
+struct wall_sensor {
+  pros::Distance* sensor;
+  distance_mount mount;
+};
+
+/**
+ * Finds the pose off the field walls with distance sensors and moves odometry there.  Meant for when the robot is
+ * sitting against something, like after the wiggles in a match load, where odometry has drifted but the walls are in
+ * view.  Blocks until the pose is found or the timeout.
+ *
+ * The pose counts as found once the particles agree to within converged, there have been enough readings for the
+ * sensors' noise to average down under converged, and the latest readings fit the pose.  The move goes through
+ * pipeline::odom_pose_set(), so it's safe whether or not the pipeline is running.  Sensors that aren't plugged in are
+ * skipped, with none it returns false right away.
+ *
+ * \param drive
+ *        pipeline whose odometry gets moved, enabled or not
+ * \param filter
+ *        particle filter with the field walls set
+ * \param sensors
+ *        1 to particle_filter::SENSORS distance sensors
+ * \param position_std
+ *        in, how far odometry could be off
+ * \param heading_std
+ *        deg, how far odometry's heading could be off
+ * \param timeout
+ *        ms to give up after, leaving odometry alone.  sim/localizer times the default
+ * \param converged
+ *        in, how close the pose has to be
+ *
+ * \return true if odometry was moved
+ */
+bool relocalize(pipeline& drive, particle_filter& filter, const std::vector<wall_sensor>& sensors, double position_std = 3.0,
+                double heading_std = 5.0, int timeout = 2000, double converged = 1.0);
+}  // namespace control
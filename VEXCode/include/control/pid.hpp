@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+
+#include "EZ-Template/PID.hpp"
+#include "EZ-Template/util.hpp"
+#include "pros/motors.hpp"
+
+namespace control {
+/**
+ * Options for pid, fixed at compile time so the ones that are off cost nothing.
+ */
+enum pid_option : unsigned {
+  PID_I_RESET = 1 << 0,             // the integral resets when the error changes sign
+  PID_VELOCITY_SECONDARY = 1 << 1,  // the velocity exit also waits on velocity_secondary_set()
+};
+
+/**
+ * Low-pass filters for the derivative term.
+ */
+enum derivative_filter {
+  DERIVATIVE_UNFILTERED,    // the raw difference each tick, like ez::PID
+  DERIVATIVE_FIRST_ORDER,   // single pole, -20 dB per decade past the cutoff
+  DERIVATIVE_BIQUAD,        // second order Butterworth, -40 dB per decade past the cutoff
+};
+
+/**
+ * How pid takes its derivative.  The defaults match ez::PID.
+ */
+struct derivative_constants {
+  bool on_error = false;  // differentiate the error instead of the measurement, so target changes kick the output
+  derivative_filter filter = DERIVATIVE_UNFILTERED;
+  double cutoff = 10.0;  // Hz, has to be under half the tick rate
+};
+
+/**
+ * PID with the same math and exit conditions as ez::PID, for motions that run every tick.
+ *
+ * ez::PID keeps a name string for printing and takes its exit motors as a vector by value, so copying it or checking
+ * its motors allocates.  This has no strings or heap use, and its exit check reads motors through a span.  Tuning comes
+ * from an ez::PID, so the constants set on ez::Drive still apply.
+ *
+ * \tparam options
+ *         pid_option flags or'd together
+ */
+template <unsigned options = PID_I_RESET>
+class pid {
+ public:
+  pid() = default;
+
+  /**
+   * Copies constants, exit conditions and velocity thresholds from an ez::PID.
+   *
+   * \param from
+   *        tuned ez::PID
+   */
+  explicit pid(const ez::PID& from) {
+    // ez::PID's getters aren't const
+    ez::PID& tuned = const_cast<ez::PID&>(from);
+    ez::PID::Constants c = tuned.constants_get();
+    constants_set(c.kp, c.ki, c.kd, c.start_i);
+    exit = from.exit;
+    velocity_zero_main = tuned.velocity_sensor_main_exit_get();
+    velocity_zero_secondary = tuned.velocity_sensor_secondary_exit_get();
+  }
+
+  /**
+   * Copies an ez::PID, then sets how the derivative is taken.
+   *
+   * \param from
+   *        tuned ez::PID
+   * \param d
+   *        derivative mode and filter
+   */
+  pid(const ez::PID& from, const derivative_constants& d) : pid(from) { derivative_set(d); }
+
+  /**
+   * Copies an ez::PID, then sets how often it runs and how the derivative is taken.
+   *
+   * \param from
+   *        tuned ez::PID
+   * \param d
+   *        derivative mode and filter
+   * \param ms
+   *        ms between compute() calls
+   */
+  pid(const ez::PID& from, const derivative_constants& d, int ms) : pid(from) {
+    period = ms;
+    derivative_set(d);
+  }
+
+  /**
+   * Sets the constants.
+   *
+   * \param p
+   *        proportional term
+   * \param i
+   *        integral term
+   * \param d
+   *        derivative term
+   * \param start_i
+   *        error value that i starts within
+   */
+  void constants_set(double p, double i = 0, double d = 0, double start_i = 0) { constants = {p, i, d, start_i}; }
+
+  /**
+   * Sets how often compute() and the exit conditions run.  The derivative filter is designed for this rate and the
+   * exit timers count this much each call.
+   *
+   * \param ms
+   *        ms between calls, ez::util::DELAY_TIME by default
+   */
+  void period_set(int ms) {
+    period = ms;
+    derivative_set({on_error, filter, cutoff});
+  }
+
+  /**
+   * Returns ms between calls.
+   */
+  int period_get() const { return period; }
+
+  /**
+   * Sets how the derivative is taken.  The filtered derivative drives both the output and the velocity exit.
+   *
+   * \param d
+   *        derivative mode and filter
+   */
+  void derivative_set(const derivative_constants& d) {
+    on_error = d.on_error;
+    filter = d.filter;
+    cutoff = d.cutoff;
+    // Coefficients for y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2 at the tick rate
+    double rate = 1000.0 / period;
+    double w = 2.0 * M_PI * std::clamp(d.cutoff, 0.1, rate * 0.45) / rate;
+    if (filter == DERIVATIVE_FIRST_ORDER) {
+      // Matched pole, unity gain at DC
+      double alpha = 1.0 - exp(-w);
+      b0 = alpha;
+      b1 = b2 = a2 = 0.0;
+      a1 = alpha - 1.0;
+    } else if (filter == DERIVATIVE_BIQUAD) {
+      // Bilinear transform with Q = 1/sqrt(2)
+      double sin_w = sin(w), cos_w = cos(w);
+      double alpha = sin_w / M_SQRT2;
+      double a0 = 1.0 + alpha;
+      b0 = b2 = (1.0 - cos_w) / 2.0 / a0;
+      b1 = (1.0 - cos_w) / a0;
+      a1 = -2.0 * cos_w / a0;
+      a2 = (1.0 - alpha) / a0;
+    }
+  }
+
+  /**
+   * Starts a new motion.  The last measurement starts at the current one so the first derivative isn't a kick.
+   *
+   * \param itarget
+   *        target to hold
+   * \param current
+   *        current sensor value
+   */
+  void start(double itarget, double current) {
+    target = itarget;
+    error = prev_error = itarget - current;
+    cur = prev_current = current;
+    integral = derivative = output = 0.0;
+    x1 = x2 = y1 = y2 = 0.0;
+    small_time = big_time = velocity_time = mA_time = 0;
+  }
+
+  /**
+   * Sets the target.
+   */
+  void target_set(double input) { target = input; }
+
+  /**
+   * Returns the target.
+   */
+  double target_get() const { return target; }
+
+  /**
+   * Computes the output from a sensor value.
+   *
+   * \param current
+   *        current sensor value
+   */
+  double compute(double current) { return compute_error(target - current, current); }
+
+  /**
+   * Computes the output from an error.  The derivative is on current unless derivative_set() puts it on the error, so
+   * passing -error puts it on the error either way.
+   *
+   * \param err
+   *        target - current
+   * \param current
+   *        current sensor value
+   */
+  double compute_error(double err, double current) {
+    error = err;
+    cur = current;
+    // Measurement rate either way, so the output always subtracts it
+    double raw = on_error ? prev_error - error : cur - prev_current;
+    if (filter == DERIVATIVE_UNFILTERED) {
+      derivative = raw;
+    } else {
+      derivative = b0 * raw + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+      x2 = x1;
+      x1 = raw;
+      y2 = y1;
+      y1 = derivative;
+    }
+    if (constants.ki != 0) {
+      if (fabs(error) < constants.start_i) integral += error;
+      if constexpr (options & PID_I_RESET)
+        if ((error > 0) - (error < 0) != (prev_error > 0) - (prev_error < 0)) integral = 0;
+    }
+    output = error * constants.kp + integral * constants.ki - derivative * constants.kd;
+    prev_current = cur;
+    prev_error = error;
+    return output;
+  }
+
+  /**
+   * Updates the secondary sensor for velocity exiting.  Only exists with PID_VELOCITY_SECONDARY.
+   *
+   * \param secondary_sensor
+   *        secondary sensor velocity
+   */
+  void velocity_secondary_set(double secondary_sensor)
+    requires(bool(options & PID_VELOCITY_SECONDARY))
+  {
+    second_sensor = secondary_sensor;
+  }
+
+  /**
+   * Iterative exit condition, the same as ez::PID::exit_condition().
+   */
+  ez::exit_output exit_condition() {
+    if (exit.small_error == 0 && exit.small_exit_time == 0 && exit.big_error == 0 && exit.big_exit_time == 0 && exit.velocity_exit_time == 0 && exit.mA_timeout == 0)
+      return ez::ERROR_NO_CONSTANTS;
+
+    // Close enough for long enough
+    if (exit.small_error != 0) {
+      if (fabs(error) < exit.small_error) {
+        small_time += period;
+        big_time = 0;
+        if (small_time > exit.small_exit_time) return exited(ez::SMALL_EXIT);
+      } else {
+        small_time = 0;
+      }
+    }
+
+    // Nearly there but not getting closer
+    if (exit.big_error != 0 && exit.big_exit_time != 0) {
+      if (fabs(error) < exit.big_error) {
+        big_time += period;
+        if (big_time > exit.big_exit_time) return exited(ez::BIG_EXIT);
+      } else {
+        big_time = 0;
+      }
+    }
+
+    // Stopped moving
+    if (exit.velocity_exit_time != 0) {
+      bool stopped = fabs(derivative) <= velocity_zero_main;
+      if constexpr (options & PID_VELOCITY_SECONDARY) stopped = stopped && fabs(second_sensor) <= velocity_zero_secondary;
+      if (stopped) {
+        velocity_time += period;
+        if (velocity_time > exit.velocity_exit_time) return exited(ez::VELOCITY_EXIT);
+      } else {
+        velocity_time = 0;
+      }
+    }
+
+    return ez::RUNNING;
+  }
+
+  /**
+   * Iterative exit condition that also exits when a motor stays over its current limit.
+   *
+   * \param sensors
+   *        motors on the mechanism, read in place
+   */
+  ez::exit_output exit_condition(std::span<const pros::Motor> sensors) {
+    if (exit.mA_timeout != 0) {
+      bool over = false;
+      for (const pros::Motor& sensor : sensors) {
+        if (sensor.is_over_current()) {
+          over = true;
+          break;
+        }
+      }
+      if (over) {
+        mA_time += period;
+        if (mA_time > exit.mA_timeout) return exited(ez::mA_EXIT);
+      } else {
+        mA_time = 0;
+      }
+    }
+    return exit_condition();
+  }
+
+  ez::PID::exit_condition_ exit;
+  double output = 0.0;
+  double cur = 0.0;
+  double error = 0.0;
+  double target = 0.0;
+  double prev_error = 0.0;
+  double prev_current = 0.0;
+  double integral = 0.0;
+  double derivative = 0.0;
+
+ private:
+  ez::PID::Constants constants = {0.0, 0.0, 0.0, 0.0};
+  double velocity_zero_main = 0.05;
+  double velocity_zero_secondary = 0.075;
+  double second_sensor = 0.0;
+  bool on_error = false;
+  derivative_filter filter = DERIVATIVE_UNFILTERED;
+  double cutoff = 10.0;
+  int period = ez::util::DELAY_TIME;  // ms between calls
+  double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+  double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;  // last two raw and filtered derivatives
+  int small_time = 0;
+  int big_time = 0;
+  int velocity_time = 0;
+  int mA_time = 0;
+
+  ez::exit_output exited(ez::exit_output type) {
+    small_time = big_time = velocity_time = mA_time = 0;
+    return type;
+  }
+};
+
+/**
+ * PID the pipeline's motions run, with ez::PID's default of resetting i on sign changes.
+ */
+using motion_pid = pid<PID_I_RESET>;
+}  // namespace control
@@ -0,0 +1,754 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "api.h"
+#include "control/drive_backend.hpp"
+#include "control/histogram.hpp"
+#include "control/motions.hpp"
+#include "control/pose_ekf.hpp"
+#include "control/pose_history.hpp"
+#include "control/scheduler.hpp"
+#include "control/seqlock.hpp"
+
+namespace control {
+class flight_recorder;
+
+/**
+ * One motion the pipeline ran, from start to exit.
+ */
+struct motion_record {
+  const char* name;
+  uint32_t start;        // ms
+  uint32_t end;          // ms
+  ez::exit_output exit;  // RUNNING if it was replaced or the pipeline was disabled before it exited
+  ez::pose target;       // where the motion should end, from where it started
+  ez::pose pose;         // where it ended
+  int saved;             // ms predictive settling saved over the exit timers
+};
+
+/**
+ * A pose from one odometry update.  x, y and theta always come from the same update.
+ */
+struct pose_snapshot {
+  ez::pose pose;
+  uint32_t sequence;   // goes up by 1 every odometry update, so equal sequences are the same update
+  uint64_t timestamp;  // micros() when the sensors behind this pose were read
+};
+
+class pipeline {
+ public:
+  /**
+   * Creates a sense, estimate, control, actuate pipeline for a drive.
+   *
+   * Every tick reads the drive, runs odometry, runs the active motion on the pose from this tick, then sets the motors, in that order.
+   * With odom_period_set(), odometry runs faster in its own task instead and each tick uses the newest pose it published.
+   * The pipeline does nothing until enable() is called.
+   *
+   * \param backend
+   *        the drive to run
+   * \param period
+   *        period of a tick in ms
+   */
+  pipeline(drive_backend& backend, int period = ez::util::DELAY_TIME);
+
+  /**
+   * Takes over the drive and copies its tuned constants.
+   */
+  void enable();
+
+  /**
+   * Stops the active motion and gives the drive back.
+   */
+  void disable();
+
+  /**
+   * Returns true if the pipeline is running the drive.
+   */
+  bool enabled();
+
+  /**
+   * Copies tuned constants from the drive.  Call this again after changing constants while the pipeline is enabled.
+   */
+  void constants_sync();
+
+  /**
+   * Tuned constants used by new motions.
+   */
+  motion_constants constants;
+
+  /**
+   * Runs one tick.  The pipeline task calls this every period.
+   */
+  void tick();
+
+  /**
+   * Sets the active motion.  It takes over on the next tick.
+   *
+   * \param new_motion
+   *        motion to run
+   */
+  void motion_set(std::unique_ptr<motion> new_motion);
+
+  /**
+   * Sets the drive to go forward or backward.
+   *
+   * \param target
+   *        distance in inches, negative goes backward
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_drive_set(double target, int speed, bool slew_on = false);
+
+  /**
+   * Sets the drive to go forward or backward.
+   *
+   * \param p_target
+   *        distance with okapi units, negative goes backward
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_drive_set(okapi::QLength p_target, int speed, bool slew_on = false);
+
+  /**
+   * Sets drive constants that change with how far and how fast the robot drives, for pid_drive_set and queue_drive_add.
+   *
+   * Each drive looks up its constants once when it's made, interpolating between the points around its distance and
+   * speed.  Profiled drives don't use these.  An empty schedule goes back to the drive's single set of constants.
+   *
+   * \param schedule
+   *        {{distance, speed, {kp, ki, kd, start_i}}, ...}
+   */
+  void pid_drive_constants_set(std::vector<gain_point> schedule);
+
+  /**
+   * Sets turn constants that change with how far and how fast the robot turns, for pid_turn_set and queue_turn_add.
+   *
+   * Each turn looks up its constants once when it starts, interpolating between the points around the degrees it has to
+   * turn and its speed.  Profiled turns don't use these.  An empty schedule goes back to the turn's single set of constants.
+   *
+   * \param schedule
+   *        {{degrees, speed, {kp, ki, kd, start_i}}, ...}
+   */
+  void pid_turn_constants_set(std::vector<gain_point> schedule);
+
+  /**
+   * Sets time-based slew for drives and odom motions, in place of the chassis's distance-based slew.
+   *
+   * The max speed ramps up from 0 at the acceleration limit, easing in and out at the jerk limit, whenever a motion
+   * has slew_on.  The ramp takes the same time on every move, so short moves aren't stuck partway up it.
+   * {0, 0} goes back to the chassis's slew_drive_constants_set() distance and min speed.
+   *
+   * \param limits
+   *        {acceleration in speed/s, jerk in speed/s^2}, speed is 0 to 127
+   */
+  void slew_drive_constants_set(slew_limits limits);
+
+  /**
+   * Sets time-based slew for turns, in place of the chassis's distance-based slew.  See slew_drive_constants_set().
+   *
+   * \param limits
+   *        {acceleration in speed/s, jerk in speed/s^2}, speed is 0 to 127
+   */
+  void slew_turn_constants_set(slew_limits limits);
+
+  /**
+   * Sets if pid_drive_set and queue_drive_add follow a motion profile with feedforward instead of PID and slew.
+   *
+   * The profile uses constants.drive_limits, constants.drive_feedforward and constants.drive_tracking.  Speed scales the
+   * profile's max velocity and slew_on is ignored, the profile already ramps up.
+   *
+   * \param toggle
+   *        true follows a profile, false uses PID and slew
+   */
+  void pid_drive_profile_set(bool toggle);
+
+  /**
+   * Returns true if drive motions follow a motion profile.
+   */
+  bool pid_drive_profile_get();
+
+  /**
+   * Sets if pid_turn_set and queue_turn_add follow a motion profile with feedforward instead of PID and slew.
+   *
+   * The profile uses constants.turn_limits, constants.turn_feedforward, constants.turn_tracking and constants.turn_rate_kp.
+   * Speed scales the profile's max velocity and slew_on is ignored.
+   *
+   * \param toggle
+   *        true follows a profile, false uses PID and slew
+   */
+  void pid_turn_profile_set(bool toggle);
+
+  /**
+   * Returns true if turns follow a motion profile.
+   */
+  bool pid_turn_profile_get();
+
+  /**
+   * Sets if motions exit as soon as they're predicted to stay settled, instead of waiting out the exit timers.
+   *
+   * The prediction uses constants.settle, the exit timers still run as a fallback.  The history records the ms saved by
+   * each motion.
+   *
+   * \param toggle
+   *        true predicts settling, false only uses the exit timers
+   */
+  void pid_settle_predict_set(bool toggle);
+
+  /**
+   * Returns true if motions predict settling.
+   */
+  bool pid_settle_predict_get();
+
+  /**
+   * Sets how every motion's PIDs take their derivative.
+   *
+   * Differentiating whole encoder counts makes the D term jump, and the noise holds off the velocity exit.  A low-pass
+   * filter smooths both, at the cost of a little lag.  Takes effect on the next motion.
+   *
+   * \param d
+   *        {on_error, filter, cutoff in Hz}
+   */
+  void pid_derivative_set(derivative_constants d);
+
+  /**
+   * Returns how motions take their derivative.
+   */
+  derivative_constants pid_derivative_get();
+
+  /**
+   * Sets the drive to turn to an absolute heading.
+   *
+   * \param target
+   *        heading in degrees
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param behavior
+   *        which way to turn, defaults to the drive's turn behavior
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_turn_set(double target, int speed, ez::e_angle_behavior behavior, bool slew_on = false);
+
+  /**
+   * Sets the drive to turn to an absolute heading, using the drive's turn behavior.
+   *
+   * \param target
+   *        heading in degrees
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_turn_set(double target, int speed, bool slew_on = false);
+
+  /**
+   * Sets the drive to turn to an absolute heading, using the drive's turn behavior.
+   *
+   * \param p_target
+   *        heading with okapi units
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_turn_set(okapi::QAngle p_target, int speed, bool slew_on = false);
+
+  /**
+   * Sets the drive to go to a point.  If the point has an angle this will use boomerang.
+   *
+   * \param imovement
+   *        {{x, y}, fwd/rev, speed} or {{x, y, theta}, fwd/rev, speed}
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_odom_set(ez::odom imovement, bool slew_on = false);
+
+  /**
+   * Sets the drive to go to a point.  If the point has an angle this will use boomerang.
+   *
+   * \param p_imovement
+   *        {{x, y}, fwd/rev, speed} or {{x, y, theta}, fwd/rev, speed} with okapi units
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_odom_set(ez::united_odom p_imovement, bool slew_on = false);
+
+  /**
+   * Sets the drive to follow a path through every point with pure pursuit.
+   *
+   * \param imovements
+   *        {{{x, y}, fwd/rev, speed}, {{x, y}, fwd/rev, speed}...}
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_odom_set(std::vector<ez::odom> imovements, bool slew_on = false);
+
+  /**
+   * Sets the drive to follow a path through every point with pure pursuit.
+   *
+   * \param p_imovements
+   *        {{{x, y}, fwd/rev, speed}, {{x, y}, fwd/rev, speed}...} with okapi units
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void pid_odom_set(std::vector<ez::united_odom> p_imovements, bool slew_on = false);
+
+  /**
+   * Adds a motion to the end of the queue.  Queued motions run back to back without waiting on the calling task.
+   *
+   * The next motion is prepared on a background task while the one before it runs, so it takes over on the same tick the motion before it exits.
+   *
+   * \param new_motion
+   *        motion to run
+   */
+  void queue_add(std::unique_ptr<motion> new_motion);
+
+  /**
+   * Adds driving forward or backward to the queue.
+   *
+   * \param target
+   *        distance in inches, negative goes backward
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void queue_drive_add(double target, int speed, bool slew_on = false);
+
+  /**
+   * Adds driving forward or backward to the queue.
+   *
+   * \param p_target
+   *        distance with okapi units, negative goes backward
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void queue_drive_add(okapi::QLength p_target, int speed, bool slew_on = false);
+
+  /**
+   * Adds turning to an absolute heading to the queue, using the drive's turn behavior.
+   *
+   * \param target
+   *        heading in degrees
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void queue_turn_add(double target, int speed, bool slew_on = false);
+
+  /**
+   * Adds turning to an absolute heading to the queue, using the drive's turn behavior.
+   *
+   * \param p_target
+   *        heading with okapi units
+   * \param speed
+   *        0 to 127, max speed during motion
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void queue_turn_add(okapi::QAngle p_target, int speed, bool slew_on = false);
+
+  /**
+   * Adds going to a point to the queue.  If the point has an angle this will use boomerang.
+   *
+   * \param p_imovement
+   *        {{x, y}, fwd/rev, speed} or {{x, y, theta}, fwd/rev, speed} with okapi units
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void queue_odom_add(ez::united_odom p_imovement, bool slew_on = false);
+
+  /**
+   * Adds following a path with pure pursuit to the queue.
+   *
+   * \param p_imovements
+   *        {{{x, y}, fwd/rev, speed}, {{x, y}, fwd/rev, speed}...} with okapi units
+   * \param slew_on
+   *        ramp up from a lower speed to speed
+   */
+  void queue_odom_add(std::vector<ez::united_odom> p_imovements, bool slew_on = false);
+
+  /**
+   * Removes every motion from the queue that hasn't started yet.
+   */
+  void queue_clear();
+
+  /**
+   * Locks the calling task until every queued motion has run and the last one exits.
+   */
+  void queue_wait();
+
+  /**
+   * Locks the calling task until the active motion exits.  The pipeline wakes the task on the tick it exits.
+   */
+  void pid_wait();
+
+  /**
+   * Locks the calling task until the robot passes a point in the current path.
+   *
+   * \param index
+   *        index of the point in the path, starting at 0
+   */
+  void pid_wait_until_index(int index);
+
+  /**
+   * Locks the calling task until the robot passes a point, or the motion exits.
+   *
+   * \param target
+   *        {x, y} point in inches
+   */
+  void pid_wait_until_point(ez::pose target);
+
+  /**
+   * Locks the calling task until the robot passes a point, or the motion exits.
+   *
+   * \param p_target
+   *        {x, y} point with okapi units
+   */
+  void pid_wait_until_point(ez::united_pose p_target);
+
+  /**
+   * Returns how the last motion exited, or RUNNING if it hasn't.
+   */
+  ez::exit_output exit_get();
+
+  /**
+   * Returns the drive state from the last tick.
+   */
+  drive_state state_get();
+
+  /**
+   * Returns every motion that has ended since history_clear(), oldest first.
+   */
+  std::vector<motion_record> history_get();
+
+  /**
+   * Forgets every motion in the history.
+   */
+  void history_clear();
+
+  /**
+   * Fixed rate loop that runs tick().
+   */
+  scheduler loop;
+
+  /**
+   * Time from reading sensors to setting the motors, every tick.
+   */
+  histogram latency;
+
+  /**
+   * Time from odometry updating the pose to the motion using it, every tick.
+   */
+  histogram pose_age;
+
+  /**
+   * Time from the pipeline waking a waiting task to that task running, every wait.
+   */
+  histogram wake_latency;
+
+  /**
+   * Time from one motion exiting to the next queued one starting.  Motions set after the last one exited aren't
+   * counted, that gap is the caller's.  Bins cover 4 ticks, so a handoff that missed a tick or two still lands in a bin.
+   */
+  histogram handoff;
+
+  /**
+   * Sets if sensors are read once per tick into a snapshot, or one value at a time.  Compare the device reads in stats_print() with this on and off.
+   *
+   * \param batch
+   *        true reads a snapshot, false reads every value separately
+   */
+  void sensors_batch_set(bool batch);
+
+  /**
+   * Returns true if sensors are read once per tick into a snapshot.
+   */
+  bool sensors_batch_get();
+
+  /**
+   * Sets if odometry runs in its own task, faster than the control tick.
+   *
+   * Odometry integrates the drive in steps, and every step assumes the robot drove along one arc.  Shorter steps follow
+   * fast turns better.  The odometry task runs above the pipeline's priority, reads every sensor and publishes the pose
+   * without a mutex, and each control tick uses the newest pose.  It does take a mutex to add the pose to the history
+   * odom_pose_at() reads, held for one entry or one lookup.  PROS mutexes lend their holder the waiter's priority, so a
+   * lower task reading the history only holds odometry up for its lookup.  Sensors are asked to update at the same
+   * period where they can, the IMU can't go under 5 ms.  Takes effect the next time the pipeline is enabled.
+   *
+   * \param ms
+   *        odometry period, 2 to 5 ms is useful and anything else is clamped to that up to the control period.  0 runs
+   *        odometry in the control tick
+   */
+  void odom_period_set(int ms);
+
+  /**
+   * Returns the odometry period in ms, 0 if odometry runs in the control tick.
+   */
+  int odom_period_get();
+
+  /**
+   * Returns the newest pose, without waiting on the pipeline's mutex.
+   *
+   * Reading x, y and theta one at a time can mix two odometry updates if odometry runs in between.  This copies all
+   * three from one update, along with when the sensors for it were read.  It never blocks, odometry never waits on it,
+   * and it's safe to call from any task.
+   */
+  pose_snapshot odom_pose_get();
+
+  /**
+   * Returns where odometry had the robot at a past time, interpolated between updates.  The pipeline keeps the last
+   * pose_history::CAPACITY updates while it's enabled.
+   *
+   * \param timestamp
+   *        micros() to look up, compare against pose_snapshot::timestamp
+   * \param output
+   *        set to the pose at timestamp
+   *
+   * \return false if timestamp is older than every pose kept
+   */
+  bool odom_pose_at(uint64_t timestamp, ez::pose& output);
+
+  /**
+   * Carries a delayed measurement forward to now, see pose_history::propagate().
+   *
+   * \param measured
+   *        pose from an absolute sensor, like pros::Gps
+   * \param timestamp
+   *        micros() when the sensor took the measurement, not when it was read
+   * \param output
+   *        set to where the robot is now, going by measured
+   *
+   * \return false if timestamp is older than every pose kept
+   */
+  bool odom_pose_propagate(const ez::pose& measured, uint64_t timestamp, ez::pose& output);
+
+  /**
+   * Moves odometry to a pose.  Safe to call from any task.
+   *
+   * While the pipeline is enabled the move waits for the next odometry update and is made by whichever task runs
+   * odometry, before it reads the drive, so it never lands halfway through an update.  Odometry's motion since timestamp
+   * is added on, and the EKF starts over from the new pose.  While the pipeline is disabled the backend's odometry is moved
+   * right away, the same as ez::Drive::odom_pose_set().
+   *
+   * \param pose
+   *        {x, y, theta} in inches and degrees
+   * \param timestamp
+   *        micros() when the robot was at pose, compare against pose_snapshot::timestamp.  0 takes pose as where it is now
+   */
+  void odom_pose_set(const ez::pose& pose, uint64_t timestamp = 0);
+
+  /**
+   * Returns odometry's pose whether or not the pipeline is enabled.  While it is this is odom_pose_get(), while it isn't
+   * it's the backend's pose as of now.
+   */
+  pose_snapshot odom_pose_current_get();
+
+  /**
+   * Sets if odometry runs through a pose_ekf, so GPS fixes and distance sensor readings can correct it.
+   *
+   * Each tick the EKF moves by odometry's motion.  Readings added since the last tick then update it, compared against
+   * where the robot was when each one was taken.  When a reading moves the pose, the backend's odometry is moved there too
+   * so ez::Drive's pose and the pipeline's always agree.  Takes effect the next time the pipeline is enabled, starting from
+   * the pose odometry has then.
+   *
+   * \param enable
+   *        true fuses readings, false is odometry alone
+   */
+  void estimator_set(bool enable);
+
+  /**
+   * Returns if odometry runs through the EKF.
+   */
+  bool estimator_get();
+
+  /**
+   * Sets sensor noise and field walls for the EKF.  Takes effect the next time the pipeline is enabled.
+   *
+   * \param constants
+   *        walls are in odometry coordinates, so set odometry to field coordinates before enabling
+   */
+  void estimator_constants_set(const ekf_constants& constants);
+
+  /**
+   * Returns sensor noise and field walls for the EKF.
+   */
+  ekf_constants estimator_constants_get();
+
+  /**
+   * Adds a GPS fix for the EKF.  Safe to call from any task, the fix is used on the next odometry update.
+   *
+   * pros::Gps reports meters from the center of the field, so x and y are get_position_x() and get_position_y() times
+   * 39.37, moved into odometry coordinates.  get_error() is the fix's error in meters.
+   *
+   * \param x
+   *        in
+   * \param y
+   *        in
+   * \param std_dev
+   *        in, how far the fix could be off
+   * \param timestamp
+   *        micros() when the fix was taken.  The GPS is roughly 20 ms behind when it's read
+   */
+  void estimator_gps_add(double x, double y, double std_dev, uint64_t timestamp);
+
+  /**
+   * Adds a distance sensor reading for the EKF.  Safe to call from any task, the reading is used on the next odometry
+   * update.
+   *
+   * \param mount
+   *        where the sensor is on the robot
+   * \param range
+   *        in, pros::Distance::get_distance() / 25.4
+   * \param timestamp
+   *        micros() when the reading was taken
+   */
+  void estimator_distance_add(const distance_mount& mount, double range, uint64_t timestamp);
+
+  /**
+   * Sets a recorder for every odometry update, the sensors it read and the pose it made.  Takes effect the next time the
+   * pipeline is enabled.  Open the recorder first, and close it once the pipeline is disabled.
+   *
+   * \param recorder
+   *        recorder, or nullptr to stop recording
+   */
+  void recorder_set(flight_recorder* recorder);
+
+  /**
+   * Returns the recorder, nullptr if there isn't one.
+   */
+  flight_recorder* recorder_get();
+
+  /**
+   * Fixed rate loop that runs odometry when it has its own task.
+   */
+  scheduler odom_loop;
+
+  /**
+   * Prints loop timing and latency to the terminal.
+   */
+  void stats_print();
+
+ private:
+  drive_backend& backend;
+  pros::Mutex mutex;
+  bool is_enabled = false;
+  bool sensors_batch = true;
+  int odom_period = 0;
+  bool odom_separate = false;  // odom_period as of enable()
+
+  // Odometry publishes every estimate here, from its own task or the control tick
+  struct estimate {
+    drive_state state;
+    uint64_t estimated;  // micros() when odometry finished
+  };
+  seqlock<estimate> published;
+  pros::Mutex poses_mutex;  // taken by the odometry task too, only ever for one entry or lookup
+  pose_history poses;
+  void publish(const drive_state& now, uint64_t estimated);
+  void odom_tick();
+  ez::pose odom_run(const drive_state& now);
+
+  // Pose EKF, run by whichever task runs odometry
+  bool estimator_on = false;
+  bool estimator_running = false;  // estimator_on as of enable()
+  ekf_constants estimator_constants;
+  pose_ekf ekf;
+  ez::pose odom_last = {0.0, 0.0, 0.0};  // pose the backend's odometry started this tick from
+  ez::pose reckoned = {0.0, 0.0, 0.0};   // odometry's motion alone, never corrected
+  pose_history reckoned_poses;
+  uint64_t estimator_last = 0;
+
+  // Readings waiting for the next odometry update
+  static const int READINGS = 8;
+  struct gps_reading {
+    double x, y, std_dev;
+    uint64_t timestamp;
+  };
+  struct distance_reading {
+    distance_mount mount;
+    double range;
+    uint64_t timestamp;
+  };
+  pros::Mutex readings_mutex;
+  std::array<gps_reading, READINGS> gps_readings;
+  std::array<distance_reading, READINGS> distance_readings;
+  int gps_count = 0;
+  int distance_count = 0;
+  int readings_used = 0;
+  int readings_rejected = 0;
+  int readings_dropped = 0;
+  void readings_apply();
+
+  // A move from odom_pose_set() waiting for the next odometry update, under readings_mutex
+  bool move_pending = false;
+  ez::pose move_pose = {0.0, 0.0, 0.0};
+  uint64_t move_timestamp = 0;
+  void move_apply();
+
+  // Flight recorder, run by whichever task runs odometry
+  flight_recorder* recorder = nullptr;
+  flight_recorder* recorder_running = nullptr;  // recorder as of enable()
+  bool drive_profile = false;
+  bool turn_profile = false;
+  std::shared_ptr<motion> current;
+  std::shared_ptr<motion> pending;
+  drive_state state;
+  ez::exit_output exit = ez::RUNNING;
+  int index = -1;
+  double heading_target = 0.0;
+  uint64_t exited = 0;
+  motion_record record;
+  std::vector<motion_record> history;
+  void motion_start(std::shared_ptr<motion> next, bool queued);
+  void motion_end();
+  std::unique_ptr<motion> drive_make(double target, int speed, bool slew_on);
+  std::unique_ptr<motion> turn_make(double target, int speed, ez::e_angle_behavior behavior, bool slew_on);
+  std::unique_ptr<motion> odom_make(ez::odom imovement, bool slew_on);
+  std::unique_ptr<motion> pursuit_make(std::vector<ez::odom> imovements, bool slew_on);
+
+  // Queued motions.  The background task prepares them in order, the pipeline only starts one once it's prepared
+  enum e_queue_stage { QUEUED, PREPARING, PREPARED };
+  struct queued {
+    std::shared_ptr<motion> next;
+    ez::pose start;
+    e_queue_stage stage;
+  };
+  std::deque<queued> queue;
+  ez::pose queue_end = {0.0, 0.0, 0.0};
+  bool queue_prepare();
+  void queue_task();
+
+  // A task locked in a wait, this lives on the waiting task's stack
+  struct waiter {
+    pros::Task task;
+    int index = -1;
+    ez::pose point = {0.0, 0.0, ez::ANGLE_NOT_SET};
+    bool has_point = false;
+    bool queue = false;
+    int side = 0;
+    bool done = false;
+    uint64_t woken = 0;
+  };
+  std::vector<waiter*> waiters;
+  bool waiter_done(waiter& wait);
+  void waiters_notify();
+  void wait(waiter& wait);
+
+  // Declared last so everything above exists before the tasks start
+  pros::Task task;
+  pros::Task prepare_task;
+  pros::Task odom_task;
+};
+}  // namespace control
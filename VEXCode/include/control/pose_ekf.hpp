@@ -0,0 +1,169 @@
+#pragma once
+
+#include "EZ-Template/util.hpp"
+
+namespace control {
+/**
+ * Walls of the field in odometry coordinates, inches.  Distance sensors range off these.
+ */
+struct field_walls {
+  double left = -72.0;    // x of the wall on the left
+  double right = 72.0;    // x of the wall on the right
+  double bottom = -72.0;  // y of the wall behind the start
+  double top = 72.0;      // y of the wall in front of the start
+};
+
+/**
+ * Where a distance sensor is on the robot.
+ */
+struct distance_mount {
+  double x = 0.0;      // in, right of the center of rotation
+  double y = 0.0;      // in, forward of the center of rotation
+  double angle = 0.0;  // deg the beam points, clockwise from forward
+};
+
+/**
+ * How much the EKF trusts each sensor, as 1 standard deviation.
+ */
+struct ekf_constants {
+  double tracker = 0.02;            // in of error per inch the drive or tracking wheels travel
+  double heading = 0.01;            // deg of error per deg the IMU turns
+  double heading_drift = 0.05;      // deg the IMU wanders per sqrt(s), standing still
+  double gyro = 2.0;                // deg/s of noise on the IMU's rate
+  double distance_floor = 0.6;      // in, the distance sensor's error up close
+  double distance_fraction = 0.05;  // of the range, the distance sensor's error past 200 mm
+  double gate = 3.0;                // updates more than this many standard deviations from the estimate are thrown out
+  double max_incidence = 45.0;      // deg, distance readings hitting a wall more glancing than this are thrown out
+  field_walls field;
+};
+
+/**
+ * Extended Kalman filter for the drive's pose.
+ *
+ * The state is x, y and theta, plus forward velocity and angular velocity.  Odometry's motion each tick and the IMU's
+ * rate drive the prediction, and its covariance grows with how far the robot moved and turned.  Absolute sensors then
+ * pull the pose back: pros::Gps fixes update x and y, and pros::Distance readings update whatever the range to the
+ * nearest wall says is off.  Each reading is its own scalar update, so nothing needs a matrix inverse, and every matrix
+ * is a fixed 5x5 array.
+ *
+ * Absolute sensors report where the robot was a few ticks ago.  Updates take the motion since the reading was taken,
+ * from pose_history::motion_since(), and compare the reading against where the estimate says the robot was then.
+ */
+class pose_ekf {
+ public:
+  /**
+   * Size of the state.
+   */
+  static const int N = 5;
+
+  /**
+   * Creates a filter at {0, 0, 0}.
+   *
+   * \param constants
+   *        sensor noise and field walls
+   */
+  pose_ekf(const ekf_constants& constants = {});
+
+  /**
+   * Sets sensor noise and field walls.
+   */
+  void constants_set(const ekf_constants& constants);
+
+  /**
+   * Returns sensor noise and field walls.
+   */
+  ekf_constants constants_get();
+
+  /**
+   * Starts over at a pose, stopped.
+   *
+   * \param pose
+   *        {x, y, theta} in inches and degrees
+   * \param position_std
+   *        in, how sure the starting x and y are
+   * \param heading_std
+   *        deg, how sure the starting theta is
+   */
+  void reset(const ez::pose& pose, double position_std = 0.5, double heading_std = 1.0);
+
+  /**
+   * Moves the estimate by one tick of odometry.
+   *
+   * \param motion
+   *        {right, forward, turn} in inches and degrees, relative to where the robot was at the start of the tick
+   * \param dt
+   *        length of the tick in seconds
+   * \param imu_rate
+   *        IMU rate in deg/s, clockwise positive
+   */
+  void predict(const ez::pose& motion, double dt, double imu_rate);
+
+  /**
+   * Updates x and y from a GPS fix.
+   *
+   * \param x
+   *        in, in odometry coordinates
+   * \param y
+   *        in, in odometry coordinates
+   * \param std_dev
+   *        in, how far the fix could be off.  pros::Gps::get_error() is in meters
+   * \param since
+   *        {right, forward, turn} the robot moved after the fix was taken
+   *
+   * \return true if either coordinate was used, false if both were thrown out
+   */
+  bool gps_update(double x, double y, double std_dev, const ez::pose& since = {0.0, 0.0, 0.0});
+
+  /**
+   * Updates from a distance sensor pointed at a field wall.
+   *
+   * \param mount
+   *        where the sensor is on the robot
+   * \param range
+   *        in, what the sensor read
+   * \param since
+   *        {right, forward, turn} the robot moved after the reading was taken
+   *
+   * \return true if the reading was used, false if it didn't point at a wall squarely enough or was too far off
+   */
+  bool distance_update(const distance_mount& mount, double range, const ez::pose& since = {0.0, 0.0, 0.0});
+
+  /**
+   * Returns the estimated {x, y, theta} in inches and degrees.
+   */
+  ez::pose pose_get();
+
+  /**
+   * Returns the estimated forward velocity in in/s.
+   */
+  double velocity_get();
+
+  /**
+   * Returns the estimated angular velocity in deg/s, clockwise positive.
+   */
+  double angular_velocity_get();
+
+  /**
+   * Returns 1 standard deviation of the position estimate in inches, the larger of x and y.
+   */
+  double position_std_get();
+
+  /**
+   * Returns 1 standard deviation of the heading estimate in degrees.
+   */
+  double heading_std_get();
+
+ private:
+  ekf_constants constants;
+  double state[N] = {0.0};  // x, y in inches, theta in radians, v in in/s, w in rad/s
+  double P[N][N] = {{0.0}};
+
+  // Where the robot was before moving since, for a given state
+  static void pose_then(const double* s, const ez::pose& since, double output[3]);
+  // Expected range for a given state, 0 if the beam doesn't hit a wall squarely enough
+  double range_expected(const double* s, const distance_mount& mount, const ez::pose& since);
+  // Scalar update with measurement function h(state) of x, y and theta, Jacobian by central difference
+  template <typename F>
+  bool update(double measured, double variance, F h);
+};
+}  // namespace control
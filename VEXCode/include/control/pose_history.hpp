@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "EZ-Template/util.hpp"
+
+namespace control {
+/**
+ * The last CAPACITY poses from odometry, each with when its sensors were read.
+ *
+ * Sensors like pros::Gps and pros::Distance report where the robot was a few ticks ago, not where it is now.  Keeping
+ * recent poses lets a measurement be compared against the pose from when it was taken, then carried forward to now with
+ * the motion odometry saw since.  Fixed size, nothing allocates after construction.
+ */
+class pose_history {
+ public:
+  /**
+   * Amount of poses kept, the oldest is dropped once it's full.
+   */
+  static const int CAPACITY = 256;
+
+  /**
+   * Forgets every pose.
+   */
+  void reset();
+
+  /**
+   * Adds the newest pose.  Poses that aren't newer than the last one are ignored.
+   *
+   * \param timestamp
+   *        micros() when the sensors behind the pose were read
+   * \param pose
+   *        pose from odometry
+   */
+  void add(uint64_t timestamp, const ez::pose& pose);
+
+  /**
+   * Returns the amount of poses kept.
+   */
+  int count_get();
+
+  /**
+   * Returns the timestamp of the oldest pose kept, 0 if there are none.
+   */
+  uint64_t oldest_get();
+
+  /**
+   * Returns the timestamp of the newest pose, 0 if there are none.
+   */
+  uint64_t newest_get();
+
+  /**
+   * Finds where the robot was at a past time, interpolating between the poses on either side.  Binary searches, so this
+   * is O(log n).
+   *
+   * \param timestamp
+   *        micros() to look up.  Times past the newest pose return the newest pose
+   * \param output
+   *        set to the pose at timestamp
+   *
+   * \return false if timestamp is older than every pose kept, output isn't set
+   */
+  bool pose_at(uint64_t timestamp, ez::pose& output);
+
+  /**
+   * Returns how the robot moved from a past time to the newest pose, relative to where it was then.
+   *
+   * \param timestamp
+   *        micros() to measure from
+   * \param output
+   *        set to {right, forward, turn} in inches and degrees, right and forward of the robot at timestamp
+   *
+   * \return false if timestamp is older than every pose kept, output isn't set
+   */
+  bool motion_since(uint64_t timestamp, ez::pose& output);
+
+  /**
+   * Carries a delayed measurement forward to the newest pose.  The robot is placed at measured at timestamp, then moved
+   * by however far odometry says it went from timestamp to now, turned into the measured frame.
+   *
+   * \param measured
+   *        pose from an absolute sensor, like pros::Gps
+   * \param timestamp
+   *        micros() when the sensor took the measurement
+   * \param output
+   *        set to where the robot is now, going by measured
+   *
+   * \return false if timestamp is older than every pose kept, output isn't set
+   */
+  bool propagate(const ez::pose& measured, uint64_t timestamp, ez::pose& output);
+
+ private:
+  struct entry {
+    uint64_t timestamp;
+    ez::pose pose;
+  };
+  // Entry i counts from the oldest
+  const entry& at(int i) { return entries[(start + i) % CAPACITY]; }
+
+  std::array<entry, CAPACITY> entries;
+  int start = 0;
+  int count = 0;
+};
+}  // namespace control
@@ -0,0 +1,79 @@
+#pragma once
+
+namespace control {
+/**
+ * Limits for a motion profile.  Units are inches or degrees, per second.
+ */
+struct profile_constraints {
+  double max_velocity;
+  double max_acceleration;
+  double max_jerk;  // 0 makes a trapezoid, anything else makes an S-curve
+};
+
+/**
+ * Feedforward in volts from the profile's velocity and acceleration.
+ */
+struct feedforward {
+  double kS;  // volts to break static friction
+  double kV;  // volts per unit/s
+  double kA;  // volts per unit/s^2
+
+  /**
+   * Returns motor power, -127 to 127, for a velocity and acceleration.
+   */
+  double output(double velocity, double acceleration) const;
+};
+
+/**
+ * Where the profile says the robot should be at a time.
+ */
+struct profile_point {
+  double position;
+  double velocity;
+  double acceleration;
+};
+
+/**
+ * Time-optimal profile from rest to rest over a distance.
+ *
+ * The robot speeds up at max acceleration, cruises at max velocity, then slows down at max acceleration.  With a jerk
+ * limit, acceleration ramps in and out too so the robot doesn't get jolted.  Short moves that can't reach max velocity
+ * peak at a lower one.
+ */
+class motion_profile {
+ public:
+  /**
+   * Plans a profile.  This is closed form, short moves take a quick search for their peak velocity.
+   *
+   * \param distance
+   *        distance to travel, negative goes backward
+   * \param constraints
+   *        velocity, acceleration and jerk limits
+   */
+  void generate(double distance, const profile_constraints& constraints);
+
+  /**
+   * Returns where the profile is at a time since it started.  Before 0 and after the end it's at rest.
+   *
+   * \param t
+   *        seconds since the profile started
+   */
+  profile_point sample(double t) const;
+
+  /**
+   * Returns how long the profile takes in seconds.
+   */
+  double duration_get() const;
+
+ private:
+  int sign = 1;
+  double distance = 0.0;
+  double peak_velocity = 0.0;
+  double peak_acceleration = 0.0;
+  double jerk = 0.0;
+  double accel_time = 0.0;  // time to speed up, and to slow down
+  double jerk_time = 0.0;   // time acceleration ramps at each end of accel_time
+  double cruise_time = 0.0;
+  profile_point accel_sample(double t) const;
+};
+}  // namespace control
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "EZ-Template/util.hpp"
+#include "api.h"
+#include "control/loop_stats.hpp"
+
+namespace control {
+class scheduler {
+ public:
+  /**
+   * Creates a fixed rate loop.
+   *
+   * Iterations are paced with delay_until, so the period does not drift by however long the loop body took.
+   *
+   * \param name
+   *        name of the loop that prints
+   * \param period
+   *        period of the loop in ms
+   */
+  scheduler(std::string name, int period = ez::util::DELAY_TIME);
+
+  ~scheduler();
+
+  /**
+   * Marks the start of the first iteration.  Call this right before entering the loop.
+   */
+  void start();
+
+  /**
+   * Ends the current iteration and sleeps until the next period starts.  Call this at the end of the loop body.
+   */
+  void wait();
+
+  /**
+   * Runs the body forever at the fixed period.  Use this as the body of a task.
+   *
+   * \param body
+   *        function that runs once per period
+   */
+  void run(std::function<void()> body);
+
+  /**
+   * Sets the period of the loop.
+   *
+   * \param ms
+   *        period in ms
+   */
+  void period_set(int ms);
+
+  /**
+   * Returns the period of the loop in ms.
+   */
+  int period_get();
+
+  /**
+   * Returns the time the current iteration started in microseconds.
+   */
+  uint64_t tick_start_get();
+
+  /**
+   * Returns the name of the loop.
+   */
+  std::string name_get();
+
+  /**
+   * Prints timing statistics to the terminal.
+   */
+  void stats_print();
+
+  /**
+   * Timing statistics.
+   */
+  loop_stats stats;
+
+ private:
+  std::string name;
+  int period;
+  uint32_t wake_time = 0;
+  uint64_t tick_start = 0;
+  bool started = false;
+};
+
+/**
+ * Prints timing statistics for every scheduler to the terminal.
+ */
+void schedulers_print();
+
+/**
+ * Resets timing statistics for every scheduler.
+ */
+void schedulers_reset();
+}  // namespace control
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace control {
+/**
+ * One task publishes a value, any task can copy the newest one without a mutex.
+ *
+ * Writes alternate between two buffers and bump a sequence number once the write is done.  A reader copies the buffer
+ * the sequence points at, then checks the sequence didn't move while it copied, and copies again if it did.  The
+ * writer never waits on readers.  A reader that interrupts the writer reads the buffer the writer isn't touching, so a
+ * high priority reader can't spin waiting on a writer it has preempted.
+ *
+ * \tparam T
+ *         published value, copied with plain assignment
+ */
+template <typename T>
+class seqlock {
+  static_assert(std::is_trivially_copyable_v<T>, "seqlock values are copied while they might be written");
+
+ public:
+  /**
+   * Publishes a value.  Only one task may write.
+   */
+  void write(const T& value) {
+    uint32_t next = sequence.load(std::memory_order_relaxed) + 1;
+    // The last write's sequence has to be seen before this buffer changes, or a reader still copying it can't tell
+    std::atomic_thread_fence(std::memory_order_release);
+    buffers[next & 1] = value;
+    sequence.store(next, std::memory_order_release);
+  }
+
+  /**
+   * Returns the newest value.
+   *
+   * \param seq
+   *        if not null, set to the sequence number of the value, which goes up by 1 every write
+   */
+  T read(uint32_t* seq = nullptr) const {
+    while (true) {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      T output = buffers[before & 1];
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) == before) {
+        if (seq) *seq = before;
+        return output;
+      }
+    }
+  }
+
+  /**
+   * Returns the sequence number of the newest value.
+   */
+  uint32_t sequence_get() const { return sequence.load(std::memory_order_acquire); }
+
+ private:
+  std::atomic<uint32_t> sequence{0};
+  T buffers[2] = {};
+};
+}  // namespace control
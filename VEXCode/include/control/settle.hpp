@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+#include "EZ-Template/PID.hpp"
+
+namespace control {
+/**
+ * Tuning for predictive settling.
+ */
+struct settle_constants {
+  bool enabled = false;
+  double horizon = 0.1;     // s, how far ahead the error is projected
+  double motor_rpm = 60.0;  // the motors have to be slower than this
+  int ticks = 2;            // ticks in a row the projection has to stay inside small_error
+};
+
+/**
+ * Exits a motion as soon as its error is projected to stay settled, instead of waiting out the exit timers.
+ *
+ * Each tick the error is projected ahead along its rate of change.  When the error and the projection are both inside
+ * the PID's small_error and the motors have nearly stopped, for a few ticks in a row, the motion has settled.  The PID's
+ * own exit conditions keep running next to this, so a motion that never looks settled still exits on the timers.
+ */
+class settle_predictor {
+ public:
+  /**
+   * \param pid
+   *        PID whose exit conditions this would cut short
+   * \param constants
+   *        tuning for the prediction
+   */
+  settle_predictor(const ez::PID& pid, const settle_constants& constants);
+
+  /**
+   * Starts a new motion.
+   */
+  void start();
+
+  /**
+   * Returns true once the error is predicted to stay settled.  The rate is the change in error between calls.
+   *
+   * \param error
+   *        target - current
+   * \param motor_rpm
+   *        fastest drive motor, rpm
+   * \param timestamp
+   *        micros() of the sensors the error came from
+   */
+  bool iterate(double error, double motor_rpm, uint64_t timestamp);
+
+  /**
+   * Returns true once the error is predicted to stay settled.
+   *
+   * \param error
+   *        target - current
+   * \param rate
+   *        change in error per second, from a sensor like the gyro
+   * \param motor_rpm
+   *        fastest drive motor, rpm
+   * \param timestamp
+   *        micros() of the sensors the error came from
+   */
+  bool iterate(double error, double rate, double motor_rpm, uint64_t timestamp);
+
+  /**
+   * Returns ms between settling and the earliest the exit timers could have exited, 0 until it settles.
+   */
+  int saved_get() const;
+
+ private:
+  ez::PID::exit_condition_ exit;
+  settle_constants constants;
+  double last_error = 0.0;
+  uint64_t last_time = 0;
+  uint64_t small_since = 0;  // micros() the error went inside small_error, 0 when it's outside
+  uint64_t big_since = 0;
+  int count = 0;
+  int saved = 0;
+  bool settled = false;
+};
+}  // namespace control
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include "EZ-Template/slew.hpp"
+#include "EZ-Template/util.hpp"
+
+namespace control {
+/**
+ * Limits for time-based slew, in speed (0 to 127) per second.
+ */
+struct slew_limits {
+  double acceleration = 0.0;  // speed/s, 0 uses ez::slew's distance ramp instead
+  double jerk = 0.0;          // speed/s^2, 0 steps straight to full acceleration
+};
+
+/**
+ * Limits how fast a motion's output changes.
+ *
+ * With no acceleration limit this is ez::slew, capping max speed with a ramp from its min speed up to max speed over a
+ * distance.  On a short move that ramp never finishes, and on a long one it can be gentler than the motors need.  With
+ * an acceleration limit the output itself is rate limited in time instead, speeding up, slowing down and reversing alike,
+ * so every move gets the same ramps no matter how far it goes.  A jerk limit eases the acceleration in and out so each
+ * ramp is an S-curve.  Time comes from the tick timestamps, so the limits hold at any pipeline period.
+ */
+class slew_limiter {
+ public:
+  /**
+   * \param distance
+   *        distance-based slew, used when limits has no acceleration
+   * \param limits
+   *        time-based slew
+   * \param period
+   *        ms the first tick is taken to last, before there's a timestamp to go by
+   */
+  slew_limiter(const ez::slew& distance, const slew_limits& limits, int period = ez::util::DELAY_TIME);
+
+  /**
+   * Starts a new motion, the same as ez::slew::initialize().
+   *
+   * \param enabled
+   *        false leaves the cap at max_speed
+   * \param max_speed
+   *        speed the cap ramps up to, 0 to 127
+   * \param target
+   *        where the motion ends, for distance-based slew
+   * \param current
+   *        where the motion starts, for distance-based slew
+   */
+  void initialize(bool enabled, double max_speed, double target, double current);
+
+  /**
+   * Returns the output limited for this tick.  Call once a tick.
+   *
+   * \param output
+   *        what the motion wants, -127 to 127
+   * \param current
+   *        where the robot is now, for distance-based slew
+   * \param timestamp
+   *        us, when this tick's sensors were read
+   */
+  double iterate(double output, double current, uint64_t timestamp);
+
+ private:
+  ez::slew distance;
+  slew_limits limits;
+  int period;
+  bool enabled = false;
+  double max_speed = 0.0;
+  double speed = 0.0;         // output last tick
+  double acceleration = 0.0;  // speed/s
+  uint64_t last = 0;          // us, timestamp last tick, 0 before the first
+};
+}  // namespace control
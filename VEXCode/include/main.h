@@ -45,6 +45,9 @@
 
 // More includes here...
 #include "autons.hpp"
+#include "control/offset_calibration.hpp"
+#include "control/particle_filter.hpp"
+#include "control/scheduler.hpp"
 #include "subsystems.hpp"
 
 
@@ -2,8 +2,12 @@
 
 #include "EZ-Template/api.hpp"
 #include "api.h"
+#include "control/ez_backend.hpp"
+#include "control/pipeline.hpp"
 
 extern Drive chassis;
+extern control::ez_backend chassis_backend;
+extern control::pipeline drive_pipeline;
 //vex me gusta
 // Controller
 inline pros::Controller master(pros::E_CONTROLLER_MASTER);
@@ -16,6 +20,10 @@ inline bool r1_intake_state = false;
 inline pros::Motor intake_motor_a(11);
 inline pros::Motor intake_motor_b(-20);
 
+// Distance sensors for relocalizing off the field walls at the match loader, only read with MATCH_LOAD_RELOCALIZE on
+inline pros::Distance back_distance(16);
+inline pros::Distance left_distance(17);
+
 // Pneumatic pistons
 inline pros::adi::DigitalOut Middle('A');
 inline pros::adi::DigitalOut Wall('B');
@@ -0,0 +1,519 @@
+// Compares motion modes on the simulated drivetrain.  Every motion starts from rest at {0, 0, 0}.
+//
+//   make -C sim
+//   sim/motion_bench
+
+#include <stdio.h>
+
+#include <cmath>
+#include <functional>
+#include <map>
+
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "world.hpp"
+
+static const int SPEED = 110;
+
+// Motions that haven't exited after this many us are stopped
+static const uint64_t TIMEOUT = 5000000;
+
+// Jerk limit for the S-curve runs, in/s^3
+static const double S_CURVE_JERK = 4000.0;
+
+// Derivative filter cutoff, Hz
+static const double DERIVATIVE_CUTOFF = 10.0;
+
+// Time-based slew, about the same peak acceleration as the distance slew in default_constants().  Speed per s and per s^2
+static const double SLEW_ACCELERATION = 1200.0;
+static const double SLEW_JERK = 24000.0;
+
+// Raw motor counts per encoder step, for runs with a coarser encoder
+static int encoder_step = 1;
+
+struct result {
+  double time;   // s from the motion starting to it exiting
+  double error;  // how far off the robot really ended
+  std::string exit;
+  int saved;  // ms predictive settling saved
+  double peak = 0.0;  // largest peak_get seen, like overshoot, only measured when motion_run gets peak_get
+};
+
+// Runs one motion to its exit.  error_get measures the robot in the world once the motion exits.  peak_get, if given,
+// is checked every tick until the motion exits and the largest value it returns is kept.
+static result motion_run(std::function<void()> start, std::function<double(const sim::world&)> error_get,
+                         std::function<double(const sim::world&)> peak_get = nullptr) {
+  sim::robot_reset();
+  sim::world::get().config.encoder_step = encoder_step;
+  drive_pipeline.history_clear();
+  drive_pipeline.enable();
+  sim::kernel& kernel = sim::kernel::get();
+  kernel.deadline_set(kernel.micros_get() + TIMEOUT);
+  double peak = 0.0;
+  try {
+    start();
+    if (peak_get) {
+      while (drive_pipeline.exit_get() == ez::RUNNING) {
+        peak = fmax(peak, peak_get(sim::world::get()));
+        pros::delay(ez::util::DELAY_TIME);
+      }
+    } else {
+      drive_pipeline.pid_wait();
+    }
+  } catch (const sim::deadline_exceeded&) {
+  }
+  kernel.deadline_set(0);
+  drive_pipeline.disable();
+  control::motion_record r = drive_pipeline.history_get().back();
+  return {(r.end - r.start) / 1000.0, error_get(sim::world::get()), r.exit == ez::RUNNING ? "Timed out" : ez::exit_to_string(r.exit), r.saved,
+          peak};
+}
+
+static void header_print(const char* title) {
+  printf("%s\n  %-8s %-14s %9s %8s  %s\n", title, "move", "mode", "time", "error", "exit");
+}
+
+// Prints a result against the first mode for the same move
+static void row_print(const char* move, const char* mode, const result& r, const result& base) {
+  printf("  %-8s %-14s %7.3f s %8.2f  %-9s", move, mode, r.time, r.error, r.exit.c_str());
+  if (&r != &base) printf(" %+6.1f%%", (r.time - base.time) / base.time * 100.0);
+  if (r.saved > 0) printf("  %d ms saved", r.saved);
+  printf("\n");
+}
+
+static void drives_bench() {
+  header_print("drive to a distance, error in inches");
+  control::profile_constraints limits = drive_pipeline.constants.drive_limits;
+  for (double distance : {24.0, 48.0, 72.0}) {
+    auto error_get = [distance](const sim::world& w) { return w.y - distance; };
+    auto profiled = [distance]() { drive_pipeline.pid_drive_set(distance, SPEED); };
+
+    drive_pipeline.pid_drive_profile_set(false);
+    result pid = motion_run([distance]() { drive_pipeline.pid_drive_set(distance, SPEED, true); }, error_get);
+    drive_pipeline.pid_drive_profile_set(true);
+    result trapezoid = motion_run(profiled, error_get);
+    drive_pipeline.constants.drive_limits.max_jerk = S_CURVE_JERK;
+    result s_curve = motion_run(profiled, error_get);
+    drive_pipeline.constants.drive_limits = limits;
+    drive_pipeline.pid_drive_profile_set(false);
+
+    char move[16];
+    snprintf(move, sizeof(move), "%.0f in", distance);
+    row_print(move, "PID + slew", pid, pid);
+    row_print(move, "trapezoid", trapezoid, pid);
+    row_print(move, "S-curve", s_curve, pid);
+  }
+}
+
+static void turns_bench() {
+  header_print("turn to a heading, error in degrees");
+  for (double angle : {45.0, 90.0, 180.0}) {
+    auto error_get = [angle](const sim::world& w) { return w.theta - angle; };
+    auto turn = [angle]() { drive_pipeline.pid_turn_set(angle, SPEED); };
+
+    drive_pipeline.pid_turn_profile_set(false);
+    result pid = motion_run(turn, error_get);
+    drive_pipeline.pid_turn_profile_set(true);
+    result profiled = motion_run(turn, error_get);
+    drive_pipeline.pid_turn_profile_set(false);
+
+    char move[16];
+    snprintf(move, sizeof(move), "%.0f deg", angle);
+    row_print(move, "PID", pid, pid);
+    row_print(move, "profiled", profiled, pid);
+  }
+}
+
+// Every motion mode with only the exit timers, then with predictive settling
+static void settle_bench() {
+  header_print("exit timers against predictive settling");
+  struct move {
+    const char* name;
+    bool profiled;
+    std::function<void()> start;
+    std::function<double(const sim::world&)> error_get;
+  };
+  const move MOVES[] = {
+      {"24 in", false, []() { drive_pipeline.pid_drive_set(24.0, SPEED, true); }, [](const sim::world& w) { return w.y - 24.0; }},
+      {"24 in", true, []() { drive_pipeline.pid_drive_set(24.0, SPEED); }, [](const sim::world& w) { return w.y - 24.0; }},
+      {"90 deg", false, []() { drive_pipeline.pid_turn_set(90.0, SPEED); }, [](const sim::world& w) { return w.theta - 90.0; }},
+      {"90 deg", true, []() { drive_pipeline.pid_turn_set(90.0, SPEED); }, [](const sim::world& w) { return w.theta - 90.0; }},
+      {"odom", false, []() { drive_pipeline.pid_odom_set({{12.0, 24.0}, ez::fwd, SPEED}); }, [](const sim::world& w) { return hypot(w.x - 12.0, w.y - 24.0); }},
+  };
+  for (auto& m : MOVES) {
+    drive_pipeline.pid_drive_profile_set(m.profiled);
+    drive_pipeline.pid_turn_profile_set(m.profiled);
+    drive_pipeline.pid_settle_predict_set(false);
+    result timers = motion_run(m.start, m.error_get);
+    drive_pipeline.pid_settle_predict_set(true);
+    result predicted = motion_run(m.start, m.error_get);
+    drive_pipeline.pid_settle_predict_set(false);
+    drive_pipeline.pid_drive_profile_set(false);
+    drive_pipeline.pid_turn_profile_set(false);
+
+    row_print(m.name, m.profiled ? "profiled" : "PID", timers, timers);
+    row_print(m.name, m.profiled ? "profiled, pred" : "PID, pred", predicted, timers);
+  }
+}
+
+// Gains for short and long motions, the schedule a team would tune for this drive
+static const std::vector<control::gain_point> DRIVE_SCHEDULE = {
+    {2.0, 110, {40.0, 0.0, 150.0, 0.0}},
+    {12.0, 110, {25.0, 0.0, 110.0, 0.0}},
+    {48.0, 110, {20.0, 0.0, 100.0, 0.0}},
+};
+static const std::vector<control::gain_point> TURN_SCHEDULE = {
+    {15.0, 110, {6.0, 0.05, 25.0, 15.0}},
+    {90.0, 110, {4.0, 0.05, 20.0, 15.0}},
+};
+
+// One set of constants against a schedule by motion size
+static void schedule_bench() {
+  header_print("single constants against a gain schedule");
+  for (double distance : {2.0, 6.0, 24.0, 70.0}) {
+    auto error_get = [distance](const sim::world& w) { return w.y - distance; };
+    auto drive = [distance]() { drive_pipeline.pid_drive_set(distance, SPEED); };
+    result single = motion_run(drive, error_get);
+    drive_pipeline.pid_drive_constants_set(DRIVE_SCHEDULE);
+    result scheduled = motion_run(drive, error_get);
+    drive_pipeline.pid_drive_constants_set({});
+
+    char move[16];
+    snprintf(move, sizeof(move), "%.0f in", distance);
+    row_print(move, "single", single, single);
+    row_print(move, "scheduled", scheduled, single);
+  }
+  for (double angle : {15.0, 45.0, 180.0}) {
+    auto error_get = [angle](const sim::world& w) { return w.theta - angle; };
+    auto turn = [angle]() { drive_pipeline.pid_turn_set(angle, SPEED); };
+    result single = motion_run(turn, error_get);
+    drive_pipeline.pid_turn_constants_set(TURN_SCHEDULE);
+    result scheduled = motion_run(turn, error_get);
+    drive_pipeline.pid_turn_constants_set({});
+
+    char move[16];
+    snprintf(move, sizeof(move), "%.0f deg", angle);
+    row_print(move, "single", single, single);
+    row_print(move, "scheduled", scheduled, single);
+  }
+}
+
+// Encoders read whole counts, so the raw derivative steps by a count at a time.  Same gains with the derivative
+// unfiltered, through a first order filter, and through a biquad, for the default drive constants and a hotter tune
+static void derivative_bench() {
+  printf("derivative filters on whole encoder counts, error in inches\n  %-8s %-18s %9s %8s %9s  %s\n", "move", "mode", "time", "error", "overshoot", "exit");
+  struct mode {
+    const char* name;
+    control::derivative_constants d;
+  };
+  const mode MODES[] = {
+      {"unfiltered", {}},
+      {"first order", {false, control::DERIVATIVE_FIRST_ORDER, DERIVATIVE_CUTOFF}},
+      {"biquad", {false, control::DERIVATIVE_BIQUAD, DERIVATIVE_CUTOFF}},
+  };
+  ez::PID drive = drive_pipeline.constants.drive;
+  for (double kp : {20.0, 30.0}) {
+    drive_pipeline.constants.drive.constants_set(kp, 0.0, 100.0);
+    for (double distance : {6.0, 24.0, 48.0}) {
+      auto error_get = [distance](const sim::world& w) { return w.y - distance; };
+      auto start = [distance]() { drive_pipeline.pid_drive_set(distance, SPEED); };
+      std::vector<result> results;
+      for (auto& m : MODES) {
+        drive_pipeline.pid_derivative_set(m.d);
+        results.push_back(motion_run(start, error_get, error_get));
+      }
+      drive_pipeline.pid_derivative_set({});
+
+      char move[16];
+      snprintf(move, sizeof(move), "%.0f in", distance);
+      char mode[32];
+      for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+        snprintf(mode, sizeof(mode), "kp %.0f %s", kp, MODES[i].name);
+        printf("  %-8s %-18s %7.3f s %8.2f %9.2f  %-9s", move, mode, r.time, r.error, r.peak, r.exit.c_str());
+        if (i > 0) printf(" %+6.1f%%", (r.time - results[0].time) / results[0].time * 100.0);
+        printf("\n");
+      }
+    }
+  }
+  drive_pipeline.constants.drive = drive;
+}
+
+// Each derivative mode gets the fastest drive tune that stays under the same overshoot on every distance, so modes are
+// compared by time at equal overshoot instead of at equal gains.  Run on whole encoder counts, about 0.02 in, and on an
+// encoder 5 times coarser, with the default 1 in small exit and a tighter 0.25 in one
+static void derivative_tune_bench() {
+  const double OVERSHOOT = 0.25;  // in
+  const double DISTANCES[] = {6.0, 24.0, 48.0};
+  printf("fastest drive tune under %.2f in of overshoot on 6, 24 and 48 in, time is the average drive\n", OVERSHOOT);
+  printf("  %-8s %-6s %-12s %5s %5s %9s %9s\n", "encoder", "exit", "mode", "kp", "kd", "time", "overshoot");
+  struct mode {
+    const char* name;
+    control::derivative_constants d;
+  };
+  const mode MODES[] = {
+      {"unfiltered", {}},
+      {"first order", {false, control::DERIVATIVE_FIRST_ORDER, DERIVATIVE_CUTOFF}},
+      {"biquad", {false, control::DERIVATIVE_BIQUAD, DERIVATIVE_CUTOFF}},
+  };
+  ez::PID drive = drive_pipeline.constants.drive;
+  for (int step : {1, 5}) {
+    encoder_step = step;
+    for (double small_error : {1.0, 0.25}) {
+      double base = 0.0;
+      for (auto& m : MODES) {
+        drive_pipeline.pid_derivative_set(m.d);
+        double best_time = INFINITY, best_kp = 0.0, best_kd = 0.0, best_overshoot = 0.0;
+        for (double kp = 15.0; kp <= 45.0; kp += 5.0) {
+          for (double kd = 60.0; kd <= 240.0; kd += 30.0) {
+            drive_pipeline.constants.drive.constants_set(kp, 0.0, kd);
+            drive_pipeline.constants.drive.exit_condition_set(90, small_error, 250, 3, 500, 500);
+            double time = 0.0, overshoot = 0.0;
+            bool finished = true;
+            for (double distance : DISTANCES) {
+              auto error_get = [distance](const sim::world& w) { return w.y - distance; };
+              result r = motion_run([distance]() { drive_pipeline.pid_drive_set(distance, SPEED); }, error_get, error_get);
+              finished = finished && r.exit != "Timed out";
+              time += r.time / std::size(DISTANCES);
+              overshoot = fmax(overshoot, r.peak);
+            }
+            if (finished && overshoot <= OVERSHOOT && time < best_time) {
+              best_time = time;
+              best_kp = kp;
+              best_kd = kd;
+              best_overshoot = overshoot;
+            }
+          }
+        }
+        if (&m == &MODES[0]) base = best_time;
+        char encoder[16], exit[16];
+        snprintf(encoder, sizeof(encoder), "%.2f in", 0.0204 * step);
+        snprintf(exit, sizeof(exit), "%.2f", small_error);
+        printf("  %-8s %-6s %-12s %5.0f %5.0f %7.3f s %9.2f", encoder, exit, m.name, best_kp, best_kd, best_time, best_overshoot);
+        if (&m != &MODES[0]) printf(" %+6.1f%%", (best_time - base) / base * 100.0);
+        printf("\n");
+      }
+    }
+  }
+  drive_pipeline.pid_derivative_set({});
+  drive_pipeline.constants.drive = drive;
+  encoder_step = 1;
+}
+
+// No slew, ez::slew's distance ramp, and time-based slew with and without a jerk limit
+static void slew_bench() {
+  printf("slew modes on short and long drives, error in inches\n  %-8s %-14s %9s %8s %11s  %s\n", "move", "mode", "time", "error", "peak |accel|", "exit");
+  struct mode {
+    const char* name;
+    bool slew_on;
+    control::slew_limits limits;
+  };
+  const mode MODES[] = {
+      {"no slew", false, {}},
+      {"distance", true, {}},
+      {"time", true, {SLEW_ACCELERATION, 0.0}},
+      {"time + jerk", true, {SLEW_ACCELERATION, SLEW_JERK}},
+  };
+  for (double distance : {6.0, 12.0, 24.0, 48.0}) {
+    auto error_get = [distance](const sim::world& w) { return w.y - distance; };
+    std::vector<result> results;
+    for (auto& m : MODES) {
+      drive_pipeline.slew_drive_constants_set(m.limits);
+      // Acceleration in in/s^2 from the change in velocity each tick, speeding up or slowing down
+      double last = 0.0;
+      auto accel_get = [&last](const sim::world& w) {
+        double output = fabs(w.velocity - last) / (ez::util::DELAY_TIME / 1000.0);
+        last = w.velocity;
+        return output;
+      };
+      bool slew_on = m.slew_on;
+      results.push_back(motion_run([distance, slew_on]() { drive_pipeline.pid_drive_set(distance, SPEED, slew_on); }, error_get, accel_get));
+    }
+    drive_pipeline.slew_drive_constants_set({});
+
+    char move[16];
+    snprintf(move, sizeof(move), "%.0f in", distance);
+    for (size_t i = 0; i < results.size(); i++) {
+      const result& r = results[i];
+      printf("  %-8s %-14s %7.3f s %8.2f %7.0f in/s2  %-9s", move, MODES[i].name, r.time, r.error, r.peak, r.exit.c_str());
+      if (i > 0) printf(" %+6.1f%%", (r.time - results[0].time) / results[0].time * 100.0);
+      printf("\n");
+    }
+  }
+}
+
+// Holds each side at a fixed power for a while, to sweep fast arcs
+class arc_motion : public control::motion {
+ public:
+  arc_motion(double left, double right, int ticks) : left(left), right(right), ticks(ticks) {}
+  ez::pose end_get(const ez::pose& start) override { return start; }
+  void initialize(const control::drive_state& state) override {}
+  control::drive_output iterate(const control::drive_state& state) override {
+    ticks--;
+    return {left, right};
+  }
+  ez::exit_output exit_condition() override { return ticks > 0 ? ez::RUNNING : ez::SMALL_EXIT; }
+  const char* name_get() override { return "arc"; }
+
+ private:
+  double left, right;
+  int ticks;
+};
+
+// Swings from one hard arc to its mirror every few ticks, so the turn rate keeps reversing
+class slalom_motion : public control::motion {
+ public:
+  slalom_motion(double fast, double slow, int swing, int ticks) : fast(fast), slow(slow), swing(swing), ticks(ticks) {}
+  ez::pose end_get(const ez::pose& start) override { return start; }
+  void initialize(const control::drive_state& state) override {}
+  control::drive_output iterate(const control::drive_state& state) override {
+    bool right = (ticks-- / swing) % 2 == 0;
+    return right ? control::drive_output{fast, slow} : control::drive_output{slow, fast};
+  }
+  ez::exit_output exit_condition() override { return ticks > 0 ? ez::RUNNING : ez::SMALL_EXIT; }
+  const char* name_get() override { return "slalom"; }
+
+ private:
+  double fast, slow;
+  int swing;
+  int ticks;
+};
+
+// Odometry in the 10 ms control tick, then in its own task at 5 and 2 ms, on paths that turn hundreds of deg/s.  Euler
+// steps assume the robot drove straight, the midpoint arc assumes it turned at one rate, so both get better with
+// shorter steps but Euler has far more to gain
+static void odom_rate_bench() {
+  printf("odometry period on fast turning paths, 1.5 s each, odom error against the true pose\n  %-16s %-10s %-8s %10s %10s %10s\n",
+         "path", "integrator", "period", "worst", "final", "peak rate");
+  struct path {
+    const char* name;
+    double fast, slow;
+    int swing;  // ticks per arc, 0 for one arc the whole way
+  };
+  const path PATHS[] = {
+      {"arc 127 / 0", 127, 0, 0},
+      {"arc 127 / -100", 127, -100, 0},
+      {"slalom 127 / -60", 127, -60, 20},
+  };
+  const control::odom_integrator INTEGRATORS[] = {control::ODOM_EULER, control::ODOM_MIDPOINT};
+  control::wheel_odometry* odometry = sim_backend.odometry_get();
+
+  // Where the robot truly was every time the world stepped, which is every time a task woke up to read sensors.  Poses
+  // are checked against the truth when their sensors were read, so a pose published 10 ms ago isn't counted as error
+  std::map<uint64_t, ez::pose> truth;
+  sim::world& w = sim::world::get();
+  sim::kernel::get().world_set([&w, &truth](uint64_t us) {
+    w.step_to(us);
+    truth[us] = {w.x, w.y, w.theta};
+  });
+  auto error_get = [&truth](const sim::world&) {
+    control::pose_snapshot odom = drive_pipeline.odom_pose_get();
+    auto found = truth.find(odom.timestamp);
+    return found == truth.end() ? 0.0 : ez::util::distance_to_point(odom.pose, found->second);
+  };
+
+  for (auto& p : PATHS) {
+    for (auto integrator : INTEGRATORS) {
+      odometry->integrator_set(integrator);
+      double base = 0.0;
+      for (int period : {0, 5, 2}) {
+        drive_pipeline.odom_period_set(period);
+        truth.clear();
+        double rate = 0.0;
+        auto worst_get = [&rate, &error_get](const sim::world& w) {
+          rate = fmax(rate, fabs(w.angular_velocity));
+          return error_get(w);
+        };
+        const path& q = p;
+        result r = motion_run([&q]() {
+          if (q.swing > 0)
+            drive_pipeline.motion_set(std::make_unique<slalom_motion>(q.fast, q.slow, q.swing, 150));
+          else
+            drive_pipeline.motion_set(std::make_unique<arc_motion>(q.fast, q.slow, 150));
+        }, error_get, worst_get);
+
+        char mode[16];
+        snprintf(mode, sizeof(mode), "%d ms", period == 0 ? ez::util::DELAY_TIME : period);
+        printf("  %-16s %-10s %-8s %7.4f in %7.4f in %5.0f deg/s", p.name, integrator == control::ODOM_EULER ? "euler" : "midpoint",
+               mode, r.peak, r.error, rate);
+        if (period == 0)
+          base = r.peak;
+        else if (base > 0.0)
+          printf("  %4.0f%% less", (1.0 - r.peak / base) * 100.0);
+        printf("\n");
+      }
+    }
+  }
+  sim::kernel::get().world_set([&w](uint64_t us) { w.step_to(us); });
+  drive_pipeline.odom_period_set(0);
+  odometry->integrator_set(control::ODOM_MIDPOINT);
+}
+
+// Where the robot truly was each tick, by the tick's sensor timestamp
+struct truth_sample {
+  uint64_t timestamp;
+  ez::pose pose;
+};
+static std::vector<truth_sample> truth;
+
+class truth_arc_motion : public arc_motion {
+ public:
+  using arc_motion::arc_motion;
+  control::drive_output iterate(const control::drive_state& state) override {
+    const sim::world& w = sim::world::get();
+    truth.push_back({state.timestamp, {w.x, w.y, w.theta}});
+    return arc_motion::iterate(state);
+  }
+};
+
+// A GPS fix that arrives late, used as the current pose as is and then carried forward through the pose history
+static void latency_bench() {
+  printf("delayed absolute fix at the end of a 1 s move, error against the true pose\n  %-12s %-8s %18s %18s\n", "move", "delay",
+         "used as is", "propagated");
+  const double MOVES[][2] = {{127, 127}, {127, 60}, {127, -127}};
+  for (auto& move : MOVES) {
+    for (int delay : {20, 50, 100}) {
+      double left = move[0], right = move[1];
+      truth.clear();
+      ez::pose error, propagated;
+      auto error_get = [delay, &error, &propagated](const sim::world& w) {
+        // The fix is wherever the robot truly was a few ticks back, the error is against the last tick's true pose
+        const truth_sample& now = truth.back();
+        const truth_sample& fix = truth[truth.size() - 1 - delay / ez::util::DELAY_TIME];
+        ez::pose carried;
+        drive_pipeline.odom_pose_propagate(fix.pose, fix.timestamp, carried);
+        error = {ez::util::distance_to_point(fix.pose, now.pose), 0.0, fabs(ez::util::wrap_angle(fix.pose.theta - now.pose.theta))};
+        propagated = {ez::util::distance_to_point(carried, now.pose), 0.0, fabs(ez::util::wrap_angle(carried.theta - now.pose.theta))};
+        return propagated.x;
+      };
+      motion_run([left, right]() { drive_pipeline.motion_set(std::make_unique<truth_arc_motion>(left, right, 100)); }, error_get);
+
+      char name[16], mode[16];
+      snprintf(name, sizeof(name), "%.0f / %.0f", move[0], move[1]);
+      snprintf(mode, sizeof(mode), "%d ms", delay);
+      printf("  %-12s %-8s %6.2f in %5.1f deg %6.3f in %5.2f deg\n", name, mode, error.x, error.theta, propagated.x, propagated.theta);
+    }
+  }
+}
+
+int main() {
+  sim::robot_init();
+  drives_bench();
+  printf("\n");
+  turns_bench();
+  printf("\n");
+  settle_bench();
+  printf("\n");
+  schedule_bench();
+  printf("\n");
+  derivative_bench();
+  printf("\n");
+  derivative_tune_bench();
+  printf("\n");
+  slew_bench();
+  printf("\n");
+  odom_rate_bench();
+  printf("\n");
+  latency_bench();
+  return 0;
+}
@@ -0,0 +1,220 @@
+// Finds tracking wheel offsets by least squares, on the simulated robot or from a flight recording.
+//
+//   make -C sim
+//   sim/calibrate                          compares offsets_measure() with ten averaged turns, 10 seeds
+//   sim/calibrate --seeds 50 --noise 0.3   more seeds, noisier IMU
+//   sim/calibrate run.bin                  fits the trackers in a recording
+//   sim/calibrate run.bin --from 2 --to 6  fits just the part of it from 2 s to 6 s in
+//
+// The simulated robot has a tracker 3.5 in left of center, one 4.25 in right and one 2.75 in behind, and an IMU with
+// noise on every heading reading that lags the trackers by 10 ms.  Ten averaged turns is measure_offsets() in
+// src/autons.cpp: turn 90 deg with PID, wait 250 ms, divide each tracker by the turn, ten times alternating direction.
+// Errors are against the true offsets, times are simulated.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cmath>
+#include <deque>
+#include <random>
+
+#include "control/flight_recorder.hpp"
+#include "control/offset_calibration.hpp"
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "world.hpp"
+
+static const sim::tracker_config TRACKERS[] = {
+    {11, false, false, 2.75, -3.5},  // left
+    {12, false, false, 2.75, 4.25},  // right
+    {13, false, true, 2.75, -2.75},  // back
+};
+
+// What each tracker rolls per radian of clockwise turn.  Vertical wheels right of center roll backward
+static double truth(const sim::tracker_config& t) { return t.horizontal ? t.offset : -t.offset; }
+
+static double inches(const pros::Rotation& sensor) { return sensor.get_position() / 36000.0 * 2.75 * M_PI; }
+
+// The sim drive with tracking wheels, and an IMU that's noisy and late like a real one
+class tracked_backend : public control::devices_backend {
+ public:
+  pros::Rotation left{11}, right{12}, back{13};
+  double noise = 0.1;  // deg
+  int lag = 10;        // ms
+  std::mt19937 random;
+
+  tracked_backend() : devices_backend({4, 2, -3}, {-10, -9, 8}, 6, 3.25, 360) {}
+
+  control::drive_snapshot capture(bool batch) override {
+    control::drive_snapshot output = devices_backend::capture(batch);
+    output.tracker_left = inches(left);
+    output.tracker_right = inches(right);
+    output.tracker_back = inches(back);
+
+    // Hand back the IMU from lag ago
+    imu_readings.push_back({output.timestamp, output.imu, output.imu_rate});
+    while (imu_readings.size() > 1 && imu_readings[1].timestamp + lag * 1000 <= output.timestamp) imu_readings.pop_front();
+    output.imu = imu_readings.front().imu + heading_noise();
+    output.imu_rate = imu_readings.front().rate;
+    return output;
+  }
+
+  double heading_noise() { return std::normal_distribution<double>(0.0, noise)(random); }
+
+ private:
+  struct imu_reading {
+    uint64_t timestamp;
+    double imu;
+    double rate;
+  };
+  std::deque<imu_reading> imu_readings;
+};
+
+static tracked_backend* tracked;
+
+struct run_result {
+  double error[3];  // in, against the truth for each tracker
+  double time;      // s
+};
+
+static void start(unsigned seed) {
+  sim::drivetrain_config config;
+  config.trackers.assign(std::begin(TRACKERS), std::end(TRACKERS));
+  sim::robot_reset();
+  sim::world::get().reset(config);
+  tracked->random.seed(seed);
+}
+
+// Least squares over a few seconds of spinning
+static run_result fit_run(unsigned seed) {
+  start(seed);
+  uint64_t begin = sim::kernel::get().micros_get();
+  control::offset_calibration calibration;
+  control::offset_calibration_result result = control::offsets_measure(*tracked, calibration);
+  run_result output;
+  output.time = (sim::kernel::get().micros_get() - begin) / 1e6;
+  const control::offset_fit* fits[3] = {&result.left, &result.right, &result.back};
+  for (int i = 0; i < 3; i++) output.error[i] = fits[i]->offset - truth(TRACKERS[i]);
+  return output;
+}
+
+// measure_offsets(), ten 90 degree turns each way with the tracker divided by the turn
+static run_result average_run(unsigned seed) {
+  start(seed);
+  uint64_t begin = sim::kernel::get().micros_get();
+  pros::Rotation* sensors[3] = {&tracked->left, &tracked->right, &tracked->back};
+  double sums[3] = {0.0, 0.0, 0.0};
+  const int ITERATIONS = 10;
+  for (int i = 0; i < ITERATIONS; i++) {
+    for (auto sensor : sensors) sensor->reset_position();
+    double imu_start = sim_backend.imu_get() + tracked->heading_noise();
+    drive_pipeline.enable();
+    drive_pipeline.pid_turn_set(i % 2 == 0 ? 90.0 : 0.0, 63, ez::raw);
+    drive_pipeline.pid_wait();
+    drive_pipeline.disable();
+    pros::delay(250);
+    double turn = ez::util::to_rad(fabs(sim_backend.imu_get() + tracked->heading_noise() - imu_start));
+    for (int j = 0; j < 3; j++) sums[j] += (i % 2 == 0 ? 1.0 : -1.0) * inches(*sensors[j]) / turn;
+  }
+  run_result output;
+  output.time = (sim::kernel::get().micros_get() - begin) / 1e6;
+  for (int i = 0; i < 3; i++) output.error[i] = sums[i] / ITERATIONS - truth(TRACKERS[i]);
+  return output;
+}
+
+static void compare(int seeds, double noise, int lag) {
+  tracked->noise = noise;
+  tracked->lag = lag;
+  printf("trackers left %.2f right %.2f back %.2f in, IMU noise %.2f deg, lag %d ms, %d seeds\n", truth(TRACKERS[0]),
+         truth(TRACKERS[1]), truth(TRACKERS[2]), noise, lag, seeds);
+  printf("  %-18s %8s %10s %10s %10s\n", "method", "time", "left", "right", "back");
+  const char* NAMES[] = {"ten turns averaged", "least squares"};
+  for (int method = 0; method < 2; method++) {
+    double rms[3] = {0.0, 0.0, 0.0}, worst[3] = {0.0, 0.0, 0.0}, time = 0.0;
+    for (int seed = 1; seed <= seeds; seed++) {
+      run_result r = method == 0 ? average_run(seed) : fit_run(seed);
+      time += r.time / seeds;
+      for (int i = 0; i < 3; i++) {
+        rms[i] += r.error[i] * r.error[i] / seeds;
+        worst[i] = fmax(worst[i], fabs(r.error[i]));
+      }
+    }
+    printf("  %-18s %6.1f s", NAMES[method], time);
+    for (int i = 0; i < 3; i++) printf(" %7.4f in", sqrt(rms[i]));
+    printf("   RMS error\n  %-18s %8s", "", "");
+    for (int i = 0; i < 3; i++) printf(" %7.4f in", worst[i]);
+    printf("   worst\n");
+  }
+
+  // One run's report, the way the brain prints it
+  printf("\n");
+  start(1);
+  control::offset_calibration calibration;
+  control::offsets_measure(*tracked, calibration);
+  calibration.print();
+}
+
+static int recording_fit(const char* path, double from, double to) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    printf("couldn't open %s\n", path);
+    return 1;
+  }
+  control::flight_header header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "FLIGHT\0\0", sizeof(header.magic)) != 0 ||
+      header.version != control::flight_recorder::VERSION || header.record_size != sizeof(control::flight_record)) {
+    printf("%s isn't a flight recording this can read\n", path);
+    fclose(file);
+    return 1;
+  }
+
+  // Seconds since the first record, timestamps wrap every 71 minutes so add up the steps
+  control::offset_calibration calibration;
+  control::flight_record record;
+  bool first = true;
+  uint32_t last = 0;
+  double seconds = 0.0;
+  while (fread(&record, sizeof(record), 1, file) == 1) {
+    if (!first) seconds += (uint32_t)(record.timestamp - last) / 1e6;
+    first = false;
+    last = record.timestamp;
+    if (record.type == control::FLIGHT_UPDATE && seconds >= from && seconds <= to) calibration.add(control::flight_snapshot(record));
+  }
+  fclose(file);
+  printf("%s: %.2f s, fitting from %.2f s to %.2f s\n", path, seconds, from, fmin(to, seconds));
+  calibration.print();
+  return calibration.solve().solved ? 0 : 2;
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  int seeds = 10;
+  double noise = 0.1;
+  int lag = 10;
+  double from = 0.0, to = INFINITY;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+      seeds = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--noise") == 0 && i + 1 < argc) {
+      noise = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--lag") == 0 && i + 1 < argc) {
+      lag = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+      from = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) {
+      to = atof(argv[++i]);
+    } else if (!path && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      printf("usage: %s [file [--from s] [--to s]] [--seeds n] [--noise deg] [--lag ms]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (path) return recording_fit(path, from, to);
+
+  sim::robot_init();
+  tracked_backend backend;
+  tracked = &backend;
+  compare(seeds, noise, lag);
+  return 0;
+}
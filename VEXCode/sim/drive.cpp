@@ -0,0 +1,446 @@
+// Host stand-in for ez::Drive.  EZ-Template only ships as a prebuilt ARM library, so the ez::Drive calls the autons make
+// run here through the pipeline the drive is attached to, in place of EZ-Template's autonomous task.  Drives, turns and
+// odom motions are the pipeline's, which follow EZ-Template's closely, with the constants the autons set on the drive.
+// Swings aren't in the pipeline and are a motion of their own here.
+
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+#include "control/ez_backend.hpp"
+#include "control/motions.hpp"
+#include "control/pid.hpp"
+#include "drive.hpp"
+
+using ez::Drive;
+
+namespace {
+// What a drive is attached to, and the last motion set on it for waits and speed changes
+struct attachment {
+  control::pipeline* pipeline = nullptr;
+  std::vector<sim::drive_wait> waits;
+  double start = 0.0;   // in the drive sensors read when a drive was set
+  double target = 0.0;  // in from start for drives, absolute deg for turns and swings
+  ez::e_angle_behavior behavior = ez::raw;
+};
+std::map<const Drive*, attachment> attachments;
+
+attachment& attachment_get(const Drive& drive) {
+  attachment& output = attachments[&drive];
+  if (!output.pipeline) throw std::logic_error("ez::Drive moved before sim::drive_attach()");
+  return output;
+}
+
+// Swings toward an absolute heading with one side while the other follows at a fixed speed, like ez::Drive's swing task
+class swing_motion : public control::motion {
+ public:
+  swing_motion(const control::motion_constants& constants, const ez::PID& swing, ez::e_swing side, double target, int speed, int opposite_speed, ez::e_angle_behavior behavior)
+      : swingPID(swing, constants.derivative, constants.period), side(side), target(target), speed(speed), opposite_speed(opposite_speed), behavior(behavior) {}
+
+  // Swings only aim for a heading, where the robot ends up along the arc isn't a target
+  ez::pose end_get(const ez::pose& start) override { return {start.x, start.y, target}; }
+
+  void initialize(const control::drive_state& state) override { swingPID.start(control::turn_target_get(target, state.imu, behavior), state.imu); }
+
+  control::drive_output iterate(const control::drive_state& state) override {
+    double out = ez::util::clamp(swingPID.compute(state.imu), speed);
+    if (exit == ez::RUNNING) exit = swingPID.exit_condition();
+    // The other side scales with the swinging side and goes the same way, for a wider arc
+    double opposite = speed > 0 ? opposite_speed * out / speed : 0.0;
+    if (side == ez::LEFT_SWING) return {out, opposite};
+    return {-opposite, -out};
+  }
+
+  ez::exit_output exit_condition() override { return exit; }
+  const char* name_get() override { return "swing"; }
+
+ private:
+  control::motion_pid swingPID;
+  ez::e_swing side;
+  double target;
+  int speed;
+  int opposite_speed;
+  ez::e_angle_behavior behavior;
+  ez::exit_output exit = ez::RUNNING;
+};
+
+// Drive sensors averaged, in, from the pipeline's last tick
+double traveled_get(control::pipeline& pipeline) {
+  control::drive_state state = pipeline.state_get();
+  return (state.left + state.right) / 2.0;
+}
+}  // namespace
+
+void sim::drive_attach(Drive& drive, control::pipeline& pipeline) { attachments[&drive].pipeline = &pipeline; }
+std::vector<sim::drive_wait> sim::drive_waits_get(Drive& drive) { return attachments[&drive].waits; }
+void sim::drive_waits_clear(Drive& drive) { attachments[&drive].waits.clear(); }
+
+namespace ez {
+/////
+// Setup
+/////
+Drive::Drive(std::vector<int> left_motor_ports, std::vector<int> right_motor_ports, int imu_port, double wheel_diameter, double ticks, double ratio)
+    : imu(imu_port), left_tracker(-1, -1, false), right_tracker(-1, -1, false), left_rotation(-1), right_rotation(-1), ez_auto([]() {
+        // Motions run in the pipeline, this is only here to be suspended and resumed
+        while (true) pros::Task::notify_take(true, TIMEOUT_MAX);
+      }) {
+  for (auto port : left_motor_ports)
+    left_motors.push_back(pros::Motor(port));
+  for (auto port : right_motor_ports)
+    right_motors.push_back(pros::Motor(port));
+  odom_tracker_left = odom_tracker_right = odom_tracker_front = odom_tracker_back = nullptr;
+  mode = DISABLE;
+  max_speed = 0;
+
+  // Motor encoders count in ticks, 50 per turn of a 3600 rpm motor
+  WHEEL_DIAMETER = wheel_diameter;
+  RATIO = ratio;
+  CARTRIDGE = ticks;
+  CIRCUMFERENCE = WHEEL_DIAMETER * M_PI;
+  TICK_PER_REV = (50.0 * (3600.0 / CARTRIDGE)) * RATIO;
+  TICK_PER_INCH = TICK_PER_REV / CIRCUMFERENCE;
+
+  // EZ-Template's defaults for what the autons don't set
+  odom_path_smooth_constants_set(0.75, 0.03, 0.0001);
+}
+
+void Drive::drive_mode_set(e_mode p_mode, bool stop_drive) {
+  mode = p_mode;
+  if (p_mode != DISABLE) return;
+  // Stopping EZ-Template's task is stopping the pipeline motions run in
+  control::pipeline& pipeline = *attachment_get(*this).pipeline;
+  if (pipeline.enabled()) pipeline.disable();
+  if (stop_drive) drive_set(0, 0);
+}
+e_mode Drive::drive_mode_get() { return mode; }
+
+/////
+// Devices
+/////
+void Drive::drive_set(int left, int right) {
+  for (auto& motor : left_motors)
+    motor.move(left);
+  for (auto& motor : right_motors)
+    motor.move(right);
+}
+
+void Drive::drive_brake_set(pros::motor_brake_mode_e_t brake_type) {
+  CURRENT_BRAKE = brake_type;
+  for (auto& motor : left_motors)
+    motor.set_brake_mode(brake_type);
+  for (auto& motor : right_motors)
+    motor.set_brake_mode(brake_type);
+}
+
+double Drive::drive_tick_per_inch() { return TICK_PER_INCH; }
+double Drive::drive_width_get() { return global_track_width; }
+
+void Drive::drive_sensor_reset() {
+  // The world forgets motor settings when it resets, so count in ticks again here
+  for (auto& motor : left_motors) {
+    motor.set_encoder_units(pros::E_MOTOR_ENCODER_COUNTS);
+    motor.tare_position();
+  }
+  for (auto& motor : right_motors) {
+    motor.set_encoder_units(pros::E_MOTOR_ENCODER_COUNTS);
+    motor.tare_position();
+  }
+}
+
+int Drive::drive_sensor_left_raw() { return left_motors.front().get_position(); }
+int Drive::drive_sensor_right_raw() { return right_motors.front().get_position(); }
+double Drive::drive_sensor_left() { return drive_sensor_left_raw() / drive_tick_per_inch(); }
+double Drive::drive_sensor_right() { return drive_sensor_right_raw() / drive_tick_per_inch(); }
+int Drive::drive_velocity_left() { return left_motors.front().get_actual_velocity(); }
+int Drive::drive_velocity_right() { return right_motors.front().get_actual_velocity(); }
+double Drive::drive_mA_left() { return left_motors.front().get_current_draw(); }
+double Drive::drive_mA_right() { return right_motors.front().get_current_draw(); }
+
+void Drive::drive_imu_reset(double new_heading) { imu.set_rotation(new_heading / IMU_SCALER); }
+double Drive::drive_imu_get() { return imu.get_rotation() * IMU_SCALER; }
+double Drive::drive_imu_scaler_get() { return IMU_SCALER; }
+
+void Drive::drive_angle_set(double angle) {
+  // Motions hold the heading the pipeline read when it was enabled, start over so the next one reads this one
+  control::pipeline& pipeline = *attachment_get(*this).pipeline;
+  if (pipeline.enabled()) pipeline.disable();
+  drive_imu_reset(angle);
+  pose current = odom_pose_get();
+  odom_pose_set({current.x, current.y, angle});
+}
+void Drive::drive_angle_set(okapi::QAngle p_angle) { drive_angle_set(p_angle.convert(okapi::degree)); }
+
+/////
+// Odometry, all in the pipeline
+/////
+pose Drive::odom_pose_get() { return attachment_get(*this).pipeline->odom_pose_current_get().pose; }
+
+void Drive::odom_pose_set(pose itarget) {
+  attachment_get(*this).pipeline->odom_pose_set(itarget);
+  odom_current = itarget;
+}
+
+void Drive::odom_xyt_set(double x, double y, double t) { odom_pose_set({x, y, t}); }
+void Drive::odom_xyt_set(okapi::QLength p_x, okapi::QLength p_y, okapi::QAngle p_t) {
+  odom_xyt_set(p_x.convert(okapi::inch), p_y.convert(okapi::inch), p_t.convert(okapi::degree));
+}
+double Drive::odom_theta_get() { return odom_pose_get().theta; }
+
+// The pipeline the drive is attached to runs odometry, this only catches odom_current up with it
+void Drive::ez_tracking_task() { odom_current = odom_pose_get(); }
+
+void Drive::odom_turn_bias_set(double bias) { odom_turn_bias_amount = bias; }
+double Drive::odom_turn_bias_get() { return odom_turn_bias_amount; }
+void Drive::odom_look_ahead_set(double distance) { LOOK_AHEAD = distance; }
+void Drive::odom_look_ahead_set(okapi::QLength p_distance) { odom_look_ahead_set(p_distance.convert(okapi::inch)); }
+double Drive::odom_look_ahead_get() { return LOOK_AHEAD; }
+double Drive::odom_path_spacing_get() { return SPACING; }
+void Drive::odom_boomerang_distance_set(double distance) { max_boomerang_distance = distance; }
+void Drive::odom_boomerang_distance_set(okapi::QLength p_distance) { odom_boomerang_distance_set(p_distance.convert(okapi::inch)); }
+double Drive::odom_boomerang_distance_get() { return max_boomerang_distance; }
+void Drive::odom_boomerang_dlead_set(double input) { dlead = input; }
+double Drive::odom_boomerang_dlead_get() { return dlead; }
+
+void Drive::odom_path_smooth_constants_set(double weight_smooth, double weight_data, double tolerance) {
+  odom_smooth_weight_smooth = weight_smooth;
+  odom_smooth_weight_data = weight_data;
+  odom_smooth_tolerance = tolerance;
+}
+std::vector<double> Drive::odom_path_smooth_constants_get() { return {odom_smooth_weight_smooth, odom_smooth_weight_data, odom_smooth_tolerance}; }
+
+/////
+// Constants
+/////
+void Drive::pid_drive_constants_set(double p, double i, double d, double p_start_i) {
+  forward_drivePID.constants_set(p, i, d, p_start_i);
+  backward_drivePID.constants_set(p, i, d, p_start_i);
+  fwd_rev_drivePID.constants_set(p, i, d, p_start_i);
+  // Odom motions drive with the same constants
+  xyPID.constants_set(p, i, d, p_start_i);
+}
+
+void Drive::pid_heading_constants_set(double p, double i, double d, double p_start_i) { headingPID.constants_set(p, i, d, p_start_i); }
+void Drive::pid_turn_constants_set(double p, double i, double d, double p_start_i) { turnPID.constants_set(p, i, d, p_start_i); }
+
+void Drive::pid_swing_constants_set(double p, double i, double d, double p_start_i) {
+  forward_swingPID.constants_set(p, i, d, p_start_i);
+  backward_swingPID.constants_set(p, i, d, p_start_i);
+  fwd_rev_swingPID.constants_set(p, i, d, p_start_i);
+  swingPID.constants_set(p, i, d, p_start_i);
+}
+
+void Drive::pid_odom_angular_constants_set(double p, double i, double d, double p_start_i) { odom_angularPID.constants_set(p, i, d, p_start_i); }
+void Drive::pid_odom_boomerang_constants_set(double p, double i, double d, double p_start_i) { boomerangPID.constants_set(p, i, d, p_start_i); }
+
+// Exit conditions in ms and the motion's own units, for each PID it applies to
+static void exit_condition_set(std::initializer_list<PID*> pids, okapi::QTime small_time, double small_error, okapi::QTime big_time,
+                               double big_error, okapi::QTime velocity_time, okapi::QTime mA_timeout) {
+  for (PID* pid : pids)
+    pid->exit_condition_set(small_time.convert(okapi::millisecond), small_error, big_time.convert(okapi::millisecond), big_error,
+                            velocity_time.convert(okapi::millisecond), mA_timeout.convert(okapi::millisecond));
+}
+
+void Drive::pid_drive_exit_condition_set(okapi::QTime p_small_exit_time, okapi::QLength p_small_error, okapi::QTime p_big_exit_time, okapi::QLength p_big_error, okapi::QTime p_velocity_exit_time, okapi::QTime p_mA_timeout, bool use_imu) {
+  exit_condition_set({&forward_drivePID, &backward_drivePID, &fwd_rev_drivePID}, p_small_exit_time, p_small_error.convert(okapi::inch),
+                     p_big_exit_time, p_big_error.convert(okapi::inch), p_velocity_exit_time, p_mA_timeout);
+}
+
+void Drive::pid_turn_exit_condition_set(okapi::QTime p_small_exit_time, okapi::QAngle p_small_error, okapi::QTime p_big_exit_time, okapi::QAngle p_big_error, okapi::QTime p_velocity_exit_time, okapi::QTime p_mA_timeout, bool use_imu) {
+  exit_condition_set({&turnPID}, p_small_exit_time, p_small_error.convert(okapi::degree), p_big_exit_time, p_big_error.convert(okapi::degree),
+                     p_velocity_exit_time, p_mA_timeout);
+}
+
+void Drive::pid_swing_exit_condition_set(okapi::QTime p_small_exit_time, okapi::QAngle p_small_error, okapi::QTime p_big_exit_time, okapi::QAngle p_big_error, okapi::QTime p_velocity_exit_time, okapi::QTime p_mA_timeout, bool use_imu) {
+  exit_condition_set({&forward_swingPID, &backward_swingPID, &fwd_rev_swingPID, &swingPID}, p_small_exit_time, p_small_error.convert(okapi::degree),
+                     p_big_exit_time, p_big_error.convert(okapi::degree), p_velocity_exit_time, p_mA_timeout);
+}
+
+void Drive::pid_odom_turn_exit_condition_set(okapi::QTime p_small_exit_time, okapi::QAngle p_small_error, okapi::QTime p_big_exit_time, okapi::QAngle p_big_error, okapi::QTime p_velocity_exit_time, okapi::QTime p_mA_timeout, bool use_imu) {
+  exit_condition_set({&odom_angularPID, &boomerangPID}, p_small_exit_time, p_small_error.convert(okapi::degree), p_big_exit_time,
+                     p_big_error.convert(okapi::degree), p_velocity_exit_time, p_mA_timeout);
+}
+
+void Drive::pid_odom_drive_exit_condition_set(okapi::QTime p_small_exit_time, okapi::QLength p_small_error, okapi::QTime p_big_exit_time, okapi::QLength p_big_error, okapi::QTime p_velocity_exit_time, okapi::QTime p_mA_timeout, bool use_imu) {
+  exit_condition_set({&xyPID}, p_small_exit_time, p_small_error.convert(okapi::inch), p_big_exit_time, p_big_error.convert(okapi::inch),
+                     p_velocity_exit_time, p_mA_timeout);
+}
+
+void Drive::pid_drive_chain_constant_set(double input) { drive_forward_motion_chain_scale = drive_backward_motion_chain_scale = fabs(input); }
+void Drive::pid_drive_chain_constant_set(okapi::QLength input) { pid_drive_chain_constant_set(input.convert(okapi::inch)); }
+void Drive::pid_turn_chain_constant_set(double input) { turn_motion_chain_scale = fabs(input); }
+void Drive::pid_turn_chain_constant_set(okapi::QAngle input) { pid_turn_chain_constant_set(input.convert(okapi::degree)); }
+void Drive::pid_swing_chain_constant_set(double input) { swing_forward_motion_chain_scale = swing_backward_motion_chain_scale = fabs(input); }
+void Drive::pid_swing_chain_constant_set(okapi::QAngle input) { pid_swing_chain_constant_set(input.convert(okapi::degree)); }
+
+void Drive::slew_drive_constants_set(okapi::QLength distance, int min_speed) {
+  slew_forward.constants_set(distance.convert(okapi::inch), min_speed);
+  slew_backward.constants_set(distance.convert(okapi::inch), min_speed);
+}
+void Drive::slew_turn_constants_set(okapi::QAngle distance, int min_speed) { slew_turn.constants_set(distance.convert(okapi::degree), min_speed); }
+void Drive::slew_swing_constants_set(okapi::QLength distance, int min_speed) {
+  slew_swing_forward.constants_set(distance.convert(okapi::inch), min_speed);
+  slew_swing_backward.constants_set(distance.convert(okapi::inch), min_speed);
+  slew_swing.constants_set(distance.convert(okapi::inch), min_speed);
+}
+
+void Drive::pid_angle_behavior_set(e_angle_behavior behavior) { default_turn_type = default_swing_type = default_odom_type = behavior; }
+e_angle_behavior Drive::pid_turn_behavior_get() { return default_turn_type; }
+
+/////
+// Motions
+/////
+// Starts the pipeline with the drive's constants if it isn't running, the way ez::Drive starts its task for a motion
+static control::pipeline& motion_start(Drive& drive, e_mode mode) {
+  control::pipeline& pipeline = *attachment_get(drive).pipeline;
+  if (!pipeline.enabled()) {
+    control::ez_backend(drive).constants_get(pipeline.constants);
+    pipeline.enable();
+  }
+  drive.mode = mode;
+  return pipeline;
+}
+
+void Drive::pid_targets_reset() {
+  // Drives hold the heading they read at enable(), so stop here and read the reset one next time
+  drive_mode_set(DISABLE);
+}
+
+void Drive::pid_drive_set(double target, int speed, bool slew_on, bool toggle_heading) {
+  // Drive motions always hold their heading, toggle_heading has nothing to turn off
+  control::pipeline& pipeline = motion_start(*this, DRIVE);
+  attachment& a = attachment_get(*this);
+  a.start = traveled_get(pipeline);
+  a.target = target;
+  max_speed = speed;
+  pipeline.pid_drive_set(target, speed, slew_on);
+}
+void Drive::pid_drive_set(double target, int speed) { pid_drive_set(target, speed, false, true); }
+void Drive::pid_drive_set(okapi::QLength p_target, int speed) { pid_drive_set(p_target.convert(okapi::inch), speed); }
+void Drive::pid_drive_set(okapi::QLength p_target, int speed, bool slew_on, bool toggle_heading) {
+  pid_drive_set(p_target.convert(okapi::inch), speed, slew_on, toggle_heading);
+}
+
+void Drive::pid_turn_set(double target, int speed, e_angle_behavior behavior) {
+  control::pipeline& pipeline = motion_start(*this, TURN);
+  attachment& a = attachment_get(*this);
+  a.target = target;
+  max_speed = speed;
+  a.behavior = behavior;
+  pipeline.pid_turn_set(target, speed, behavior);
+}
+void Drive::pid_turn_set(double target, int speed) { pid_turn_set(target, speed, default_turn_type); }
+void Drive::pid_turn_set(okapi::QAngle p_target, int speed) { pid_turn_set(p_target.convert(okapi::degree), speed); }
+
+void Drive::pid_swing_set(e_swing type, double target, int speed, int opposite_speed) {
+  control::pipeline& pipeline = motion_start(*this, SWING);
+  attachment& a = attachment_get(*this);
+  a.target = target;
+  max_speed = speed;
+  a.behavior = default_swing_type;
+  current_swing = type;
+  swing_opposite_speed = opposite_speed;
+  // Setting a turn first points later drives at the heading the swing ends on, the swing replaces it before it starts
+  pipeline.pid_turn_set(target, speed, default_swing_type);
+  pipeline.motion_set(std::make_unique<swing_motion>(pipeline.constants, swingPID, type, target, speed, opposite_speed, default_swing_type));
+}
+void Drive::pid_swing_set(e_swing type, okapi::QAngle p_target, int speed, int opposite_speed) {
+  pid_swing_set(type, p_target.convert(okapi::degree), speed, opposite_speed);
+}
+
+void Drive::pid_odom_set(double target, int speed, bool slew_on) {
+  // Straight ahead from where the robot is, to a point so odometry corrects the error
+  control::pipeline& pipeline = motion_start(*this, POINT_TO_POINT);
+  pose current = pipeline.odom_pose_get().pose;
+  double angle = util::to_rad(current.theta);
+  max_speed = speed;
+  pipeline.pid_odom_set(odom{{current.x + target * sin(angle), current.y + target * cos(angle), ANGLE_NOT_SET}, target < 0 ? rev : fwd, speed}, slew_on);
+}
+void Drive::pid_odom_set(okapi::QLength p_target, int speed) { pid_odom_set(p_target.convert(okapi::inch), speed, false); }
+void Drive::pid_odom_set(okapi::QLength p_target, int speed, bool slew_on) { pid_odom_set(p_target.convert(okapi::inch), speed, slew_on); }
+
+void Drive::pid_odom_set(united_odom p_imovement, bool slew_on) {
+  control::pipeline& pipeline = motion_start(*this, POINT_TO_POINT);
+  max_speed = p_imovement.max_xy_speed;
+  pipeline.pid_odom_set(p_imovement, slew_on);
+}
+
+void Drive::pid_odom_set(std::vector<united_odom> p_imovements, bool slew_on) {
+  control::pipeline& pipeline = motion_start(*this, PURE_PURSUIT);
+  pipeline.pid_odom_set(p_imovements, slew_on);
+}
+
+void Drive::pid_speed_max_set(int speed) {
+  // Motions take their speed when they're made, so the rest of a drive or turn starts over at the new speed.  Odom
+  // motions keep theirs
+  attachment& a = attachment_get(*this);
+  control::pipeline& pipeline = *a.pipeline;
+  max_speed = speed;
+  if (!pipeline.enabled() || pipeline.exit_get() != RUNNING) return;
+  if (mode == DRIVE)
+    pipeline.pid_drive_set(a.target - (traveled_get(pipeline) - a.start), speed);
+  else if (mode == TURN)
+    pipeline.pid_turn_set(a.target, speed, a.behavior);
+}
+
+/////
+// Waits
+/////
+void Drive::pid_wait() {
+  control::pipeline& pipeline = *attachment_get(*this).pipeline;
+  pipeline.pid_wait();
+  exit_output exit = pipeline.exit_get();
+  interfered = exit == VELOCITY_EXIT || exit == mA_EXIT;
+  // The motion that exited is the last one in the history
+  size_t size = pipeline.history_get().size();
+  attachment_get(*this).waits.push_back({"pid_wait", size > 0 ? size - 1 : 0, exit});
+}
+
+void Drive::pid_wait_until(double target) {
+  // Waits until the drive sensors or the IMU pass target, measured the way the motion is
+  attachment& a = attachment_get(*this);
+  control::pipeline& pipeline = *a.pipeline;
+  while (pipeline.enabled() && pipeline.exit_get() == RUNNING) {
+    if (mode == DRIVE) {
+      double traveled = traveled_get(pipeline) - a.start;
+      if (target >= 0 ? traveled >= target : traveled <= target) return;
+    } else if (mode == TURN || mode == SWING) {
+      control::drive_state state = pipeline.state_get();
+      if ((a.target - target) * (state.imu - target) >= 0.0) return;
+    } else {
+      break;
+    }
+    pros::delay(util::DELAY_TIME);
+  }
+}
+void Drive::pid_wait_until(okapi::QLength target) { pid_wait_until(target.convert(okapi::inch)); }
+
+void Drive::pid_wait_quick_chain() {
+  // ez::Drive pushes the target out by the chain constant and moves on once the robot passes the real one.  Motions
+  // here keep their target, so this moves on once the robot is within the chain constant of it
+  attachment& a = attachment_get(*this);
+  control::pipeline& pipeline = *a.pipeline;
+  if (mode == DRIVE || mode == TURN || mode == SWING) {
+    while (pipeline.enabled() && pipeline.exit_get() == RUNNING) {
+      double error, chain;
+      if (mode == DRIVE) {
+        error = a.target - (traveled_get(pipeline) - a.start);
+        chain = a.target >= 0 ? drive_forward_motion_chain_scale : drive_backward_motion_chain_scale;
+      } else {
+        double imu = pipeline.state_get().imu;
+        error = control::turn_target_get(a.target, imu, a.behavior) - imu;
+        chain = mode == TURN ? turn_motion_chain_scale : swing_forward_motion_chain_scale;
+      }
+      if (fabs(error) < chain) break;
+      pros::delay(util::DELAY_TIME);
+    }
+  } else {
+    pipeline.pid_wait();
+  }
+  // A chained motion ends when the next one replaces it, it goes in the history then
+  exit_output exit = pipeline.exit_get();
+  size_t size = pipeline.history_get().size();
+  attachment_get(*this).waits.push_back({"quick chain", exit == RUNNING ? size : (size > 0 ? size - 1 : 0), exit});
+}
+
+void Drive::pid_wait_until_index(int index) { attachment_get(*this).pipeline->pid_wait_until_index(index); }
+}  // namespace ez
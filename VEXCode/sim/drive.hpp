@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "EZ-Template/drive/drive.hpp"
+#include "control/pipeline.hpp"
+
+namespace sim {
+/**
+ * One pid_wait() or pid_wait_quick_chain() on a drive.
+ */
+struct drive_wait {
+  const char* call;      // "pid_wait" or "quick chain"
+  size_t motion;         // index of the motion waited on in the pipeline's history
+  ez::exit_output exit;  // RUNNING when a quick chain moved on before the motion exited
+};
+
+/**
+ * Runs an ez::Drive's motions through a pipeline, in place of EZ-Template's autonomous task.  The drive's pose is the
+ * pipeline's, and its constants go to the pipeline each time a motion enables it.  Call before the drive moves.
+ *
+ * \param drive
+ *        drive the autons move
+ * \param pipeline
+ *        pipeline on the same motors and IMU
+ */
+void drive_attach(ez::Drive& drive, control::pipeline& pipeline);
+
+/**
+ * Returns every wait on a drive since drive_waits_clear(), oldest first.
+ */
+std::vector<drive_wait> drive_waits_get(ez::Drive& drive);
+
+/**
+ * Forgets a drive's waits.
+ */
+void drive_waits_clear(ez::Drive& drive);
+}  // namespace sim
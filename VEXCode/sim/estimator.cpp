@@ -0,0 +1,162 @@
+// Compares odometry alone against the pipeline's pose EKF on a robot whose sensors drift, over laps of a square.
+//
+//   make -C sim
+//   sim/estimator              10 laps, 5 seeds
+//   sim/estimator --laps 30 --seeds 20
+//
+// The simulated robot's wheels are 1.5% bigger than odometry thinks and its IMU drifts, so odometry alone wanders off.
+// A GPS and two distance sensors read the true pose a few ticks late with noise, the way the real sensors do, and the
+// EKF fuses them.  Errors are against the true pose, the largest seen during the run and where it ended.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cmath>
+#include <deque>
+#include <random>
+
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "world.hpp"
+
+static const int SPEED = 110;
+static const double SIDE = 36.0;          // in, square the robot drives
+static const double WHEEL_ERROR = 1.015;  // true wheel size over what odometry uses
+static const double IMU_DRIFT = 0.05;     // deg/s
+
+// Field walls around the square, in odometry coordinates
+static const control::field_walls FIELD = {-24.0, SIDE + 24.0, -24.0, SIDE + 24.0};
+
+// GPS, V5 GPS is around half an inch with the field strip in view
+static const double GPS_STD = 0.5;  // in
+static const int GPS_PERIOD = 50;   // ms
+static const int GPS_DELAY = 20;    // ms
+
+// Distance sensors on the left and back, V5 distance sensors are 5% past 200 mm
+static const control::distance_mount DISTANCE_MOUNTS[] = {{-6.0, 0.0, -90.0}, {0.0, -7.0, 180.0}};
+static const int DISTANCE_PERIOD = 50;  // ms
+static const int DISTANCE_DELAY = 30;   // ms
+
+struct truth_sample {
+  uint64_t timestamp;
+  double x, y, theta;
+};
+
+struct run_result {
+  double max_error;    // in
+  double final_error;  // in
+  double final_angle;  // deg
+};
+
+enum mode { ODOM, GPS, DISTANCE, BOTH };
+static const char* MODE_NAMES[] = {"odometry", "+ gps", "+ distance", "+ both"};
+
+// What a distance sensor at mount would read with the robot at sample, 0 if it doesn't hit a wall squarely
+static double range_true(const truth_sample& s, const control::distance_mount& mount) {
+  double theta = ez::util::to_rad(s.theta);
+  double sensor_x = s.x + mount.x * cos(theta) + mount.y * sin(theta);
+  double sensor_y = s.y - mount.x * sin(theta) + mount.y * cos(theta);
+  double beam = theta + ez::util::to_rad(mount.angle);
+  double beam_x = sin(beam), beam_y = cos(beam);
+  double range_x = beam_x > 1e-9 ? (FIELD.right - sensor_x) / beam_x : beam_x < -1e-9 ? (FIELD.left - sensor_x) / beam_x : INFINITY;
+  double range_y = beam_y > 1e-9 ? (FIELD.top - sensor_y) / beam_y : beam_y < -1e-9 ? (FIELD.bottom - sensor_y) / beam_y : INFINITY;
+  double range = fmin(range_x, range_y);
+  // V5 distance sensors read up to 2 m
+  return range > 78.0 ? 0.0 : range;
+}
+
+static run_result run(mode m, int laps, unsigned seed) {
+  std::mt19937 random(seed);
+  std::normal_distribution<double> noise(0.0, 1.0);
+
+  sim::robot_reset();
+  sim::world& world = sim::world::get();
+  sim::drivetrain_config config;
+  config.wheel_diameter *= WHEEL_ERROR;
+  config.imu_drift = IMU_DRIFT;
+  world.reset(config);
+  sim_backend.pose_set({0.0, 0.0, 0.0});
+
+  control::ekf_constants constants;
+  constants.field = FIELD;
+  drive_pipeline.estimator_constants_set(constants);
+  drive_pipeline.estimator_set(m != ODOM);
+  drive_pipeline.enable();
+
+  sim::kernel& kernel = sim::kernel::get();
+  kernel.deadline_set(kernel.micros_get() + laps * 20000000ull);
+  std::deque<truth_sample> truth;
+  run_result output = {0.0, 0.0, 0.0};
+  int tick = 0;
+  try {
+    for (int lap = 0; lap < laps; lap++) {
+      drive_pipeline.pid_odom_set({{{0.0, SIDE}, ez::fwd, SPEED}, {{SIDE, SIDE}, ez::fwd, SPEED}, {{SIDE, 0.0}, ez::fwd, SPEED}, {{0.0, 0.0}, ez::fwd, SPEED}},
+                                  true);
+      do {
+        truth.push_back({kernel.micros_get(), world.x, world.y, world.theta});
+        if (truth.size() > 20) truth.pop_front();
+        ez::pose pose = drive_pipeline.odom_pose_get().pose;
+        output.max_error = fmax(output.max_error, hypot(pose.x - world.x, pose.y - world.y));
+
+        // Readings of where the robot was a few ticks ago, stamped with when
+        int ms = tick * ez::util::DELAY_TIME;
+        if ((m == GPS || m == BOTH) && ms % GPS_PERIOD == 0 && (int)truth.size() > GPS_DELAY / ez::util::DELAY_TIME) {
+          const truth_sample& s = truth[truth.size() - 1 - GPS_DELAY / ez::util::DELAY_TIME];
+          drive_pipeline.estimator_gps_add(s.x + GPS_STD * noise(random), s.y + GPS_STD * noise(random), GPS_STD, s.timestamp);
+        }
+        if ((m == DISTANCE || m == BOTH) && ms % DISTANCE_PERIOD == 0 && (int)truth.size() > DISTANCE_DELAY / ez::util::DELAY_TIME) {
+          const truth_sample& s = truth[truth.size() - 1 - DISTANCE_DELAY / ez::util::DELAY_TIME];
+          for (auto& mount : DISTANCE_MOUNTS) {
+            double range = range_true(s, mount);
+            if (range <= 0.0) continue;
+            double std_dev = fmax(constants.distance_floor, constants.distance_fraction * range);
+            drive_pipeline.estimator_distance_add(mount, range + std_dev * noise(random), s.timestamp);
+          }
+        }
+        tick++;
+        pros::delay(ez::util::DELAY_TIME);
+      } while (drive_pipeline.exit_get() == ez::RUNNING);
+    }
+  } catch (const sim::deadline_exceeded&) {
+  }
+  kernel.deadline_set(0);
+
+  ez::pose pose = drive_pipeline.odom_pose_get().pose;
+  output.final_error = hypot(pose.x - world.x, pose.y - world.y);
+  output.final_angle = fabs(ez::util::wrap_angle(pose.theta - world.theta));
+  drive_pipeline.disable();
+  drive_pipeline.estimator_set(false);
+  return output;
+}
+
+int main(int argc, char** argv) {
+  int laps = 10, seeds = 5;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--laps") == 0 && i + 1 < argc) {
+      laps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+      seeds = atoi(argv[++i]);
+    } else {
+      printf("usage: %s [--laps n] [--seeds n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  sim::robot_init();
+  printf("%d laps of a %.0f in square, wheels %.1f%% off, IMU drifting %.2f deg/s, %d seeds\n", laps, SIDE, (WHEEL_ERROR - 1.0) * 100.0,
+         IMU_DRIFT, seeds);
+  printf("  %-12s %12s %12s %12s\n", "estimate", "max error", "final error", "final angle");
+  for (int m = ODOM; m <= BOTH; m++) {
+    run_result total = {0.0, 0.0, 0.0};
+    // Odometry alone doesn't use the noise, one run is enough
+    int runs = m == ODOM ? 1 : seeds;
+    for (int seed = 0; seed < runs; seed++) {
+      run_result r = run((mode)m, laps, seed + 1);
+      total.max_error += r.max_error / runs;
+      total.final_error += r.final_error / runs;
+      total.final_angle += r.final_angle / runs;
+    }
+    printf("  %-12s %9.2f in %9.2f in %8.2f deg\n", MODE_NAMES[m], total.max_error, total.final_error, total.final_angle);
+  }
+  return 0;
+}
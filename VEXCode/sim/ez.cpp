@@ -0,0 +1,340 @@
+// Host stand-ins for the parts of EZ-Template the pipeline uses.  EZ-Template only ships as a prebuilt ARM library, so
+// these follow its behavior closely enough for the pipeline's motions to act the same as on the robot.  ez::Drive is in
+// drive.cpp.
+
+#include <cmath>
+
+#include "EZ-Template/PID.hpp"
+#include "EZ-Template/slew.hpp"
+#include "EZ-Template/tracking_wheel.hpp"
+#include "EZ-Template/util.hpp"
+
+namespace ez {
+std::string exit_to_string(exit_output input) {
+  switch (input) {
+    case RUNNING:
+      return "Running";
+    case SMALL_EXIT:
+      return "Small";
+    case BIG_EXIT:
+      return "Big";
+    case VELOCITY_EXIT:
+      return "Velocity";
+    case mA_EXIT:
+      return "mA";
+    case ERROR_NO_CONSTANTS:
+      return "Error: Exit condition constants not set!";
+    default:
+      return "Error: Out of bounds!";
+  }
+}
+
+void screen_print(std::string text, int line) { printf("%s\n", text.c_str()); }
+
+namespace util {
+bool AUTON_RAN = true;
+
+int sgn(double input) {
+  if (input > 0) return 1;
+  if (input < 0) return -1;
+  return 0;
+}
+
+bool reversed_active(double input) { return input < 0; }
+
+double clamp(double input, double max, double min) {
+  if (input > max) return max;
+  if (input < min) return min;
+  return input;
+}
+
+double clamp(double input, double max) { return clamp(input, fabs(max), -fabs(max)); }
+
+double to_deg(double input) { return input * (180.0 / M_PI); }
+
+double to_rad(double input) { return input * (M_PI / 180.0); }
+
+double absolute_angle_to_point(pose itarget, pose icurrent) {
+  // 0 is +y and clockwise is positive, so x and y swap places in atan2
+  return to_deg(atan2(itarget.x - icurrent.x, itarget.y - icurrent.y));
+}
+
+double distance_to_point(pose itarget, pose icurrent) {
+  return hypot(itarget.x - icurrent.x, itarget.y - icurrent.y);
+}
+
+double wrap_angle(double theta) {
+  while (theta > 180.0) theta -= 360.0;
+  while (theta < -180.0) theta += 360.0;
+  return theta;
+}
+
+pose vector_off_point(double added, pose icurrent) {
+  double angle = to_rad(icurrent.theta);
+  return {icurrent.x + added * sin(angle), icurrent.y + added * cos(angle), icurrent.theta};
+}
+
+double turn_shortest(double target, double current, bool print) {
+  return current + wrap_angle(target - current);
+}
+
+double turn_longest(double target, double current, bool print) {
+  double shortest = wrap_angle(target - current);
+  return current + shortest - sgn(shortest) * 360.0;
+}
+
+pose united_pose_to_pose(united_pose input) {
+  return {input.x.convert(okapi::inch), input.y.convert(okapi::inch), input.theta.convert(okapi::degree)};
+}
+
+odom united_odom_to_odom(united_odom input) {
+  return {united_pose_to_pose(input.target), input.drive_direction, input.max_xy_speed, input.turn_behavior};
+}
+
+std::vector<odom> united_odoms_to_odoms(std::vector<united_odom> inputs) {
+  std::vector<odom> output;
+  for (auto& input : inputs)
+    output.push_back(united_odom_to_odom(input));
+  return output;
+}
+}  // namespace util
+
+/////
+// PID
+/////
+PID::PID() {}
+
+PID::PID(double p, double i, double d, double start_i, std::string name) {
+  constants_set(p, i, d, start_i);
+  name_set(name);
+}
+
+void PID::constants_set(double p, double i, double d, double p_start_i) { constants = {p, i, d, p_start_i}; }
+
+PID::Constants PID::constants_get() { return constants; }
+
+bool PID::constants_set_check() { return constants.kp != 0 || constants.ki != 0 || constants.kd != 0; }
+
+void PID::exit_condition_set(int p_small_exit_time, double p_small_error, int p_big_exit_time, double p_big_error, int p_velocity_exit_time, int p_mA_timeout) {
+  exit = {p_small_exit_time, p_small_error, p_big_exit_time, p_big_error, p_velocity_exit_time, p_mA_timeout};
+}
+
+void PID::target_set(double input) { target = input; }
+
+double PID::target_get() { return target; }
+
+void PID::name_set(std::string p_name) {
+  name = p_name;
+  name_active = !name.empty();
+}
+
+std::string PID::name_get() { return name; }
+
+void PID::i_reset_toggle(bool toggle) { reset_i_sgn = toggle; }
+
+bool PID::i_reset_get() { return reset_i_sgn; }
+
+void PID::variables_reset() {
+  output = 0;
+  target = 0;
+  error = 0;
+  prev_error = 0;
+  integral = 0;
+  time = 0;
+  prev_time = 0;
+}
+
+void PID::timers_reset() { i = j = k = l = m = 0; }
+
+double PID::compute(double current) { return compute_error(target - current, current); }
+
+double PID::compute_error(double err, double current) {
+  error = err;
+  cur = current;
+  return raw_compute();
+}
+
+double PID::raw_compute() {
+  // Derivative on the measurement, so target changes don't kick
+  derivative = cur - prev_current;
+  if (constants.ki != 0) {
+    if (fabs(error) < constants.start_i) integral += error;
+    if (util::sgn(error) != util::sgn(prev_error) && reset_i_sgn) integral = 0;
+  }
+  output = (error * constants.kp) + (integral * constants.ki) - (derivative * constants.kd);
+  prev_current = cur;
+  prev_error = error;
+  return output;
+}
+
+void PID::velocity_sensor_main_exit_set(double zero) { velocity_zero_main = zero; }
+double PID::velocity_sensor_main_exit_get() { return velocity_zero_main; }
+void PID::velocity_sensor_secondary_exit_set(double zero) { velocity_zero_secondary = zero; }
+double PID::velocity_sensor_secondary_exit_get() { return velocity_zero_secondary; }
+void PID::velocity_sensor_secondary_set(double secondary_sensor) { second_sensor = secondary_sensor; }
+double PID::velocity_sensor_secondary_get() { return second_sensor; }
+void PID::velocity_sensor_secondary_toggle_set(bool toggle) { use_second_sensor = toggle; }
+bool PID::velocity_sensor_secondary_toggle_get() { return use_second_sensor; }
+
+exit_output PID::exit_condition(bool print) {
+  if (exit.small_error == 0 && exit.small_exit_time == 0 && exit.big_error == 0 && exit.big_exit_time == 0 && exit.velocity_exit_time == 0 && exit.mA_timeout == 0)
+    return ERROR_NO_CONSTANTS;
+
+  // Close enough for long enough
+  if (exit.small_error != 0) {
+    if (fabs(error) < exit.small_error) {
+      j += util::DELAY_TIME;
+      i = 0;
+      if (j > exit.small_exit_time) {
+        timers_reset();
+        return SMALL_EXIT;
+      }
+    } else {
+      j = 0;
+    }
+  }
+
+  // Nearly there but not getting closer
+  if (exit.big_error != 0 && exit.big_exit_time != 0) {
+    if (fabs(error) < exit.big_error) {
+      i += util::DELAY_TIME;
+      if (i > exit.big_exit_time) {
+        timers_reset();
+        return BIG_EXIT;
+      }
+    } else {
+      i = 0;
+    }
+  }
+
+  // Stopped moving
+  if (exit.velocity_exit_time != 0) {
+    if (fabs(derivative) <= velocity_zero_main && (!use_second_sensor || fabs(second_sensor) <= velocity_zero_secondary)) {
+      k += util::DELAY_TIME;
+      if (k > exit.velocity_exit_time) {
+        timers_reset();
+        return VELOCITY_EXIT;
+      }
+    } else {
+      k = 0;
+    }
+  }
+
+  return RUNNING;
+}
+
+exit_output PID::exit_condition(std::vector<pros::Motor> sensor, bool print) {
+  // Over current for long enough
+  if (exit.mA_timeout != 0) {
+    bool over = false;
+    for (auto& motor : sensor)
+      if (motor.is_over_current()) over = true;
+    if (over) {
+      l += util::DELAY_TIME;
+      if (l > exit.mA_timeout) {
+        timers_reset();
+        return mA_EXIT;
+      }
+    } else {
+      l = 0;
+    }
+  }
+  return exit_condition(print);
+}
+
+exit_output PID::exit_condition(pros::Motor sensor, bool print) { return exit_condition(std::vector<pros::Motor>{sensor}, print); }
+
+/////
+// Slew
+/////
+slew::slew() {}
+
+slew::slew(double distance, int minimum_speed) { constants_set(distance, minimum_speed); }
+
+void slew::constants_set(double distance, int minimum_speed) { constants = {(double)minimum_speed, distance}; }
+
+slew::Constants slew::constants_get() { return constants; }
+
+void slew::initialize(bool enabled, double maximum_speed, double target, double current) {
+  is_enabled = enabled;
+  max_speed = maximum_speed;
+  sign = util::sgn(target - current);
+  x_intercept = current + (constants.distance_to_travel * sign);
+  y_intercept = max_speed * sign;
+  slope = ((sign * constants.min_speed) - y_intercept) / (x_intercept - current);
+  if (!std::isfinite(slope)) is_enabled = false;
+}
+
+double slew::iterate(double current) {
+  if (is_enabled) {
+    error = x_intercept - current;
+    if (util::sgn(error) != sign)
+      is_enabled = false;
+    else
+      last_output = (slope * error) + y_intercept;
+  }
+  if (!is_enabled) last_output = max_speed;
+  return fabs(last_output);
+}
+
+bool slew::enabled() { return is_enabled; }
+
+double slew::output() { return last_output; }
+
+void slew::speed_max_set(double speed) { max_speed = speed; }
+
+double slew::speed_max_get() { return max_speed; }
+/////
+// Tracking wheels
+/////
+tracking_wheel::tracking_wheel(std::vector<int> ports, double wheel_diameter, double distance_to_center, double ratio)
+    : adi_encoder(abs(ports[0]), abs(ports[1]), ports[0] < 0), smart_encoder(-1) {
+  IS_TRACKER = DRIVE_ADI_ENCODER;
+  ticks_per_rev_set(360.0);
+  ratio_set(ratio);
+  wheel_diameter_set(wheel_diameter);
+  distance_to_center_set(distance_to_center);
+}
+
+tracking_wheel::tracking_wheel(int port, double wheel_diameter, double distance_to_center, double ratio)
+    : adi_encoder(-1, -1, false), smart_encoder(port) {
+  IS_TRACKER = DRIVE_ROTATION;
+  smart_encoder.set_reversed(port < 0);
+  ticks_per_rev_set(36000.0);
+  ratio_set(ratio);
+  wheel_diameter_set(wheel_diameter);
+  distance_to_center_set(distance_to_center);
+}
+
+double tracking_wheel::get_raw() { return IS_TRACKER == DRIVE_ADI_ENCODER ? adi_encoder.get_value() : smart_encoder.get_position(); }
+double tracking_wheel::get() { return get_raw() / ticks_per_inch(); }
+
+void tracking_wheel::reset() {
+  if (IS_TRACKER == DRIVE_ADI_ENCODER)
+    adi_encoder.reset();
+  else
+    smart_encoder.reset_position();
+}
+
+void tracking_wheel::distance_to_center_set(double input) { DISTANCE_TO_CENTER = IS_FLIPPED ? -input : input; }
+double tracking_wheel::distance_to_center_get() { return DISTANCE_TO_CENTER; }
+void tracking_wheel::distance_to_center_flip_set(bool input) {
+  IS_FLIPPED = input;
+  DISTANCE_TO_CENTER = IS_FLIPPED ? -fabs(DISTANCE_TO_CENTER) : fabs(DISTANCE_TO_CENTER);
+}
+bool tracking_wheel::distance_to_center_flip_get() { return IS_FLIPPED; }
+
+double tracking_wheel::ticks_per_inch() { return WHEEL_TICK_PER_REV / (WHEEL_DIAMETER * M_PI); }
+void tracking_wheel::ticks_per_rev_set(double input) {
+  ENCODER_TICKS_PER_REV = input;
+  WHEEL_TICK_PER_REV = ENCODER_TICKS_PER_REV * RATIO;
+}
+double tracking_wheel::ticks_per_rev_get() { return ENCODER_TICKS_PER_REV; }
+void tracking_wheel::ratio_set(double input) {
+  RATIO = input;
+  WHEEL_TICK_PER_REV = ENCODER_TICKS_PER_REV * RATIO;
+}
+double tracking_wheel::ratio_get() { return RATIO; }
+void tracking_wheel::wheel_diameter_set(double input) { WHEEL_DIAMETER = input; }
+double tracking_wheel::wheel_diameter_get() { return WHEEL_DIAMETER; }
+}  // namespace ez
@@ -0,0 +1,158 @@
+#include "kernel.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace sim;
+
+// Task the calling thread runs as, the main thread is left as nullptr
+static thread_local kernel::task* self = nullptr;
+
+// Waits with this wake time never time out
+static const uint64_t FOREVER = UINT64_MAX;
+
+kernel& kernel::get() {
+  // Never destroyed, detached task threads are still waiting on it when the program exits
+  static kernel* instance = new kernel();
+  return *instance;
+}
+
+kernel::kernel() {
+  auto first = std::make_unique<task>();
+  first->name = "main";
+  main = first.get();
+  running = main;
+  tasks.push_back(std::move(first));
+}
+
+uint64_t kernel::micros_get() { return now; }
+
+void kernel::world_set(std::function<void(uint64_t)> new_step) {
+  std::unique_lock<std::mutex> guard(lock);
+  step = new_step;
+}
+
+void kernel::deadline_set(uint64_t us) { deadline = us; }
+
+kernel::task* kernel::current() { return self ? self : main; }
+
+kernel::task* kernel::create(void (*function)(void*), void* parameters, uint32_t priority, const char* name) {
+  std::unique_lock<std::mutex> guard(lock);
+  auto created = std::make_unique<task>();
+  task* raw = created.get();
+  raw->name = name ? name : "";
+  raw->priority = priority;
+  raw->waiting = true;
+  raw->wake = now;
+  raw->order = order++;
+  tasks.push_back(std::move(created));
+
+  std::thread([this, raw, function, parameters]() {
+    self = raw;
+    {
+      std::unique_lock<std::mutex> start(lock);
+      raw->cv.wait(start, [&]() { return running == raw; });
+    }
+    function(parameters);
+
+    std::unique_lock<std::mutex> finish(lock);
+    raw->done = true;
+    running = next_get();
+    running->cv.notify_one();
+  }).detach();
+  return raw;
+}
+
+kernel::task* kernel::next_get() {
+  while (true) {
+    task* best = nullptr;
+    uint64_t next_wake = FOREVER;
+    for (auto& t : tasks) {
+      if (t->done || t->suspended) continue;
+      if (t->waiting && t->wake > now) {
+        if (t->wake < next_wake) next_wake = t->wake;
+        continue;
+      }
+      // Equal priorities take turns, whoever has been waiting longest goes first
+      if (!best || t->priority > best->priority || (t->priority == best->priority && t->order < best->order))
+        best = t.get();
+    }
+    if (best) {
+      best->waiting = false;
+      best->notify_waiting = false;
+      return best;
+    }
+
+    if (next_wake == FOREVER) {
+      fprintf(stderr, "sim: every task is waiting forever\n");
+      abort();
+    }
+    if (step) step(next_wake);
+    now = next_wake;
+  }
+}
+
+void kernel::block(std::unique_lock<std::mutex>& guard) {
+  task* me = current();
+  task* next = next_get();
+  running = next;
+  if (next == me) return;
+  next->cv.notify_one();
+  me->cv.wait(guard, [&]() { return running == me; });
+}
+
+void kernel::deadline_check() {
+  if (deadline != 0 && now >= deadline && current() == main) throw deadline_exceeded();
+}
+
+void kernel::sleep_until(uint64_t wake_us) {
+  std::unique_lock<std::mutex> guard(lock);
+  task* me = current();
+  me->waiting = true;
+  me->wake = wake_us;
+  me->order = order++;
+  block(guard);
+  deadline_check();
+}
+
+void kernel::yield() { sleep_until(now); }
+
+uint32_t kernel::notify_take(bool clear_on_exit, uint32_t timeout_ms) {
+  std::unique_lock<std::mutex> guard(lock);
+  task* me = current();
+  if (me->notify_value == 0 && timeout_ms != 0) {
+    me->waiting = true;
+    me->notify_waiting = true;
+    me->wake = timeout_ms == UINT32_MAX ? FOREVER : now + timeout_ms * 1000ull;
+    me->order = order++;
+    block(guard);
+  }
+  uint32_t value = me->notify_value;
+  if (value != 0) me->notify_value = clear_on_exit ? 0 : value - 1;
+  deadline_check();
+  return value;
+}
+
+uint32_t kernel::notify(task* target) {
+  std::unique_lock<std::mutex> guard(lock);
+  uint32_t previous = target->notify_value++;
+  if (target->notify_waiting) {
+    target->waiting = false;
+    target->notify_waiting = false;
+  }
+  return previous;
+}
+
+void kernel::suspend(task* target) {
+  std::unique_lock<std::mutex> guard(lock);
+  target->suspended = true;
+  if (target == current()) {
+    target->order = order++;
+    block(guard);
+  }
+}
+
+void kernel::resume(task* target) {
+  std::unique_lock<std::mutex> guard(lock);
+  target->suspended = false;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sim {
+/**
+ * Thrown into the main task when the deadline passes, so a stuck auton can't run forever.
+ */
+struct deadline_exceeded : std::runtime_error {
+  deadline_exceeded() : std::runtime_error("sim deadline exceeded") {}
+};
+
+/**
+ * A simulated clock and a task scheduler in place of the brain's RTOS.
+ *
+ * Every PROS task is a host thread, but only one runs at a time.  A task runs until it delays or waits on a notification,
+ * then the highest priority task that's ready runs next.  When every task is waiting, the clock jumps to the next wake up
+ * and the world is stepped up to it.  Time only moves while every task is waiting, so code runs in zero simulated time
+ * and the simulation runs as fast as the host can go.
+ */
+class kernel {
+ public:
+  struct task {
+    std::string name;
+    uint32_t priority = 8;
+    std::condition_variable cv;
+    bool waiting = false;
+    bool notify_waiting = false;
+    bool suspended = false;
+    bool done = false;
+    uint64_t wake = 0;
+    uint64_t order = 0;
+    uint32_t notify_value = 0;
+  };
+
+  /**
+   * Returns the kernel.  The thread that calls this first becomes the main task.
+   */
+  static kernel& get();
+
+  /**
+   * Returns simulated time in microseconds.
+   */
+  uint64_t micros_get();
+
+  /**
+   * Sets the function that steps the world.  The kernel calls it with the time to step up to.
+   *
+   * \param step
+   *        function that steps the world to a time in microseconds
+   */
+  void world_set(std::function<void(uint64_t)> step);
+
+  /**
+   * Makes the main task throw deadline_exceeded once simulated time passes a deadline.  0 turns this off.
+   *
+   * \param us
+   *        deadline in microseconds
+   */
+  void deadline_set(uint64_t us);
+
+  task* create(void (*function)(void*), void* parameters, uint32_t priority, const char* name);
+  task* current();
+  void sleep_until(uint64_t wake_us);
+  void yield();
+  uint32_t notify_take(bool clear_on_exit, uint32_t timeout_ms);
+  uint32_t notify(task* target);
+  void suspend(task* target);
+  void resume(task* target);
+
+ private:
+  kernel();
+  std::mutex lock;
+  std::vector<std::unique_ptr<task>> tasks;
+  task* main = nullptr;
+  task* running = nullptr;
+  uint64_t now = 0;
+  uint64_t deadline = 0;
+  uint64_t order = 0;
+  std::function<void(uint64_t)> step;
+  void block(std::unique_lock<std::mutex>& guard);
+  task* next_get();
+  void deadline_check();
+};
+}  // namespace sim
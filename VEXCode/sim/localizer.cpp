@@ -0,0 +1,173 @@
+// Relocalizes odometry off the field walls with the particle filter, from a few inches and degrees off.
+//
+//   make -C sim
+//   sim/localizer              100, 300 and 500 particles with 1 to 4 sensors, 20 seeds
+//   sim/localizer --seeds 50
+//
+// Then it checks a pose move with the pipeline running publishes cleanly: with the robot still, every pose published
+// after odom_pose_set() should be the new pose, with and without the estimator.
+//
+// The robot sits still near the middle of the bottom wall, like after a match load, with odometry off from the true
+// pose.  Sensors are added back left, left side, back right and then right side.  One wall alone can't give the pose,
+// and only the two back sensors together see the heading.  relocalize() runs with its default timeout and convergence.
+// Time is simulated time until it calls the pose found, errors are against the true pose after, both only over the runs
+// it found the pose in.  CPU is host time for one predict and update with every sensor.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#include "control/particle_filter.hpp"
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "world.hpp"
+
+// Where the robot really is, and how far off odometry starts
+static const ez::pose TRUTH = {0.0, -60.0, 5.0};
+static const double POSITION_OFF = 3.0;  // in
+static const double HEADING_OFF = 4.0;   // deg
+
+// Two on the back, so the bottom wall shows the heading, and one on each side
+static const sim::distance_config SENSORS[] = {{1, -5.0, -7.0, 180.0}, {11, -6.0, 0.0, -90.0}, {12, 5.0, -7.0, 180.0}, {13, 6.0, 0.0, 90.0}};
+
+struct run_result {
+  bool converged;
+  double time;   // ms
+  double error;  // in
+  double angle;  // deg
+};
+
+static run_result run(int particles, int sensors, unsigned seed) {
+  sim::robot_reset();
+  sim::world& world = sim::world::get();
+  sim::drivetrain_config config;
+  config.seed = seed;
+  std::vector<control::wall_sensor> walls;
+  std::vector<pros::Distance> devices;
+  devices.reserve(sensors);
+  for (int i = 0; i < sensors; i++) {
+    config.distance_sensors.push_back(SENSORS[i]);
+    devices.emplace_back(SENSORS[i].port);
+  }
+  for (int i = 0; i < sensors; i++) walls.push_back({&devices[i], {SENSORS[i].x, SENSORS[i].y, SENSORS[i].angle}});
+  world.reset(config);
+  world.pose_set(TRUTH.x, TRUTH.y, TRUTH.theta);
+
+  // Odometry off in a random direction
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> direction(0.0, 2.0 * M_PI);
+  double angle = direction(random);
+  sim_backend.pose_set({TRUTH.x + POSITION_OFF * cos(angle), TRUTH.y + POSITION_OFF * sin(angle),
+                        TRUTH.theta + (seed % 2 ? HEADING_OFF : -HEADING_OFF)});
+
+  control::particle_filter filter(particles, {}, seed);
+  sim::kernel& kernel = sim::kernel::get();
+  uint64_t start = kernel.micros_get();
+  run_result output;
+  output.converged = control::relocalize(drive_pipeline, filter, walls, POSITION_OFF, HEADING_OFF);
+  output.time = (kernel.micros_get() - start) / 1000.0;
+  ez::pose pose = sim_backend.pose_get();
+  if (!output.converged) pose = filter.estimate_get();
+  output.error = hypot(pose.x - TRUTH.x, pose.y - TRUTH.y);
+  output.angle = fabs(ez::util::wrap_angle(pose.theta - TRUTH.theta));
+  return output;
+}
+
+// Moves odometry while the pipeline runs with the robot still.  Returns the furthest any published pose got from the new
+// one, in in and deg, over the first 20 publishes after the move
+static ez::pose move_check(bool estimator) {
+  const ez::pose MOVED = {10.0, 5.0, 30.0};
+  sim::robot_reset();
+  drive_pipeline.estimator_set(estimator);
+  drive_pipeline.enable();
+  pros::delay(50);
+
+  uint32_t last = drive_pipeline.odom_pose_get().sequence;
+  drive_pipeline.odom_pose_set(MOVED);
+  ez::pose worst = {0.0, 0.0, 0.0};
+  for (int publishes = 0; publishes < 20;) {
+    pros::delay(1);
+    control::pose_snapshot now = drive_pipeline.odom_pose_get();
+    if (now.sequence == last) continue;
+    last = now.sequence;
+    publishes++;
+    worst.x = fmax(worst.x, hypot(now.pose.x - MOVED.x, now.pose.y - MOVED.y));
+    worst.theta = fmax(worst.theta, fabs(ez::util::wrap_angle(now.pose.theta - MOVED.theta)));
+  }
+  drive_pipeline.disable();
+  drive_pipeline.estimator_set(false);
+  return worst;
+}
+
+// Host time for one predict and update with every sensor, in us
+static double cpu_time(int particles) {
+  control::particle_filter filter(particles);
+  control::distance_mount mounts[control::particle_filter::SENSORS];
+  double ranges[control::particle_filter::SENSORS];
+  for (int i = 0; i < control::particle_filter::SENSORS; i++) {
+    mounts[i] = {SENSORS[i].x, SENSORS[i].y, SENSORS[i].angle};
+    ranges[i] = 20.0 + i;
+  }
+  filter.reset(TRUTH, POSITION_OFF, HEADING_OFF);
+  const int ROUNDS = 20000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ROUNDS; i++) {
+    filter.predict({0.0, 0.1, 0.1});
+    filter.update(mounts, ranges, control::particle_filter::SENSORS);
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / ROUNDS;
+}
+
+int main(int argc, char** argv) {
+  int seeds = 20;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+      seeds = atoi(argv[++i]);
+    } else {
+      printf("usage: %s [--seeds n]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  sim::robot_init();
+  printf("robot at {%.0f, %.0f, %.0f}, odometry %.0f in and %.0f deg off, %d seeds\n", TRUTH.x, TRUTH.y, TRUTH.theta, POSITION_OFF, HEADING_OFF,
+         seeds);
+  printf("  %9s %7s %10s %10s %10s %10s %10s %10s\n", "particles", "sensors", "converged", "time", "slowest", "error", "worst", "cpu");
+  for (int particles : {100, 300, 500}) {
+    double cpu = cpu_time(particles);
+    for (int sensors = 1; sensors <= 4; sensors++) {
+      // Time and error over the runs that converged, what odometry gets moved by
+      int converged = 0;
+      double time = 0.0, slowest = 0.0, error = 0.0, worst = 0.0;
+      for (int seed = 1; seed <= seeds; seed++) {
+        run_result r = run(particles, sensors, seed);
+        if (!r.converged) continue;
+        converged++;
+        time += r.time;
+        slowest = fmax(slowest, r.time);
+        error += r.error;
+        worst = fmax(worst, r.error);
+      }
+      printf("  %9d %7d %6d/%-3d", particles, sensors, converged, seeds);
+      if (converged > 0)
+        printf(" %7.0f ms %7.0f ms %7.2f in %7.2f in", time / converged, slowest, error / converged, worst);
+      else
+        printf(" %10s %10s %10s %10s", "-", "-", "-", "-");
+      printf(" %7.1f us\n", cpu);
+    }
+  }
+
+  printf("\npose move to {10, 5, 30} with the robot still, furthest published pose after\n");
+  bool failed = false;
+  for (bool estimator : {false, true}) {
+    ez::pose worst = move_check(estimator);
+    bool clean = worst.x < 0.01 && worst.theta < 0.01;
+    failed |= !clean;
+    printf("  %-14s %.3f in %.3f deg  %s\n", estimator ? "with estimator" : "odometry", worst.x, worst.theta, clean ? "ok" : "FAILED");
+  }
+  return failed ? 2 : 0;
+}
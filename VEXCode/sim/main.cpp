@@ -0,0 +1,223 @@
+// Runs autons on the host against a simulated drivetrain, much faster than real time.  Autons that drive through
+// ez::Drive run through the stand-in in drive.cpp, which moves the chassis with the same pipeline.
+//
+//   make -C sim
+//   sim/pipeline_sim              runs every page of the auton selector, AUTON_PAGES in src/autons.cpp
+//   sim/pipeline_sim 6 boomerang  runs just page 6 and the pages titled Boomerang
+//   sim/pipeline_sim --settle     predicts settling instead of waiting out the exit timers
+//   sim/pipeline_sim --odom 2     runs odometry in its own task every 2 ms
+//   sim/pipeline_sim --record f   records odometry to f for sim/replay
+//
+// Error is how far each motion ended from where it was going.  Turns and swings only aim for a heading, their error is
+// how far the robot moved off where it started.  Wait is the pid_wait() or quick chain that ended the motion, and each
+// auton totals how its waits exited.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <strings.h>
+
+#include <chrono>
+
+#include "EZ-Template/drive/drive.hpp"
+#include "autons.hpp"
+#include "control/flight_recorder.hpp"
+#include "drive.hpp"
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "world.hpp"
+
+// Page title, the name up to its description
+static std::string title_get(const auton_page& page) {
+  std::string name = page.name;
+  return name.substr(0, name.find('\n'));
+}
+
+// How the waits in autons ended
+struct wait_counts {
+  int small = 0;
+  int big = 0;
+  int velocity = 0;
+  int mA = 0;
+  int chained = 0;  // quick chains that moved on before the motion exited
+  int stopped = 0;  // waits that returned with the pipeline disabled
+
+  void add(const sim::drive_wait& wait) {
+    switch (wait.exit) {
+      case ez::SMALL_EXIT:
+        small++;
+        break;
+      case ez::BIG_EXIT:
+        big++;
+        break;
+      case ez::VELOCITY_EXIT:
+        velocity++;
+        break;
+      case ez::mA_EXIT:
+        mA++;
+        break;
+      default:
+        (strcmp(wait.call, "pid_wait") == 0 ? stopped : chained)++;
+        break;
+    }
+  }
+
+  void add(const wait_counts& other) {
+    small += other.small;
+    big += other.big;
+    velocity += other.velocity;
+    mA += other.mA;
+    chained += other.chained;
+    stopped += other.stopped;
+  }
+
+  void print(const char* label) const {
+    printf("%s %d small, %d big, %d velocity, %d mA", label, small, big, velocity, mA);
+    if (chained > 0) printf(", %d quick chains moved on", chained);
+    if (stopped > 0) printf(", %d with the pipeline off", stopped);
+    printf("\n");
+  }
+};
+
+// What autonomous() in src/main.cpp does before it calls the selected auton
+static void autonomous_start() {
+  chassis.pid_targets_reset();
+  chassis.drive_imu_reset();
+  pros::delay(100);
+  chassis.drive_sensor_reset();
+  chassis.odom_xyt_set(0_in, 0_in, 0_deg);
+  chassis.drive_brake_set(pros::E_MOTOR_BRAKE_HOLD);
+}
+
+static std::string exit_name(ez::exit_output exit) { return exit == ez::RUNNING ? "Stopped" : ez::exit_to_string(exit); }
+
+// Runs one page from a fresh start, prints every motion it ran and adds its waits to waited.  Returns false if it ran out
+// of time.
+static bool auton_run(int page, wait_counts& waited) {
+  const auton_page& a = AUTON_PAGES[page];
+  sim::world& world = sim::world::get();
+  sim::kernel& kernel = sim::kernel::get();
+  sim::robot_reset();
+  drive_pipeline.history_clear();
+  sim::drive_waits_clear(chassis);
+
+  uint64_t start = kernel.micros_get();
+  auto wall_start = std::chrono::steady_clock::now();
+  kernel.deadline_set(start + a.limit * 1000ull);
+  bool finished = true;
+  try {
+    autonomous_start();
+    a.run();
+  } catch (const sim::deadline_exceeded&) {
+    finished = false;
+  }
+  kernel.deadline_set(0);
+  drive_pipeline.disable();
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+  double simulated = (kernel.micros_get() - start) / 1e6;
+
+  printf("%d %s %s after %.2f s (%.1f ms real)\n", page + 1, title_get(a).c_str(), finished ? "finished" : "TIMED OUT", simulated,
+         wall * 1000.0);
+  printf("  %-12s %8s %8s  %-9s %8s %10s %8s  %s\n", "motion", "start", "time", "exit", "error", "heading", "saved", "wait");
+  std::vector<control::motion_record> history = drive_pipeline.history_get();
+  uint32_t start_ms = start / 1000;
+  std::vector<sim::drive_wait> waits = sim::drive_waits_get(chassis);
+  int saved = 0;
+  for (size_t i = 0; i < history.size(); i++) {
+    const control::motion_record& r = history[i];
+    printf("  %-12s %6.2f s %6.2f s  %-9s %5.2f in", r.name, (r.start - start_ms) / 1000.0, (r.end - r.start) / 1000.0, exit_name(r.exit).c_str(),
+           ez::util::distance_to_point(r.target, r.pose));
+    if (r.target.theta != ez::ANGLE_NOT_SET)
+      printf(" %6.2f deg", ez::util::wrap_angle(r.target.theta - r.pose.theta));
+    else
+      printf(" %10s", "");
+    printf(" %5d ms", r.saved);
+    for (auto& w : waits)
+      if (w.motion == i) printf("  %s", w.call);
+    printf("\n");
+    saved += r.saved;
+  }
+
+  // Final error is against where the last motion was going, measured from where the robot really is
+  if (!history.empty()) {
+    ez::pose target = history.back().target;
+    ez::pose actual = {world.x, world.y, world.theta};
+    printf("  final error %.2f in", ez::util::distance_to_point(target, actual));
+    if (target.theta != ez::ANGLE_NOT_SET) printf(" %.2f deg", ez::util::wrap_angle(target.theta - actual.theta));
+    ez::pose odom = sim_backend.pose_get();
+    printf(", odom drift %.2f in", ez::util::distance_to_point(odom, actual));
+    if (saved > 0) printf(", %d ms saved settling", saved);
+    printf("\n");
+  }
+  if (!waits.empty()) {
+    wait_counts counts;
+    for (auto& w : waits) counts.add(w);
+    counts.print(("  " + std::to_string(waits.size()) + " waits,").c_str());
+    waited.add(counts);
+  }
+  printf("\n");
+  return finished;
+}
+
+int main(int argc, char** argv) {
+  // Run every page, or just the ones picked by number or title
+  std::vector<int> selected;
+  bool settle = false;
+  int odom_period = 0;
+  const char* record_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--settle") == 0) {
+      settle = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--odom") == 0 && i + 1 < argc) {
+      odom_period = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+      continue;
+    }
+    size_t before = selected.size();
+    int number = atoi(argv[i]);
+    for (size_t page = 0; page < AUTON_PAGES.size(); page++)
+      if (number == (int)page + 1 || strcasecmp(title_get(AUTON_PAGES[page]).c_str(), argv[i]) == 0) selected.push_back(page);
+    if (selected.size() == before) {
+      printf("unknown auton %s, pick a page or title from:\n", argv[i]);
+      for (size_t page = 0; page < AUTON_PAGES.size(); page++) printf("  %2d %s\n", (int)page + 1, title_get(AUTON_PAGES[page]).c_str());
+      return 1;
+    }
+  }
+  if (selected.empty())
+    for (size_t page = 0; page < AUTON_PAGES.size(); page++) selected.push_back(page);
+
+  sim::robot_init();
+  default_constants();
+  drive_pipeline.pid_settle_predict_set(settle);
+  drive_pipeline.odom_period_set(odom_period);
+
+  // The sim runs odometry through wheel_odometry, so the recording replays
+  control::flight_recorder recorder;
+  if (record_path) {
+    if (!recorder.open(record_path)) {
+      printf("couldn't open %s\n", record_path);
+      return 1;
+    }
+    drive_pipeline.recorder_set(&recorder);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  int failed = 0;
+  wait_counts waited;
+  for (int page : selected)
+    if (!auton_run(page, waited)) failed++;
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (record_path) {
+    drive_pipeline.recorder_set(nullptr);
+    recorder.close();
+    printf("recorded %u records to %s, %u dropped\n", (unsigned)recorder.written_get(), record_path, (unsigned)recorder.dropped_get());
+  }
+  printf("%d autons in %.3f s, %d timed out\n", (int)selected.size(), wall, failed);
+  waited.print("waits exited");
+  return failed == 0 ? 0 : 2;
+}
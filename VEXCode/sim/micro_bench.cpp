@@ -0,0 +1,308 @@
+// Times per-tick hot paths on the host, in ns per call.  Absolute numbers are the host's, compare them against each
+// other or against an older build on the same machine.
+//
+//   make -C sim
+//   sim/micro_bench                          runs every case
+//   sim/micro_bench pid util                 runs cases whose name starts with any of these
+//   sim/micro_bench --json out.json          also writes the results as JSON
+//   sim/micro_bench --compare old.json       flags cases that got slower than an older report
+//
+// EZ-Template only ships prebuilt, so cases marked stand-in time the host stand-ins in ez.cpp, not the library the
+// robot runs.  They follow its behavior, not necessarily its speed, so only compare them with themselves across builds.
+// EKFFilter, VelMath and squiggles' SplineGenerator are compiled into the prebuilt OkapiLib and can't run here, the
+// report lists them as skipped.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "control/motions.hpp"
+#include "control/pid.hpp"
+#include "control/pose_ekf.hpp"
+#include "control/pose_history.hpp"
+#include "control/profile.hpp"
+#include "control/seqlock.hpp"
+#include "control/settle.hpp"
+#include "okapi/api/filter/averageFilter.hpp"
+#include "okapi/api/filter/medianFilter.hpp"
+
+// Calls per timed run, and runs per case.  The fastest run is what's compared, it's the least disturbed by the host
+static const int CALLS = 200000;
+static const int RUNS = 9;
+
+// A case that's this much slower than the old report is a regression
+static const double REGRESSION = 1.10;
+
+// Inputs are fixed so every run does the same work.  Sensor values wander around a target so exit conditions keep
+// running instead of settling, angles sweep past +-360 so the wrapping loops run.
+static const int SAMPLES = 1024;
+static double samples[SAMPLES];
+static double angles[SAMPLES];
+static ez::pose poses[SAMPLES];
+
+// Results go here so the compiler can't drop the work
+static volatile double sink;
+
+struct bench_case {
+  const char* name;
+  int calls;  // calls per run, slow cases use fewer
+  void (*body)(int);
+};
+
+struct result {
+  std::string name;
+  double min;  // ns per call
+  double median;
+};
+
+// Names that are in the suite but can't run on the host, and why
+static const char* SKIPPED[][2] = {
+    {"okapi/EKFFilter::filter", "compiled into the prebuilt OkapiLib"},
+    {"okapi/VelMath::step", "compiled into the prebuilt OkapiLib"},
+    {"okapi/SplineGenerator::generate", "compiled into the prebuilt OkapiLib"},
+};
+
+static ez::PID tuned() {
+  ez::PID output(20.0, 0.1, 100.0, 3.0, "drive");
+  output.exit_condition_set(90, 1, 250, 3, 500, 500);
+  return output;
+}
+
+static std::vector<bench_case> cases_get() {
+  // Everything the cases touch lives as long as the program
+  static ez::PID ez_pid = tuned();
+  static control::motion_pid pid(tuned());
+  static control::motion_pid biquad_pid(tuned(), {false, control::DERIVATIVE_BIQUAD, 10.0});
+  static ez::PID ez_source = tuned();
+  static std::vector<pros::Motor> motors = {pros::Motor(4), pros::Motor(2), pros::Motor(-3), pros::Motor(-10), pros::Motor(-9), pros::Motor(8)};
+  static ez::slew slew(3.0, 70);
+  static okapi::MedianFilter<5> median5;
+  static okapi::MedianFilter<9> median9;
+  static okapi::AverageFilter<5> average5;
+  static okapi::AverageFilter<10> average10;
+  static control::motion_profile profile;
+  static control::feedforward ff = {0.2, 0.19, 0.02};
+  static control::settle_predictor settle(tuned(), {true, 0.1, 60.0, 2});
+  static std::vector<ez::odom> path;
+  static control::seqlock<control::drive_state> published;
+  static control::pose_history history;
+  static control::pose_ekf ekf;
+
+  ez_pid.target_set(24.0);
+  pid.target_set(24.0);
+  profile.generate(48.0, {62.0, 400.0, 4000.0});
+  // A full history, 10 ms apart
+  for (int i = 0; i < control::pose_history::CAPACITY; i++) history.add(i * 10000ull, {0.0, i * 0.5, i * 2.0});
+  path = {{{0.0, 0.0}, ez::fwd, 110}, {{0.0, 24.0}, ez::fwd, 110}, {{24.0, 24.0}, ez::fwd, 110}, {{24.0, 48.0}, ez::fwd, 110}};
+
+  return {
+      // One tick of PID, the ez::PID stand-in next to the pipeline's core
+      {"pid/ez::PID::compute (stand-in)", CALLS, [](int i) { sink = ez_pid.compute(samples[i % SAMPLES]); }},
+      {"pid/ez::PID::exit_condition (stand-in)", CALLS, [](int i) {
+         ez_pid.error = samples[i % SAMPLES] - 24.0;
+         sink = ez_pid.exit_condition();
+       }},
+      {"pid/ez::PID::exit_condition(motors) (stand-in)", CALLS, [](int i) {
+         ez_pid.error = samples[i % SAMPLES] - 24.0;
+         sink = ez_pid.exit_condition(motors);
+       }},
+      {"pid/ez::PID copy (stand-in)", CALLS, [](int i) {
+         ez::PID copy = ez_source;
+         sink = copy.exit.small_error;
+       }},
+      {"pid/control::pid::compute", CALLS, [](int i) { sink = pid.compute(samples[i % SAMPLES]); }},
+      {"pid/control::pid::compute biquad", CALLS, [](int i) { sink = biquad_pid.compute(samples[i % SAMPLES]); }},
+      {"pid/control::pid::exit_condition", CALLS, [](int i) {
+         pid.error = samples[i % SAMPLES] - 24.0;
+         sink = pid.exit_condition();
+       }},
+      {"pid/control::pid::exit_condition(span)", CALLS, [](int i) {
+         pid.error = samples[i % SAMPLES] - 24.0;
+         sink = pid.exit_condition(motors);
+       }},
+      {"pid/control::pid copy", CALLS, [](int i) {
+         control::motion_pid copy = pid;
+         sink = copy.exit.small_error;
+       }},
+
+      {"slew/ez::slew::iterate (stand-in)", CALLS, [](int i) {
+         if (i % SAMPLES == 0) slew.initialize(true, 110, 24.0, 0.0);
+         sink = slew.iterate(samples[i % SAMPLES] - 24.0 + (i % SAMPLES) * 0.03);
+       }},
+
+      {"util/turn_shortest (stand-in)", CALLS, [](int i) { sink = ez::util::turn_shortest(angles[i % SAMPLES], angles[(i + 7) % SAMPLES]); }},
+      {"util/turn_longest (stand-in)", CALLS, [](int i) { sink = ez::util::turn_longest(angles[i % SAMPLES], angles[(i + 7) % SAMPLES]); }},
+      {"util/wrap_angle (stand-in)", CALLS, [](int i) { sink = ez::util::wrap_angle(angles[i % SAMPLES]); }},
+      {"util/absolute_angle_to_point (stand-in)", CALLS, [](int i) { sink = ez::util::absolute_angle_to_point(poses[i % SAMPLES], poses[(i + 7) % SAMPLES]); }},
+      {"util/vector_off_point (stand-in)", CALLS, [](int i) { sink = ez::util::vector_off_point(samples[i % SAMPLES], poses[i % SAMPLES]).x; }},
+
+      {"okapi/MedianFilter<5>::filter", CALLS, [](int i) { sink = median5.filter(samples[i % SAMPLES]); }},
+      {"okapi/MedianFilter<9>::filter", CALLS, [](int i) { sink = median9.filter(samples[i % SAMPLES]); }},
+      {"okapi/AverageFilter<5>::filter", CALLS, [](int i) { sink = average5.filter(samples[i % SAMPLES]); }},
+      {"okapi/AverageFilter<10>::filter", CALLS, [](int i) { sink = average10.filter(samples[i % SAMPLES]); }},
+
+      {"control/motion_profile::sample", CALLS, [](int i) { sink = profile.sample((i % SAMPLES) * 0.002).velocity; }},
+      {"control/motion_profile::generate", CALLS / 20, [](int i) {
+         control::motion_profile p;
+         p.generate(samples[i % SAMPLES] - 20.0, {62.0, 400.0, 0.0});
+         sink = p.duration_get();
+       }},
+      {"control/feedforward::output", CALLS, [](int i) { sink = ff.output(samples[i % SAMPLES], samples[(i + 7) % SAMPLES]); }},
+      {"control/settle_predictor::iterate", CALLS, [](int i) {
+         if (i % SAMPLES == 0) settle.start();
+         sink = settle.iterate(samples[i % SAMPLES] - 24.0, 100.0, (uint64_t)i * 10000);
+       }},
+      {"control/seqlock::write", CALLS, [](int i) {
+         control::drive_state state;
+         state.pose.x = samples[i % SAMPLES];
+         published.write(state);
+       }},
+      {"control/seqlock::read", CALLS, [](int i) { sink = published.read().pose.x; }},
+      {"control/pose_history::pose_at", CALLS, [](int i) {
+         ez::pose pose;
+         history.pose_at((i * 7919ull) % (control::pose_history::CAPACITY * 10000ull), pose);
+         sink = pose.y;
+       }},
+      // One tick of the pose EKF, and one of each reading
+      {"control/pose_ekf::predict", CALLS, [](int i) {
+         ekf.predict({0.01, 0.5 + samples[i % SAMPLES] * 0.01, 0.3}, 0.01, 30.0);
+         sink = ekf.pose_get().x;
+       }},
+      {"control/pose_ekf::gps_update", CALLS, [](int i) {
+         ez::pose pose = ekf.pose_get();
+         sink = ekf.gps_update(pose.x + 0.3, pose.y - 0.3, 0.5, {0.0, 1.0, 2.0});
+       }},
+      {"control/pose_ekf::distance_update", CALLS, [](int i) {
+         // The default field is 72 in out from the start, the estimate stays near it
+         ekf.reset({0.0, 0.0, 0.0});
+         sink = ekf.distance_update({-6.0, 0.0, -90.0}, 66.0 + samples[i % SAMPLES] * 0.01, {0.0, 1.0, 2.0});
+       }},
+      {"control/pose_history::propagate", CALLS, [](int i) {
+         ez::pose pose;
+         history.propagate({1.0, 2.0, 3.0}, (i * 7919ull) % (control::pose_history::CAPACITY * 10000ull), pose);
+         sink = pose.y;
+       }},
+      {"control/path_inject+path_smooth", CALLS / 2000, [](int i) {
+         std::vector<ez::odom> injected = control::path_inject(path, 0.5);
+         sink = control::path_smooth(injected, 0.75, 0.03, 0.0001).size();
+       }},
+  };
+}
+
+static result case_run(const bench_case& c) {
+  std::vector<double> runs;
+  for (int run = 0; run < RUNS; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < c.calls; i++) c.body(i);
+    runs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / c.calls);
+  }
+  std::sort(runs.begin(), runs.end());
+  return {c.name, runs.front(), runs[runs.size() / 2]};
+}
+
+static std::string commit_get() {
+  FILE* git = popen("git rev-parse --short HEAD 2>/dev/null", "r");
+  if (!git) return "";
+  char line[64] = "";
+  if (!fgets(line, sizeof(line), git)) line[0] = '\0';
+  pclose(git);
+  line[strcspn(line, "\n")] = '\0';
+  return line;
+}
+
+static void json_write(const char* path, const std::vector<result>& results) {
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    printf("can't write %s\n", path);
+    return;
+  }
+  fprintf(f, "{\n  \"commit\": \"%s\",\n  \"compiler\": \"%s\",\n  \"calls\": %d,\n  \"runs\": %d,\n  \"unit\": \"ns\",\n",
+          commit_get().c_str(), __VERSION__, CALLS, RUNS);
+  fprintf(f, "  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    fprintf(f, "    {\"name\": \"%s\", \"min\": %.2f, \"median\": %.2f}%s\n", results[i].name.c_str(), results[i].min,
+            results[i].median, i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ],\n  \"skipped\": [\n");
+  int skipped = sizeof(SKIPPED) / sizeof(SKIPPED[0]);
+  for (int i = 0; i < skipped; i++)
+    fprintf(f, "    {\"name\": \"%s\", \"reason\": \"%s\"}%s\n", SKIPPED[i][0], SKIPPED[i][1], i + 1 < skipped ? "," : "");
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+}
+
+// Reads name and min from a report json_write() made.  This only has to read our own output, one result per line
+static std::map<std::string, double> json_read(const char* path) {
+  std::map<std::string, double> output;
+  FILE* f = fopen(path, "r");
+  if (!f) return output;
+  char line[512];
+  while (fgets(line, sizeof(line), f)) {
+    char name[256];
+    double min;
+    if (sscanf(line, " {\"name\": \"%255[^\"]\", \"min\": %lf", name, &min) == 2) output[name] = min;
+  }
+  fclose(f);
+  return output;
+}
+
+int main(int argc, char** argv) {
+  const char* json = nullptr;
+  const char* compare = nullptr;
+  std::vector<std::string> filters;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      json = argv[++i];
+    else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+      compare = argv[++i];
+    else
+      filters.push_back(argv[i]);
+  }
+
+  for (int i = 0; i < SAMPLES; i++) {
+    samples[i] = 24.0 + 5.0 * sin(i * 0.05) * exp(-i / 400.0);
+    angles[i] = -720.0 + 1440.0 * i / SAMPLES;
+    poses[i] = {12.0 * cos(i * 0.1), 12.0 * sin(i * 0.13), angles[i]};
+  }
+
+  std::map<std::string, double> old;
+  if (compare) {
+    old = json_read(compare);
+    if (old.empty()) printf("nothing to compare in %s\n", compare);
+  }
+
+  std::vector<result> results;
+  int regressions = 0;
+  printf("  %-48s %9s %9s\n", "case", "min ns", "median ns");
+  for (auto& c : cases_get()) {
+    bool selected = filters.empty();
+    for (auto& f : filters)
+      if (strncmp(c.name, f.c_str(), f.size()) == 0) selected = true;
+    if (!selected) continue;
+
+    result r = case_run(c);
+    results.push_back(r);
+    printf("  %-48s %9.2f %9.2f", r.name.c_str(), r.min, r.median);
+    auto found = old.find(r.name);
+    if (found != old.end() && found->second > 0.0) {
+      double ratio = r.min / found->second;
+      printf("  %5.2fx%s", ratio, ratio > REGRESSION ? "  SLOWER" : "");
+      if (ratio > REGRESSION) regressions++;
+    }
+    printf("\n");
+  }
+  for (auto& s : SKIPPED) printf("  %-48s skipped, %s\n", s[0], s[1]);
+
+  if (json) json_write(json, results);
+  if (compare && regressions > 0) {
+    printf("%d cases more than %.0f%% slower\n", regressions, (REGRESSION - 1.0) * 100.0);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+// Replays a known path through odometry at different update periods, and compares each integrator in float and double.
+//
+//   make -C sim
+//   sim/odometry               15 s of driving with fast swings
+//   sim/odometry --seconds 60
+//
+// The true path comes from a speed, slide and turn rate that change smoothly, integrated every 10 us.  The robot has a
+// vertical tracker 1.5 in right of center, a horizontal tracker 2 in behind it and an IMU, sampled every 5, 10 and
+// 20 ms the way odometry reads them.  Turn rate swings up to 500 deg/s.  Errors are against the true pose at each
+// sample, the largest seen and where it ended.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cmath>
+#include <vector>
+
+#include "control/odometry.hpp"
+
+static const double VERTICAL_OFFSET = 1.5;     // in, right of center
+static const double HORIZONTAL_OFFSET = -2.0;  // in, forward of center
+static const double TRUTH_STEP = 10e-6;        // s
+
+struct sample {
+  double vertical;    // in the vertical tracker has rolled
+  double horizontal;  // in the horizontal tracker has rolled
+  double imu;         // deg
+  double x, y;        // true position
+};
+
+// Speed, slide and turn rate at a time, the robot swings back and forth while it drives
+static void velocity(double t, double& forward, double& right, double& turn) {
+  forward = 40.0 + 25.0 * sin(2.0 * M_PI * t / 3.0);                       // in/s
+  right = 4.0 * sin(2.0 * M_PI * t / 0.7);                                  // in/s, wheels slipping sideways in the swing
+  turn = 450.0 * sin(2.0 * M_PI * t / 1.1) + 50.0 * sin(2.0 * M_PI * t / 0.23);  // deg/s
+}
+
+// Samples of the sensors and true position every period
+static std::vector<sample> truth_make(double seconds, int period) {
+  std::vector<sample> output;
+  long double x = 0, y = 0, theta = 0, vertical = 0, horizontal = 0;
+  int steps_per_sample = std::lround(period * 1e-3 / TRUTH_STEP);
+  int samples = seconds * 1000.0 / period;
+  output.push_back({0.0, 0.0, 0.0, 0.0, 0.0});
+  long step = 0;
+  for (int i = 0; i < samples; i++) {
+    for (int j = 0; j < steps_per_sample; j++, step++) {
+      double forward, right, turn;
+      velocity((step + 0.5) * TRUTH_STEP, forward, right, turn);
+      long double d_forward = forward * TRUTH_STEP, d_right = right * TRUTH_STEP, d_turn = turn * TRUTH_STEP;
+      long double turn_rad = d_turn * M_PI / 180.0;
+      // Steps this short put the midpoint within a millionth of an inch of the exact arc over the whole run
+      long double heading = theta * M_PI / 180.0 + turn_rad / 2.0;
+      x += d_forward * sinl(heading) + d_right * cosl(heading);
+      y += d_forward * cosl(heading) - d_right * sinl(heading);
+      theta += d_turn;
+      vertical += d_forward - VERTICAL_OFFSET * turn_rad;
+      horizontal += d_right + HORIZONTAL_OFFSET * turn_rad;
+    }
+    output.push_back({(double)vertical, (double)horizontal, (double)theta, (double)x, (double)y});
+  }
+  return output;
+}
+
+struct replay_result {
+  double max_error;    // in
+  double final_error;  // in
+};
+
+// Runs odometry over the samples the way the robot would, with sensors read in T
+template <typename T>
+static replay_result replay(const std::vector<sample>& samples, control::odom_integrator integrator) {
+  control::odom_pose<T> pose;
+  T last_turn = 0;
+  replay_result output = {0.0, 0.0};
+  for (size_t i = 1; i < samples.size(); i++) {
+    const sample& last = samples[i - 1];
+    const sample& now = samples[i];
+    T turn = T(now.imu) - T(last.imu);
+    T forward = control::odom_forward<T>(T(now.vertical) - T(last.vertical), T(VERTICAL_OFFSET), turn);
+    T right = control::odom_sideways<T>(T(now.horizontal) - T(last.horizontal), T(HORIZONTAL_OFFSET), turn);
+    control::odom_integrate(pose, right, forward, turn, integrator, last_turn);
+    pose.theta = T(now.imu);
+    last_turn = turn;
+    double error = hypot((double)pose.x - now.x, (double)pose.y - now.y);
+    output.max_error = fmax(output.max_error, error);
+    output.final_error = error;
+  }
+  return output;
+}
+
+int main(int argc, char** argv) {
+  double seconds = 15.0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else {
+      printf("usage: %s [--seconds s]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  const char* NAMES[] = {"euler", "midpoint", "exponential", "exp + accel"};
+  printf("%.0f s of driving, turn rate swinging up to 500 deg/s\n", seconds);
+  printf("  %6s %-12s %14s %14s %14s %14s\n", "period", "integrator", "max float", "final float", "max double", "final double");
+  for (int period : {5, 10, 20}) {
+    std::vector<sample> samples = truth_make(seconds, period);
+    for (int i = control::ODOM_EULER; i <= control::ODOM_EXPONENTIAL_ACCEL; i++) {
+      replay_result f = replay<float>(samples, (control::odom_integrator)i);
+      replay_result d = replay<double>(samples, (control::odom_integrator)i);
+      printf("  %3d ms %-12s %11.4f in %11.4f in %11.4f in %11.4f in\n", period, NAMES[i], f.max_error, f.final_error, d.max_error,
+             d.final_error);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,8 @@
+// Host stand-ins for the parts of OkapiLib the host programs use.  OkapiLib only ships as a prebuilt ARM library, so
+// header-only pieces like MedianFilter work on the host once the out of line parts they lean on exist.
+
+#include "okapi/api/filter/filter.hpp"
+
+namespace okapi {
+Filter::~Filter() = default;
+}  // namespace okapi
@@ -0,0 +1,355 @@
+// PROS devices backed by the simulated world.  Anything the world doesn't model returns a harmless default.
+
+#include <cmath>
+#include <map>
+
+#include "api.h"
+#include "world.hpp"
+
+using sim::motor_state;
+using sim::world;
+
+namespace {
+double counts_per_rev(pros::v5::MotorGears gearing) {
+  switch (gearing) {
+    case pros::v5::MotorGears::red:
+      return 1800.0;
+    case pros::v5::MotorGears::green:
+      return 900.0;
+    default:
+      return 300.0;
+  }
+}
+
+// Converts raw counts to the motor's encoder units
+double counts_to_units(const motor_state& motor, double counts) {
+  switch (motor.units) {
+    case pros::v5::MotorUnits::rotations:
+      return counts / counts_per_rev(motor.gearing);
+    case pros::v5::MotorUnits::counts:
+      return counts;
+    default:
+      return counts / counts_per_rev(motor.gearing) * 360.0;
+  }
+}
+
+double units_to_counts(const motor_state& motor, double units) { return units / counts_to_units(motor, 1.0); }
+
+// Device state is built on first use, globals like the chassis construct devices before main
+
+// IMU readings are the world's rotation plus whatever the IMU has been set to, by port
+std::map<int, double>& imu_offsets() {
+  static std::map<int, double> output;
+  return output;
+}
+
+// Rotation sensors, by port
+struct rotation_state {
+  double offset = 0.0;  // deg
+  bool reversed = false;
+};
+std::map<int, rotation_state>& rotations() {
+  static std::map<int, rotation_state> output;
+  return output;
+}
+
+// ADI encoders, by top port
+std::map<int, rotation_state>& encoders() {
+  static std::map<int, rotation_state> output;
+  return output;
+}
+}  // namespace
+
+namespace pros {
+inline namespace v5 {
+/////
+// Device
+/////
+Device::Device(const std::uint8_t port) : _port(port) {}
+
+std::uint8_t Device::get_port(void) const { return _port; }
+
+bool Device::is_installed() { return true; }
+
+/////
+// Motor
+/////
+Motor::Motor(const std::int8_t port, const MotorGears gearset, const MotorUnits encoder_units)
+    : Device(std::abs(port), DeviceType::motor), _port(port) {
+  if (gearset != MotorGears::invalid) set_gearing(gearset);
+  if (encoder_units != MotorUnits::invalid) set_encoder_units(encoder_units);
+}
+
+std::int32_t Motor::move(std::int32_t voltage) const { return move_voltage(voltage * 12000 / 127); }
+
+std::int32_t Motor::move_voltage(const std::int32_t voltage) const {
+  world::get().motor_get(_port).voltage = (_port < 0 ? -1 : 1) * std::clamp(voltage, -12000, 12000);
+  return 1;
+}
+
+std::int32_t Motor::move_velocity(const std::int32_t velocity) const {
+  // Open loop, full voltage is the cartridge's free speed
+  double max_rpm = 180000.0 / counts_per_rev(get_gearing());
+  return move_voltage(std::lround(velocity / max_rpm * 12000.0));
+}
+
+std::int32_t Motor::move_absolute(const double position, const std::int32_t velocity) const { return move_velocity(0); }
+std::int32_t Motor::move_relative(const double position, const std::int32_t velocity) const { return move_velocity(0); }
+std::int32_t Motor::brake(void) const { return move_voltage(0); }
+std::int32_t Motor::modify_profiled_velocity(const std::int32_t velocity) const { return 1; }
+
+double Motor::get_target_position(const std::uint8_t index) const { return 0.0; }
+std::int32_t Motor::get_target_velocity(const std::uint8_t index) const { return 0; }
+
+double Motor::get_actual_velocity(const std::uint8_t index) const {
+  return (_port < 0 ? -1 : 1) * world::get().motor_get(_port).velocity;
+}
+
+std::int32_t Motor::get_current_draw(const std::uint8_t index) const {
+  return std::fabs(world::get().motor_get(_port).current) * 1000.0;
+}
+
+std::int32_t Motor::get_direction(const std::uint8_t index) const { return get_actual_velocity() < 0 ? -1 : 1; }
+double Motor::get_efficiency(const std::uint8_t index) const { return 100.0; }
+std::uint32_t Motor::get_faults(const std::uint8_t index) const { return 0; }
+std::uint32_t Motor::get_flags(const std::uint8_t index) const { return 0; }
+
+double Motor::get_position(const std::uint8_t index) const {
+  motor_state& motor = world::get().motor_get(_port);
+  return (_port < 0 ? -1 : 1) * counts_to_units(motor, motor.position - motor.zero);
+}
+
+double Motor::get_power(const std::uint8_t index) const { return 0.0; }
+
+std::int32_t Motor::get_raw_position(std::uint32_t* const timestamp, const std::uint8_t index) const {
+  if (timestamp) *timestamp = pros::millis();
+  int step = world::get().config.encoder_step;
+  return std::lround(world::get().motor_get(_port).position / step) * step;
+}
+
+double Motor::get_temperature(const std::uint8_t index) const { return 25.0; }
+double Motor::get_torque(const std::uint8_t index) const { return 0.0; }
+std::int32_t Motor::get_voltage(const std::uint8_t index) const { return (_port < 0 ? -1 : 1) * world::get().motor_get(_port).voltage; }
+std::int32_t Motor::is_over_current(const std::uint8_t index) const { return 0; }
+std::int32_t Motor::is_over_temp(const std::uint8_t index) const { return 0; }
+MotorBrake Motor::get_brake_mode(const std::uint8_t index) const { return MotorBrake::brake; }
+std::int32_t Motor::get_current_limit(const std::uint8_t index) const { return 2500; }
+MotorUnits Motor::get_encoder_units(const std::uint8_t index) const { return world::get().motor_get(_port).units; }
+MotorGears Motor::get_gearing(const std::uint8_t index) const { return world::get().motor_get(_port).gearing; }
+std::int32_t Motor::get_voltage_limit(const std::uint8_t index) const { return 12000; }
+std::int32_t Motor::is_reversed(const std::uint8_t index) const { return _port < 0; }
+
+std::int32_t Motor::set_brake_mode(const MotorBrake mode, const std::uint8_t index) const { return 1; }
+std::int32_t Motor::set_brake_mode(const pros::motor_brake_mode_e_t mode, const std::uint8_t index) const { return 1; }
+std::int32_t Motor::set_current_limit(const std::int32_t limit, const std::uint8_t index) const { return 1; }
+
+std::int32_t Motor::set_encoder_units(const MotorUnits units, const std::uint8_t index) const {
+  world::get().motor_get(_port).units = units;
+  return 1;
+}
+
+std::int32_t Motor::set_encoder_units(const pros::motor_encoder_units_e_t units, const std::uint8_t index) const {
+  return set_encoder_units(static_cast<MotorUnits>(units), index);
+}
+
+std::int32_t Motor::set_gearing(const MotorGears gearset, const std::uint8_t index) const {
+  world::get().motor_get(_port).gearing = gearset;
+  return 1;
+}
+
+std::int32_t Motor::set_gearing(const pros::motor_gearset_e_t gearset, const std::uint8_t index) const {
+  return set_gearing(static_cast<MotorGears>(gearset), index);
+}
+
+std::int32_t Motor::set_reversed(const bool reverse, const std::uint8_t index) {
+  _port = reverse ? -std::abs(_port) : std::abs(_port);
+  return 1;
+}
+
+std::int32_t Motor::set_voltage_limit(const std::int32_t limit, const std::uint8_t index) const { return 1; }
+
+std::int32_t Motor::set_zero_position(const double position, const std::uint8_t index) const {
+  motor_state& motor = world::get().motor_get(_port);
+  motor.zero = motor.position - (_port < 0 ? -1 : 1) * units_to_counts(motor, position);
+  return 1;
+}
+
+std::int32_t Motor::tare_position(const std::uint8_t index) const { return set_zero_position(0.0, index); }
+
+std::int8_t Motor::size(void) const { return 1; }
+std::int8_t Motor::get_port(const std::uint8_t index) const { return _port; }
+
+std::vector<double> Motor::get_target_position_all(void) const { return {get_target_position()}; }
+std::vector<std::int32_t> Motor::get_target_velocity_all(void) const { return {get_target_velocity()}; }
+std::vector<double> Motor::get_actual_velocity_all(void) const { return {get_actual_velocity()}; }
+std::vector<std::int32_t> Motor::get_current_draw_all(void) const { return {get_current_draw()}; }
+std::vector<std::int32_t> Motor::get_direction_all(void) const { return {get_direction()}; }
+std::vector<double> Motor::get_efficiency_all(void) const { return {get_efficiency()}; }
+std::vector<std::uint32_t> Motor::get_faults_all(void) const { return {get_faults()}; }
+std::vector<std::uint32_t> Motor::get_flags_all(void) const { return {get_flags()}; }
+std::vector<double> Motor::get_position_all(void) const { return {get_position()}; }
+std::vector<double> Motor::get_power_all(void) const { return {get_power()}; }
+std::vector<std::int32_t> Motor::get_raw_position_all(std::uint32_t* const timestamp) const { return {get_raw_position(timestamp)}; }
+std::vector<double> Motor::get_temperature_all(void) const { return {get_temperature()}; }
+std::vector<double> Motor::get_torque_all(void) const { return {get_torque()}; }
+std::vector<std::int32_t> Motor::get_voltage_all(void) const { return {get_voltage()}; }
+std::vector<std::int32_t> Motor::is_over_current_all(void) const { return {is_over_current()}; }
+std::vector<std::int32_t> Motor::is_over_temp_all(void) const { return {is_over_temp()}; }
+std::vector<MotorBrake> Motor::get_brake_mode_all(void) const { return {get_brake_mode()}; }
+std::vector<std::int32_t> Motor::get_current_limit_all(void) const { return {get_current_limit()}; }
+std::vector<MotorUnits> Motor::get_encoder_units_all(void) const { return {get_encoder_units()}; }
+std::vector<MotorGears> Motor::get_gearing_all(void) const { return {get_gearing()}; }
+std::vector<std::int8_t> Motor::get_port_all(void) const { return {get_port()}; }
+std::vector<std::int32_t> Motor::get_voltage_limit_all(void) const { return {get_voltage_limit()}; }
+std::vector<std::int32_t> Motor::is_reversed_all(void) const { return {is_reversed()}; }
+std::int32_t Motor::set_brake_mode_all(const MotorBrake mode) const { return set_brake_mode(mode); }
+std::int32_t Motor::set_brake_mode_all(const pros::motor_brake_mode_e_t mode) const { return set_brake_mode(mode); }
+std::int32_t Motor::set_current_limit_all(const std::int32_t limit) const { return set_current_limit(limit); }
+std::int32_t Motor::set_encoder_units_all(const MotorUnits units) const { return set_encoder_units(units); }
+std::int32_t Motor::set_encoder_units_all(const pros::motor_encoder_units_e_t units) const { return set_encoder_units(units); }
+std::int32_t Motor::set_gearing_all(const MotorGears gearset) const { return set_gearing(gearset); }
+std::int32_t Motor::set_gearing_all(const pros::motor_gearset_e_t gearset) const { return set_gearing(gearset); }
+std::int32_t Motor::set_reversed_all(const bool reverse) { return set_reversed(reverse); }
+std::int32_t Motor::set_voltage_limit_all(const std::int32_t limit) const { return set_voltage_limit(limit); }
+std::int32_t Motor::set_zero_position_all(const double position) const { return set_zero_position(position); }
+std::int32_t Motor::tare_position_all(void) const { return tare_position(); }
+
+/////
+// IMU
+/////
+std::int32_t Imu::reset(bool blocking) const { return tare(); }
+std::int32_t Imu::set_data_rate(std::uint32_t rate) const { return 1; }
+
+double Imu::get_rotation() const { return world::get().imu_rotation + imu_offsets()[_port]; }
+
+double Imu::get_heading() const {
+  double heading = fmod(get_rotation(), 360.0);
+  return heading < 0.0 ? heading + 360.0 : heading;
+}
+
+pros::quaternion_s_t Imu::get_quaternion() const { return {0.0, 0.0, 0.0, 1.0}; }
+pros::euler_s_t Imu::get_euler() const { return {0.0, 0.0, get_yaw()}; }
+double Imu::get_pitch() const { return 0.0; }
+double Imu::get_roll() const { return 0.0; }
+
+double Imu::get_yaw() const {
+  double yaw = fmod(get_rotation() + 180.0, 360.0);
+  return (yaw < 0.0 ? yaw + 360.0 : yaw) - 180.0;
+}
+
+// Right handed with z up, so turning clockwise is negative
+pros::imu_gyro_s_t Imu::get_gyro_rate() const { return {0.0, 0.0, -world::get().angular_velocity}; }
+
+std::int32_t Imu::tare_rotation() const { return set_rotation(0.0); }
+std::int32_t Imu::tare_heading() const { return set_rotation(0.0); }
+std::int32_t Imu::tare_pitch() const { return 1; }
+std::int32_t Imu::tare_yaw() const { return set_rotation(0.0); }
+std::int32_t Imu::tare_roll() const { return 1; }
+std::int32_t Imu::tare() const { return set_rotation(0.0); }
+std::int32_t Imu::tare_euler() const { return set_rotation(0.0); }
+std::int32_t Imu::set_heading(const double target) const { return set_rotation(target); }
+
+std::int32_t Imu::set_rotation(const double target) const {
+  imu_offsets()[_port] = target - world::get().imu_rotation;
+  return 1;
+}
+
+std::int32_t Imu::set_yaw(const double target) const { return set_rotation(target); }
+std::int32_t Imu::set_pitch(const double target) const { return 1; }
+std::int32_t Imu::set_roll(const double target) const { return 1; }
+std::int32_t Imu::set_euler(const pros::euler_s_t target) const { return set_rotation(target.yaw); }
+pros::imu_accel_s_t Imu::get_accel() const { return {0.0, 0.0, 0.0}; }
+pros::ImuStatus Imu::get_status() const { return ImuStatus::ready; }
+bool Imu::is_calibrating() const { return false; }
+imu_orientation_e_t Imu::get_physical_orientation() const { return E_IMU_Z_UP; }
+
+/////
+// Rotation
+/////
+Rotation::Rotation(const std::int8_t port) : Device(std::abs(port), DeviceType::rotation) {
+  rotations()[_port].reversed = port < 0;
+}
+
+std::int32_t Rotation::reset() { return reset_position(); }
+std::int32_t Rotation::set_data_rate(std::uint32_t rate) const { return 1; }
+
+std::int32_t Rotation::set_position(std::uint32_t position) const {
+  rotation_state& rotation = rotations()[_port];
+  double raw = world::get().trackers[_port] * (rotation.reversed ? -1 : 1);
+  rotation.offset = position / 100.0 - raw;
+  return 1;
+}
+
+std::int32_t Rotation::reset_position(void) const { return set_position(0); }
+
+std::int32_t Rotation::get_position() const {
+  rotation_state& rotation = rotations()[_port];
+  double raw = world::get().trackers[_port] * (rotation.reversed ? -1 : 1);
+  return std::lround((raw + rotation.offset) * 100.0);
+}
+
+std::int32_t Rotation::get_velocity() const { return 0; }
+
+std::int32_t Rotation::get_angle() const {
+  std::int32_t angle = get_position() % 36000;
+  return angle < 0 ? angle + 36000 : angle;
+}
+
+std::int32_t Rotation::set_reversed(bool value) const {
+  rotations()[_port].reversed = value;
+  return 1;
+}
+
+std::int32_t Rotation::reverse() const { return set_reversed(!rotations()[_port].reversed); }
+std::int32_t Rotation::get_reversed() const { return rotations()[_port].reversed; }
+
+/////
+// Distance
+/////
+Distance::Distance(const std::uint8_t port) : Device(port, DeviceType::distance) {}
+
+std::int32_t Distance::get() { return get_distance(); }
+std::int32_t Distance::get_distance() { return world::get().distance_get(_port); }
+std::int32_t Distance::get_confidence() { return get_distance() == 9999 ? 0 : 63; }
+std::int32_t Distance::get_object_size() { return get_distance() == 9999 ? -1 : 400; }
+double Distance::get_object_velocity() { return 0.0; }
+
+/////
+// Controller, nobody holds it
+/////
+Controller::Controller(controller_id_e_t id) : _id(id) {}
+}  // namespace v5
+
+namespace adi {
+/////
+// ADI Encoder
+/////
+Port::Port(std::uint8_t adi_port, adi_port_config_e_t type) : _smart_port(INTERNAL_ADI_PORT), _adi_port(adi_port) {}
+
+ext_adi_port_tuple_t Port::get_port() const { return {_smart_port, _adi_port, 0}; }
+
+// Pistons aren't in the world, setting them does nothing
+std::int32_t Port::set_value(std::int32_t value) const { return 1; }
+
+DigitalOut::DigitalOut(std::uint8_t adi_port, bool init_state) : Port(adi_port) {}
+
+Encoder::Encoder(std::uint8_t adi_port_top, std::uint8_t adi_port_bottom, bool reversed) : Port(adi_port_top) {
+  encoders()[_adi_port].reversed = reversed;
+  reset();
+}
+
+std::int32_t Encoder::reset() const {
+  // One tick per degree, like the VEX optical shaft encoder
+  rotation_state& encoder = encoders()[_adi_port];
+  encoder.offset = -world::get().trackers[_adi_port] * (encoder.reversed ? -1 : 1);
+  return 1;
+}
+
+std::int32_t Encoder::get_value() const {
+  rotation_state& encoder = encoders()[_adi_port];
+  return std::lround(world::get().trackers[_adi_port] * (encoder.reversed ? -1 : 1) + encoder.offset);
+}
+
+ext_adi_port_tuple_t Encoder::get_port() const { return Port::get_port(); }
+}  // namespace adi
+}  // namespace pros
@@ -0,0 +1,141 @@
+// PROS RTOS functions on the simulated kernel
+
+#include "api.h"
+#include "kernel.hpp"
+
+using sim::kernel;
+
+namespace {
+struct sim_mutex {
+  kernel::task* owner = nullptr;
+};
+
+kernel::task* task_get(pros::task_t task) {
+  return task ? static_cast<kernel::task*>(task) : kernel::get().current();
+}
+}  // namespace
+
+namespace pros {
+namespace c {
+uint32_t millis(void) { return kernel::get().micros_get() / 1000; }
+
+uint64_t micros(void) { return kernel::get().micros_get(); }
+
+void task_delay(const uint32_t milliseconds) {
+  kernel& k = kernel::get();
+  k.sleep_until(k.micros_get() + milliseconds * 1000ull);
+}
+
+void delay(const uint32_t milliseconds) { task_delay(milliseconds); }
+
+void task_delay_until(uint32_t* const prev_time, const uint32_t delta) {
+  *prev_time += delta;
+  kernel& k = kernel::get();
+  uint64_t wake = *prev_time * 1000ull;
+  if (wake > k.micros_get())
+    k.sleep_until(wake);
+  else
+    k.yield();
+}
+
+task_t task_create(task_fn_t function, void* const parameters, uint32_t prio, const uint16_t stack_depth, const char* const name) {
+  return kernel::get().create(function, parameters, prio, name);
+}
+
+task_t task_get_current() { return kernel::get().current(); }
+
+char* task_get_name(task_t task) { return const_cast<char*>(task_get(task)->name.c_str()); }
+
+uint32_t task_get_priority(task_t task) { return task_get(task)->priority; }
+
+void task_set_priority(task_t task, uint32_t prio) { task_get(task)->priority = prio; }
+
+uint32_t task_notify(task_t task) { return kernel::get().notify(task_get(task)); }
+
+uint32_t task_notify_take(bool clear_on_exit, uint32_t timeout) { return kernel::get().notify_take(clear_on_exit, timeout); }
+
+void task_suspend(task_t task) { kernel::get().suspend(task_get(task)); }
+
+void task_resume(task_t task) { kernel::get().resume(task_get(task)); }
+
+mutex_t mutex_create(void) { return new sim_mutex(); }
+
+bool mutex_take(mutex_t mutex, uint32_t timeout) {
+  // Tasks only switch when they wait, so polling once a millisecond is enough
+  sim_mutex* m = static_cast<sim_mutex*>(mutex);
+  kernel& k = kernel::get();
+  uint64_t give_up = timeout == TIMEOUT_MAX ? UINT64_MAX : k.micros_get() + timeout * 1000ull;
+  while (m->owner && m->owner != k.current()) {
+    if (k.micros_get() >= give_up) return false;
+    k.sleep_until(k.micros_get() + 1000);
+  }
+  m->owner = k.current();
+  return true;
+}
+
+bool mutex_give(mutex_t mutex) {
+  static_cast<sim_mutex*>(mutex)->owner = nullptr;
+  return true;
+}
+
+void mutex_delete(mutex_t mutex) { delete static_cast<sim_mutex*>(mutex); }
+
+int32_t usd_is_installed(void) { return 0; }
+}  // namespace c
+
+namespace usd {
+std::int32_t is_installed(void) { return c::usd_is_installed(); }
+}  // namespace usd
+
+inline namespace rtos {
+Task::Task(task_fn_t function, void* parameters, std::uint32_t prio, std::uint16_t stack_depth, const char* name)
+    : task(c::task_create(function, parameters, prio, stack_depth, name)) {}
+
+Task::Task(task_fn_t function, void* parameters, const char* name)
+    : Task(function, parameters, TASK_PRIORITY_DEFAULT, TASK_STACK_DEPTH_DEFAULT, name) {}
+
+Task::Task(task_t task) : task(task) {}
+
+Task Task::current() { return Task(c::task_get_current()); }
+
+void Task::suspend() { c::task_suspend(task); }
+
+void Task::resume() { c::task_resume(task); }
+
+std::uint32_t Task::get_priority() { return c::task_get_priority(task); }
+
+void Task::set_priority(std::uint32_t prio) { c::task_set_priority(task, prio); }
+
+std::uint32_t Task::notify() { return c::task_notify(task); }
+
+std::uint32_t Task::notify_take(bool clear_on_exit, std::uint32_t timeout) { return c::task_notify_take(clear_on_exit, timeout); }
+
+void Task::delay(const std::uint32_t milliseconds) { c::task_delay(milliseconds); }
+
+void Task::delay_until(std::uint32_t* const prev_time, const std::uint32_t delta) { c::task_delay_until(prev_time, delta); }
+
+char const* Task::get_name() { return c::task_get_name(task); }
+
+void Task::join() {
+  // Tasks only switch when they wait, so polling once a millisecond is enough
+  kernel::task* joined = task_get(task);
+  while (!joined->done) c::task_delay(1);
+}
+
+Clock::time_point Clock::now() { return time_point{duration{c::millis()}}; }
+
+Mutex::Mutex() : mutex(c::mutex_create(), c::mutex_delete) {}
+
+bool Mutex::take() { return c::mutex_take(mutex.get(), TIMEOUT_MAX); }
+
+bool Mutex::take(std::uint32_t timeout) { return c::mutex_take(mutex.get(), timeout); }
+
+bool Mutex::give() { return c::mutex_give(mutex.get()); }
+
+void Mutex::lock() { take(); }
+
+void Mutex::unlock() { give(); }
+
+bool Mutex::try_lock() { return take(0); }
+}  // namespace rtos
+}  // namespace pros
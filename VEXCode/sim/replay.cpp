@@ -0,0 +1,159 @@
+// Replays a flight recording through odometry and checks it makes the same poses the robot did.
+//
+//   make -C sim
+//   sim/pipeline_sim --record run.bin                  records a sim run, or copy one off the robot's SD card
+//   sim/replay run.bin                                 checks every pose and prints where it ended
+//   sim/replay run.bin --trace 50                      prints the pose every 50 updates
+//   sim/replay run.bin --integrator accel              replays through a different integrator to compare
+//
+// Poses are compared bit for bit with the recorded ones, the host runs the same double math the brain does.  With a
+// different integrator the differences show what that integrator would have done on the same run.  Recordings from
+// ez::Drive's own tracking task aren't replayable, for those this only prints the recorded trace.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "control/flight_recorder.hpp"
+
+static const char* NAMES[] = {"euler", "midpoint", "exponential", "accel"};
+
+struct replay_result {
+  int updates = 0;
+  int skipped = 0;     // updates before replay had a state to start from
+  int mismatched = 0;  // updates whose pose isn't bit for bit the recorded one
+  double max_error = 0.0;  // in
+  double max_angle = 0.0;  // deg
+  ez::pose last = {0.0, 0.0, 0.0};
+};
+
+// Runs every record through odometry, printing the pose every trace updates when trace isn't 0
+static replay_result replay(const std::vector<control::flight_record>& records, const control::flight_header& header,
+                            control::odom_integrator integrator, int trace) {
+  control::wheel_odometry odometry(header.wheels, integrator);
+  replay_result output;
+  bool following = false;
+  for (auto& r : records) {
+    if (r.type == control::FLIGHT_MOVED) {
+      odometry.state_set(r.moved);
+      following = true;
+      continue;
+    }
+    if (r.type != control::FLIGHT_UPDATE) continue;
+
+    output.updates++;
+    ez::pose recorded = {r.update.x, r.update.y, r.update.theta};
+    ez::pose pose = recorded;
+    if (following) {
+      pose = odometry.update(control::flight_snapshot(r));
+      if (memcmp(&pose.x, &recorded.x, sizeof(double)) != 0 || memcmp(&pose.y, &recorded.y, sizeof(double)) != 0 ||
+          memcmp(&pose.theta, &recorded.theta, sizeof(double)) != 0)
+        output.mismatched++;
+      output.max_error = fmax(output.max_error, hypot(pose.x - recorded.x, pose.y - recorded.y));
+      output.max_angle = fmax(output.max_angle, fabs(pose.theta - recorded.theta));
+    } else {
+      output.skipped++;
+    }
+    output.last = pose;
+    if (trace > 0 && output.updates % trace == 0)
+      printf("  %10.3f s  x %8.3f  y %8.3f  theta %8.2f   recorded %8.3f %8.3f %8.2f\n", r.timestamp / 1e6, pose.x, pose.y,
+             pose.theta, recorded.x, recorded.y, recorded.theta);
+  }
+  return output;
+}
+
+int main(int argc, char** argv) {
+  const char* path = nullptr;
+  int trace = 0;
+  int integrator = -1;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--integrator") == 0 && i + 1 < argc) {
+      i++;
+      for (int j = control::ODOM_EULER; j <= control::ODOM_EXPONENTIAL_ACCEL; j++)
+        if (strcmp(argv[i], NAMES[j]) == 0) integrator = j;
+      if (integrator == -1) {
+        printf("unknown integrator %s, pick from: euler midpoint exponential accel\n", argv[i]);
+        return 1;
+      }
+    } else if (!path && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (!path) {
+    printf("usage: %s file [--trace n] [--integrator euler|midpoint|exponential|accel]\n", argv[0]);
+    return 1;
+  }
+
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    printf("couldn't open %s\n", path);
+    return 1;
+  }
+  control::flight_header header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "FLIGHT\0\0", sizeof(header.magic)) != 0) {
+    printf("%s isn't a flight recording\n", path);
+    fclose(file);
+    return 1;
+  }
+  if (header.version != control::flight_recorder::VERSION || header.record_size != sizeof(control::flight_record)) {
+    printf("%s is version %u with %u byte records, this reads version %u with %u byte records\n", path, header.version,
+           header.record_size, control::flight_recorder::VERSION, (unsigned)sizeof(control::flight_record));
+    fclose(file);
+    return 1;
+  }
+  std::vector<control::flight_record> records;
+  control::flight_record record;
+  while (fread(&record, sizeof(record), 1, file) == 1) records.push_back(record);
+  fclose(file);
+
+  // Time covered by the recording, timestamps wrap every 71 minutes so add up the steps
+  double seconds = 0.0;
+  for (size_t i = 1; i < records.size(); i++) seconds += (uint32_t)(records[i].timestamp - records[i - 1].timestamp) / 1e6;
+
+  control::odom_wheels& w = header.wheels;
+  printf("%s: %zu records over %.2f s\n", path, records.size(), seconds);
+  printf("  wheels left %.2f right %.2f", w.left, w.right);
+  if (w.front_used) printf(" front %.2f", w.front);
+  if (w.back_used) printf(" back %.2f", w.back);
+  printf(" in, recorded with %s\n", header.integrator <= control::ODOM_EXPONENTIAL_ACCEL ? NAMES[header.integrator] : "?");
+
+  if (!header.replayable) {
+    printf("  odometry ran in ez::Drive's tracking task, printing the recorded poses only\n");
+    trace = trace > 0 ? trace : 1;
+  }
+  bool same = integrator == -1 || integrator == (int)header.integrator;
+  control::odom_integrator used = integrator == -1 ? (control::odom_integrator)header.integrator : (control::odom_integrator)integrator;
+  replay_result result = replay(records, header, header.replayable ? used : control::ODOM_MIDPOINT, trace);
+  if (!header.replayable) return 0;
+
+  // Time replay on its own, over enough passes for the clock to resolve it
+  int passes = 0;
+  auto start = std::chrono::steady_clock::now();
+  double wall = 0.0;
+  while (wall < 0.1) {
+    replay(records, header, used, 0);
+    passes++;
+    wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  wall /= passes;
+
+  printf("  replayed %d updates with %s", result.updates, NAMES[used]);
+  if (result.skipped > 0) printf(", %d before odometry's first state taken as recorded", result.skipped);
+  printf("\n");
+  if (same)
+    printf("  %d of %d poses differ from the recording", result.mismatched, result.updates - result.skipped);
+  else
+    printf("  against the recording");
+  printf(", largest difference %.6f in %.6f deg\n", result.max_error, result.max_angle);
+  printf("  final pose x %.3f y %.3f theta %.2f\n", result.last.x, result.last.y, result.last.theta);
+  printf("  %.1f us per pass, %.0fx real time\n", wall * 1e6, seconds / wall);
+  return same && result.mismatched > 0 ? 2 : 0;
+}
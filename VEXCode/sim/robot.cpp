@@ -0,0 +1,48 @@
+#include "robot.hpp"
+
+#include "control/ez_backend.hpp"
+#include "drive.hpp"
+#include "kernel.hpp"
+#include "world.hpp"
+
+// Same drive as the chassis in src/main.cpp
+control::devices_backend sim_backend({4, 2, -3}, {-10, -9, 8}, 6, 3.25, 360);
+control::pipeline drive_pipeline(sim_backend);
+ez::Drive chassis({4, 2, -3}, {-10, -9, 8}, 6, 3.25, 360);
+control::ez_backend chassis_backend(chassis);
+
+// Matches default_constants() in src/autons.cpp
+void sim::constants_set(control::motion_constants& constants) {
+  constants.drive.constants_set(20.0, 0.0, 100.0);
+  constants.heading.constants_set(11.0, 0.0, 20.0);
+  constants.turn.constants_set(4.0, 0.05, 20.0, 15.0);
+  constants.odom_xy.constants_set(20.0, 0.0, 100.0);
+  constants.odom_angular.constants_set(6.5, 0.0, 52.5);
+  constants.boomerang.constants_set(5.8, 0.0, 32.5);
+
+  constants.turn.exit_condition_set(90, 3, 250, 7, 500, 500);
+  constants.drive.exit_condition_set(90, 1, 250, 3, 500, 500);
+  constants.odom_xy.exit_condition_set(90, 1, 250, 3, 500, 750);
+  constants.odom_angular.exit_condition_set(90, 3, 250, 7, 500, 750);
+  constants.boomerang.exit_condition_set(90, 3, 250, 7, 500, 750);
+
+  constants.slew_turn.constants_set(3, 70);
+  constants.slew_drive.constants_set(3, 70);
+
+  constants.turn_bias = 0.9;
+  constants.look_ahead = 7.0;
+  constants.boomerang_distance = 16.0;
+  constants.dlead = 0.625;
+}
+
+void sim::robot_init() {
+  world& w = world::get();
+  kernel::get().world_set([&w](uint64_t us) { w.step_to(us); });
+  constants_set(drive_pipeline.constants);
+  drive_attach(chassis, drive_pipeline);
+}
+
+void sim::robot_reset() {
+  world::get().reset(drivetrain_config());
+  sim_backend.pose_set({0.0, 0.0, 0.0});
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "control/devices_backend.hpp"
+#include "control/pipeline.hpp"
+
+namespace ez {
+class Drive;
+}
+namespace control {
+class ez_backend;
+}
+
+// Same drive as the chassis in src/main.cpp
+extern control::devices_backend sim_backend;
+extern control::pipeline drive_pipeline;
+
+// The chassis the autons in src/autons.cpp move, its motions run in drive_pipeline
+extern ez::Drive chassis;
+extern control::ez_backend chassis_backend;
+
+namespace sim {
+/**
+ * Hooks the world up to the kernel, sets the pipeline's constants and attaches the chassis to the pipeline.  Call once before anything runs.
+ */
+void robot_init();
+
+/**
+ * Starts the world over with the robot at {0, 0, 0}.
+ */
+void robot_reset();
+
+/**
+ * Sets constants to match default_constants() in src/autons.cpp.
+ */
+void constants_set(control::motion_constants& constants);
+}  // namespace sim
@@ -0,0 +1,131 @@
+// Hammers the pose seqlock from real host threads and checks no read ever mixes two writes.  The simulator only runs one
+// task at a time, so this runs the seqlock on its own instead of through the pipeline.
+//
+//   make -C sim
+//   sim/stress                   one writer and 3 readers for 2 s
+//   sim/stress --readers 8 --seconds 10
+//
+// The writer publishes drive_states with every field set to the write count, the same way odometry publishes, and
+// readers check every field in each copy matches and matches the sequence number it came with.  For comparison the
+// same threads also read x, y and theta one at a time, like odom_x_get(), odom_y_get() and odom_theta_get(), and count
+// how often those mix writes.  If that count is 0 the threads never overlapped and the run proves nothing.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "control/motion.hpp"
+#include "control/seqlock.hpp"
+
+static control::seqlock<control::drive_state> published;
+
+// Separate fields, like ez::Drive's odom_current
+static std::atomic<double> x, y, theta;
+static std::atomic<bool> running{true};
+
+struct reader_result {
+  uint64_t reads = 0;
+  uint64_t torn = 0;       // a seqlock copy mixed two writes
+  uint64_t mismatched = 0;  // a copy's values didn't match its sequence
+  uint64_t backwards = 0;   // the sequence went down
+  uint64_t updates = 0;     // reads that saw a new write
+  uint64_t fields_mixed = 0;
+};
+
+static bool state_whole(const control::drive_state& s, double n) {
+  const double fields[] = {s.left, s.right, s.left_velocity, s.right_velocity, s.left_mA, s.right_mA, s.imu, s.imu_rate, s.tracker_left,
+                           s.tracker_right, s.tracker_front, s.tracker_back, s.pose.x, s.pose.y, s.pose.theta};
+  for (double f : fields)
+    if (f != n) return false;
+  return s.left_timestamp == (uint32_t)n && s.right_timestamp == (uint32_t)n && s.timestamp == (uint64_t)n;
+}
+
+static void writer_run(uint64_t* writes) {
+  uint64_t n = 0;
+  while (running.load(std::memory_order_relaxed)) {
+    n++;
+    double v = n;
+    control::drive_state s;
+    s.left = s.right = s.left_velocity = s.right_velocity = s.left_mA = s.right_mA = v;
+    s.imu = s.imu_rate = s.tracker_left = s.tracker_right = s.tracker_front = s.tracker_back = v;
+    s.left_timestamp = s.right_timestamp = n;
+    s.timestamp = n;
+    s.pose = {v, v, v};
+    published.write(s);
+
+    x.store(v, std::memory_order_relaxed);
+    y.store(v, std::memory_order_relaxed);
+    theta.store(v, std::memory_order_relaxed);
+  }
+  *writes = n;
+}
+
+static void reader_run(reader_result* r) {
+  uint32_t last = 0;
+  while (running.load(std::memory_order_relaxed)) {
+    uint32_t sequence;
+    control::drive_state s = published.read(&sequence);
+    r->reads++;
+    if (!state_whole(s, s.left)) r->torn++;
+    if (s.left != (double)sequence) r->mismatched++;
+    // The 32 bit sequence wraps long after a run ends
+    if (sequence < last) r->backwards++;
+    if (sequence != last) r->updates++;
+    last = sequence;
+
+    double a = x.load(std::memory_order_relaxed);
+    double b = y.load(std::memory_order_relaxed);
+    double c = theta.load(std::memory_order_relaxed);
+    if (a != b || b != c) r->fields_mixed++;
+  }
+}
+
+int main(int argc, char** argv) {
+  int readers = 3;
+  double seconds = 2.0;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--readers") == 0 && i + 1 < argc) {
+      readers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else {
+      printf("usage: %s [--readers n] [--seconds s]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (readers < 1) readers = 1;
+
+  uint64_t writes = 0;
+  std::vector<reader_result> results(readers);
+  std::vector<std::thread> threads;
+  threads.emplace_back(writer_run, &writes);
+  for (auto& r : results) threads.emplace_back(reader_run, &r);
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  running = false;
+  for (auto& t : threads) t.join();
+
+  reader_result total;
+  for (auto& r : results) {
+    total.reads += r.reads;
+    total.torn += r.torn;
+    total.mismatched += r.mismatched;
+    total.backwards += r.backwards;
+    total.updates += r.updates;
+    total.fields_mixed += r.fields_mixed;
+  }
+  printf("%d readers, %.1f s, %llu writes\n", readers, seconds, (unsigned long long)writes);
+  printf("  odom_pose_get   %llu reads, %llu saw a new write, %llu torn, %llu off their sequence, %llu went backwards\n",
+         (unsigned long long)total.reads, (unsigned long long)total.updates, (unsigned long long)total.torn,
+         (unsigned long long)total.mismatched, (unsigned long long)total.backwards);
+  printf("  x, y, theta     %llu reads mixed writes\n", (unsigned long long)total.fields_mixed);
+  if (total.fields_mixed == 0) printf("  threads never overlapped, run longer or with more readers\n");
+
+  bool failed = total.torn || total.mismatched || total.backwards;
+  printf("%s\n", failed ? "FAILED" : "ok");
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,279 @@
+// Sweeps the six exit condition values for each kind of motion over the pipeline autons, then prints the settings that
+// trade auton time against final pose error best.  Settings are run in parallel, one worker process per core, since the
+// simulator is one world per process.
+//
+//   make -C sim
+//   sim/sweep                          sweeps drive, turn, odom_drive and odom_turn, one at a time
+//   sim/sweep turn odom_turn           sweeps just these
+//   sim/sweep --max-error 1.5          picks the fastest settings within 1.5 of final error
+//   sim/sweep --jobs 4                 worker count
+//
+// Each kind is swept with every other kind left on its default_constants() values.  A setting's time is the simulated
+// time to run every auton, and its error adds up how far each auton ended from where its last motion was going, with
+// 10 degrees off counting the same as an inch.  The Pareto frontier is every setting that no other setting beats on
+// both.  Without --max-error the pick is the fastest setting on the frontier that's no less accurate than the default.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "autons.hpp"
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "workers.hpp"
+#include "world.hpp"
+
+struct auton {
+  void (*run)();
+  uint32_t limit;  // ms
+};
+
+// The pipeline autons, same as sim/main.cpp
+static const auton AUTONS[] = {
+    {pipeline_boomerang_example, 15000},
+    {pipeline_queue_example, 15000},
+};
+
+// small_time, small_error, big_time, big_error, velocity_time, mA_time, same order as exit_condition_set()
+struct exit_setting {
+  double values[6];
+};
+
+struct exit_kind {
+  const char* name;  // as in chassis.pid_<name>_exit_condition_set()
+  const char* unit;
+  exit_setting current;  // from default_constants()
+  std::vector<double> grid[6];
+};
+
+static const exit_kind KINDS[] = {
+    {"drive", "in", {{90, 1, 250, 3, 500, 500}}, {{20, 50, 90}, {0.5, 1, 2}, {100, 250}, {2, 3, 5}, {150, 300, 500}, {250, 500, 750}}},
+    {"turn", "deg", {{90, 3, 250, 7, 500, 500}}, {{20, 50, 90}, {1.5, 3, 5}, {100, 250}, {5, 7, 10}, {150, 300, 500}, {250, 500, 750}}},
+    {"odom_drive", "in", {{90, 1, 250, 3, 500, 750}}, {{20, 50, 90}, {0.5, 1, 2}, {100, 250}, {2, 3, 5}, {150, 300, 500}, {250, 500, 750}}},
+    {"odom_turn", "deg", {{90, 3, 250, 7, 500, 750}}, {{20, 50, 90}, {1.5, 3, 5}, {100, 250}, {5, 7, 10}, {150, 300, 500}, {250, 500, 750}}},
+};
+static const int KIND_COUNT = sizeof(KINDS) / sizeof(KINDS[0]);
+
+struct result {
+  exit_setting setting;
+  double time;   // s
+  double error;  // in, 10 deg counts as 1 in
+  double worst;  // worst error a single motion exited with
+  bool finished;
+};
+
+/////
+// Worker side, runs the autons in the simulator
+/////
+static double pose_error(const ez::pose& target, const ez::pose& actual) {
+  double output = ez::util::distance_to_point(target, actual);
+  // Targets given in okapi units come through the degree conversion a hair off ANGLE_NOT_SET
+  if (fabs(target.theta - ez::ANGLE_NOT_SET) > 1e-12) output += fabs(ez::util::wrap_angle(target.theta - actual.theta)) / 10.0;
+  return output;
+}
+
+static void setting_apply(int kind, const exit_setting& s) {
+  control::motion_constants& c = drive_pipeline.constants;
+  sim::constants_set(c);
+  const double* v = s.values;
+  switch (kind) {
+    case 0:
+      c.drive.exit_condition_set(v[0], v[1], v[2], v[3], v[4], v[5]);
+      break;
+    case 1:
+      c.turn.exit_condition_set(v[0], v[1], v[2], v[3], v[4], v[5]);
+      break;
+    case 2:
+      c.odom_xy.exit_condition_set(v[0], v[1], v[2], v[3], v[4], v[5]);
+      break;
+    case 3:
+      // ez::Drive's odom turn exits cover boomerang too
+      c.odom_angular.exit_condition_set(v[0], v[1], v[2], v[3], v[4], v[5]);
+      c.boomerang.exit_condition_set(v[0], v[1], v[2], v[3], v[4], v[5]);
+      break;
+  }
+}
+
+static result setting_run(int kind, const exit_setting& s) {
+  sim::world& world = sim::world::get();
+  sim::kernel& kernel = sim::kernel::get();
+  setting_apply(kind, s);
+  result output = {s, 0.0, 0.0, 0.0, true};
+  for (auto& a : AUTONS) {
+    sim::robot_reset();
+    drive_pipeline.history_clear();
+    uint64_t start = kernel.micros_get();
+    kernel.deadline_set(start + a.limit * 1000ull);
+    try {
+      a.run();
+    } catch (const sim::deadline_exceeded&) {
+      output.finished = false;
+    }
+    kernel.deadline_set(0);
+    drive_pipeline.disable();
+    output.time += (kernel.micros_get() - start) / 1e6;
+
+    std::vector<control::motion_record> history = drive_pipeline.history_get();
+    for (auto& r : history) output.worst = fmax(output.worst, pose_error(r.target, r.pose));
+    if (!history.empty()) output.error += pose_error(history.back().target, {world.x, world.y, world.theta});
+  }
+  return output;
+}
+
+// Answers "kind v0 v1 v2 v3 v4 v5" lines with "time error worst finished"
+static int worker_run() {
+  sim::robot_init();
+  return sim::worker_serve([](const char* job) {
+    char* cursor = (char*)job;
+    int kind = strtol(cursor, &cursor, 10);
+    exit_setting s;
+    for (double& v : s.values) v = strtod(cursor, &cursor);
+    result r = setting_run(kind, s);
+    char output[96];
+    snprintf(output, sizeof(output), "%.9g %.9g %.9g %d", r.time, r.error, r.worst, r.finished);
+    return std::string(output);
+  });
+}
+
+/////
+// Parent side, builds the grid and reports
+/////
+static std::vector<exit_setting> grid_get(const exit_kind& k) {
+  std::vector<exit_setting> output = {k.current};
+  exit_setting s;
+  // Odometer over every combination
+  int index[6] = {0};
+  while (true) {
+    for (int i = 0; i < 6; i++) s.values[i] = k.grid[i][index[i]];
+    // Small exits inside big exits, anything else never uses the small exit
+    if (s.values[1] < s.values[3]) output.push_back(s);
+    int i = 0;
+    while (i < 6 && ++index[i] == (int)k.grid[i].size()) index[i++] = 0;
+    if (i == 6) break;
+  }
+  return output;
+}
+
+// Settings no other setting beats on both time and error, fastest first
+static std::vector<result> frontier_get(std::vector<result> results) {
+  std::sort(results.begin(), results.end(), [](const result& a, const result& b) { return a.time != b.time ? a.time < b.time : a.error < b.error; });
+  std::vector<result> output;
+  for (auto& r : results) {
+    if (!r.finished) continue;
+    if (output.empty() || r.error < output.back().error) output.push_back(r);
+  }
+  return output;
+}
+
+static void setting_print(const exit_setting& s, const char* unit) {
+  const double* v = s.values;
+  printf("%4.0f ms %4.2g %-3s %4.0f ms %4.2g %-3s %4.0f ms %4.0f ms", v[0], v[1], unit, v[2], v[3], unit, v[4], v[5]);
+}
+
+static void result_print(const char* label, const result& r, const char* unit) {
+  printf("  %-8s ", label);
+  setting_print(r.setting, unit);
+  printf("  %6.2f s %6.2f %6.2f\n", r.time, r.error, r.worst);
+}
+
+static void kind_sweep(std::vector<sim::worker>& workers, int kind, double max_error) {
+  const exit_kind& k = KINDS[kind];
+  std::vector<exit_setting> grid = grid_get(k);
+  std::vector<std::string> jobs;
+  for (auto& s : grid) {
+    std::string job = std::to_string(kind);
+    char value[32];
+    for (double v : s.values) {
+      snprintf(value, sizeof(value), " %.17g", v);
+      job += value;
+    }
+    jobs.push_back(job);
+  }
+  std::vector<std::string> answers = sim::jobs_run(workers, jobs, [&](size_t done) {
+    if (done % 32 == 0 || done == jobs.size()) fprintf(stderr, "\r%-10s %zu/%zu", k.name, done, jobs.size());
+  });
+  fprintf(stderr, "\n");
+
+  std::vector<result> results;
+  int timed_out = 0;
+  for (size_t i = 0; i < grid.size(); i++) {
+    result r = {grid[i]};
+    int finished = 0;
+    sscanf(answers[i].c_str(), "%lf %lf %lf %d", &r.time, &r.error, &r.worst, &finished);
+    r.finished = finished;
+    if (!r.finished) timed_out++;
+    results.push_back(r);
+  }
+  const result& current = results[0];
+  std::vector<result> frontier = frontier_get(results);
+
+  printf("%s exits, %zu settings, %d timed out\n", k.name, grid.size() - 1, timed_out);
+  printf("  %-8s %-16s %-16s %-7s %-7s  %8s %6s %6s\n", "", "small", "big", "velocity", "mA", "time", "error", "worst");
+  result_print(current.finished ? "current" : "current!", current, k.unit);
+  for (auto& r : frontier) result_print("", r, k.unit);
+
+  // Fastest on the frontier that's still accurate enough
+  double limit = max_error >= 0.0 ? max_error : current.error;
+  const result* pick = nullptr;
+  for (auto& r : frontier) {
+    if (r.error <= limit + 1e-9) {
+      pick = &r;
+      break;
+    }
+  }
+  if (pick && pick->time >= current.time) {
+    printf("  nothing faster than current within %.2f error\n", limit);
+  } else if (pick) {
+    const double* v = pick->setting.values;
+    printf("  fastest within %.2f error, %.2f s faster than current:\n", limit, current.time - pick->time);
+    printf("  chassis.pid_%s_exit_condition_set(%.0f_ms, %.2g_%s, %.0f_ms, %.2g_%s, %.0f_ms, %.0f_ms);\n", k.name, v[0], v[1], k.unit, v[2],
+           v[3], k.unit, v[4], v[5]);
+  } else {
+    printf("  nothing within %.2f error\n", limit);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--worker") == 0) return worker_run();
+
+  int jobs = std::thread::hardware_concurrency();
+  double max_error = -1.0;
+  std::vector<int> kinds;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+      jobs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-error") == 0 && i + 1 < argc) {
+      max_error = atof(argv[++i]);
+    } else {
+      int found = -1;
+      for (int k = 0; k < KIND_COUNT; k++)
+        if (strcmp(argv[i], KINDS[k].name) == 0) found = k;
+      if (found == -1) {
+        printf("unknown motion %s, pick from:", argv[i]);
+        for (auto& k : KINDS) printf(" %s", k.name);
+        printf("\n");
+        return 1;
+      }
+      kinds.push_back(found);
+    }
+  }
+  if (kinds.empty())
+    for (int k = 0; k < KIND_COUNT; k++) kinds.push_back(k);
+  if (jobs < 1) jobs = 1;
+
+  std::vector<sim::worker> workers = sim::workers_start(jobs);
+  if (workers.empty()) {
+    printf("couldn't start any workers\n");
+    return 1;
+  }
+  fprintf(stderr, "%d workers\n", (int)workers.size());
+  for (int k : kinds) kind_sweep(workers, k, max_error);
+  sim::workers_stop(workers);
+  return 0;
+}
@@ -0,0 +1,436 @@
+// Tunes the constants in default_constants() with particle swarms against the simulated drivetrain.  Particles are
+// scored in parallel, one worker process per core, since the simulator is one world per process.
+//
+//   make -C sim
+//   sim/tuner                                 tunes every group, then prints a default_constants() block
+//   sim/tuner turn swing                      tunes just these groups
+//   sim/tuner --particles 32 --iterations 40  bigger swarm, more iterations
+//   sim/tuner --jobs 4 --seed 7               worker count and random seed
+//   sim/tuner --time 1 --overshoot 2 --error 4
+//                                             cost weights for seconds, overshoot and final error
+//
+// Groups are tuned one at a time in order, each with the groups before it already tuned.  A group's cost adds up every
+// motion it runs: weighted time to exit, how far the robot went past the target, and how far off it came to rest.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kernel.hpp"
+#include "robot.hpp"
+#include "workers.hpp"
+#include "world.hpp"
+
+// Everything the tuner can change, with the values from src/autons.cpp
+struct exit_tuning {
+  double small_time, small_error, big_time, big_error, velocity_time, mA_time;
+};
+
+struct tuning {
+  ez::PID::Constants drive = {20.0, 0.0, 100.0, 0.0};
+  ez::PID::Constants heading = {11.0, 0.0, 20.0, 0.0};
+  ez::PID::Constants turn = {4.0, 0.05, 20.0, 15.0};
+  ez::PID::Constants swing = {6.0, 0.0, 65.0, 0.0};
+  ez::PID::Constants odom_angular = {6.5, 0.0, 52.5, 0.0};
+  ez::PID::Constants boomerang = {5.8, 0.0, 32.5, 0.0};
+  exit_tuning drive_exit = {90, 1, 250, 3, 500, 500};
+  exit_tuning turn_exit = {90, 3, 250, 7, 500, 500};
+  exit_tuning swing_exit = {90, 3, 250, 7, 500, 500};
+};
+
+enum e_group { DRIVE, TURN, SWING, ODOM_ANGULAR, BOOMERANG, GROUPS };
+static const char* GROUP_NAMES[GROUPS] = {"drive", "turn", "swing", "odom_angular", "boomerang"};
+
+struct param {
+  e_group group;
+  const char* name;
+  double low, high;
+  double& (*get)(tuning&);
+};
+
+// Every tuned value.  Workers get all of them so later groups run with earlier groups' results
+static const param PARAMS[] = {
+    {DRIVE, "drive kp", 5.0, 60.0, [](tuning& t) -> double& { return t.drive.kp; }},
+    {DRIVE, "drive kd", 0.0, 300.0, [](tuning& t) -> double& { return t.drive.kd; }},
+    {DRIVE, "heading kp", 2.0, 30.0, [](tuning& t) -> double& { return t.heading.kp; }},
+    {DRIVE, "heading kd", 0.0, 80.0, [](tuning& t) -> double& { return t.heading.kd; }},
+    {DRIVE, "drive small exit time", 20.0, 150.0, [](tuning& t) -> double& { return t.drive_exit.small_time; }},
+    {DRIVE, "drive small error", 0.25, 2.0, [](tuning& t) -> double& { return t.drive_exit.small_error; }},
+    {TURN, "turn kp", 1.0, 12.0, [](tuning& t) -> double& { return t.turn.kp; }},
+    {TURN, "turn ki", 0.0, 0.2, [](tuning& t) -> double& { return t.turn.ki; }},
+    {TURN, "turn kd", 0.0, 80.0, [](tuning& t) -> double& { return t.turn.kd; }},
+    {TURN, "turn small exit time", 20.0, 150.0, [](tuning& t) -> double& { return t.turn_exit.small_time; }},
+    {TURN, "turn small error", 0.5, 4.0, [](tuning& t) -> double& { return t.turn_exit.small_error; }},
+    {SWING, "swing kp", 1.0, 15.0, [](tuning& t) -> double& { return t.swing.kp; }},
+    {SWING, "swing kd", 0.0, 120.0, [](tuning& t) -> double& { return t.swing.kd; }},
+    {SWING, "swing small exit time", 20.0, 150.0, [](tuning& t) -> double& { return t.swing_exit.small_time; }},
+    {SWING, "swing small error", 0.5, 4.0, [](tuning& t) -> double& { return t.swing_exit.small_error; }},
+    {ODOM_ANGULAR, "odom angular kp", 1.0, 15.0, [](tuning& t) -> double& { return t.odom_angular.kp; }},
+    {ODOM_ANGULAR, "odom angular kd", 0.0, 120.0, [](tuning& t) -> double& { return t.odom_angular.kd; }},
+    {BOOMERANG, "boomerang kp", 1.0, 15.0, [](tuning& t) -> double& { return t.boomerang.kp; }},
+    {BOOMERANG, "boomerang kd", 0.0, 120.0, [](tuning& t) -> double& { return t.boomerang.kd; }},
+};
+static const int PARAM_COUNT = sizeof(PARAMS) / sizeof(PARAMS[0]);
+
+// Cost weights, per second, per inch or degree past the target, and per inch or degree off at rest
+static double weight_time = 1.0;
+static double weight_overshoot = 0.5;
+static double weight_error = 1.0;
+
+// Added for every motion that never exits
+static const double TIMEOUT_COST = 10.0;
+
+static const int SPEED = 110;
+
+/////
+// Worker side, runs motions in the simulator
+/////
+
+// ez::Drive swings one side and holds the other still.  The pipeline has no swing, so this does the same for tuning
+class swing_motion : public control::motion {
+ public:
+  swing_motion(const ez::PID& tuned, double target, bool left) : pid(tuned), target(target), left(left) {}
+  ez::pose end_get(const ez::pose& start) override { return {start.x, start.y, target}; }
+  void initialize(const control::drive_state& state) override { pid.start(target, state.imu); }
+  control::drive_output iterate(const control::drive_state& state) override {
+    double out = ez::util::clamp(pid.compute(state.imu), SPEED);
+    if (exit == ez::RUNNING) exit = pid.exit_condition();
+    // Driving the left side forward turns clockwise, driving the right side backward does too
+    if (left) return {out, 0.0};
+    return {0.0, -out};
+  }
+  ez::exit_output exit_condition() override { return exit; }
+  const char* name_get() override { return "swing"; }
+
+ private:
+  control::motion_pid pid;
+  double target;
+  bool left;
+  ez::exit_output exit = ez::RUNNING;
+};
+
+static ez::PID pid_make(const ez::PID::Constants& c, const exit_tuning& e) {
+  ez::PID output(c.kp, c.ki, c.kd, c.start_i);
+  output.exit_condition_set(e.small_time, e.small_error, e.big_time, e.big_error, e.velocity_time, e.mA_time);
+  return output;
+}
+
+static void constants_apply(tuning& t) {
+  control::motion_constants& c = drive_pipeline.constants;
+  sim::constants_set(c);
+  // ez::Drive's drive constants are used for odom motions too
+  c.drive.constants_set(t.drive.kp, t.drive.ki, t.drive.kd, t.drive.start_i);
+  c.odom_xy.constants_set(t.drive.kp, t.drive.ki, t.drive.kd, t.drive.start_i);
+  c.heading.constants_set(t.heading.kp, t.heading.ki, t.heading.kd, t.heading.start_i);
+  c.turn.constants_set(t.turn.kp, t.turn.ki, t.turn.kd, t.turn.start_i);
+  c.odom_angular.constants_set(t.odom_angular.kp, t.odom_angular.ki, t.odom_angular.kd, t.odom_angular.start_i);
+  c.boomerang.constants_set(t.boomerang.kp, t.boomerang.ki, t.boomerang.kd, t.boomerang.start_i);
+  exit_tuning& d = t.drive_exit;
+  c.drive.exit_condition_set(d.small_time, d.small_error, d.big_time, d.big_error, d.velocity_time, d.mA_time);
+  exit_tuning& n = t.turn_exit;
+  c.turn.exit_condition_set(n.small_time, n.small_error, n.big_time, n.big_error, n.velocity_time, n.mA_time);
+}
+
+// Runs one motion from rest at the origin and scores it.  progress is how far the robot has gone towards target, so
+// anything past target is overshoot.  error is how far off the robot is once it has come to rest.
+static double motion_cost(std::function<void()> start, std::function<double(const sim::world&)> progress, double target,
+                          std::function<double(const sim::world&)> error, double limit) {
+  sim::world& world = sim::world::get();
+  sim::kernel& kernel = sim::kernel::get();
+  sim::robot_reset();
+  drive_pipeline.history_clear();
+  drive_pipeline.enable();
+
+  uint64_t begin = kernel.micros_get();
+  kernel.deadline_set(begin + limit * 1000000.0);
+  double overshoot = 0.0;
+  bool finished = true;
+  try {
+    start();
+    do {
+      pros::delay(10);
+      overshoot = fmax(overshoot, progress(world) - target);
+    } while (drive_pipeline.exit_get() == ez::RUNNING);
+  } catch (const sim::deadline_exceeded&) {
+    finished = false;
+  }
+  kernel.deadline_set(0);
+  double time = (kernel.micros_get() - begin) / 1000000.0;
+  drive_pipeline.disable();
+
+  // Let the robot come to rest, it can still overshoot after the motion exits
+  for (int i = 0; i < 25; i++) {
+    pros::delay(10);
+    overshoot = fmax(overshoot, progress(world) - target);
+  }
+  double cost = weight_time * time + weight_overshoot * overshoot + weight_error * error(world);
+  return finished ? cost : cost + TIMEOUT_COST;
+}
+
+static double drive_cost(double distance) {
+  double sign = distance < 0 ? -1.0 : 1.0;
+  // Holding the heading is part of driving straight
+  return motion_cost([distance]() { drive_pipeline.pid_drive_set(distance, SPEED); },
+                     [sign](const sim::world& w) { return sign * w.y; }, fabs(distance),
+                     [distance](const sim::world& w) { return fabs(w.y - distance) + fabs(w.x) + fabs(ez::util::wrap_angle(w.theta)) / 10.0; }, 4.0);
+}
+
+static double turn_cost(double angle) {
+  double sign = angle < 0 ? -1.0 : 1.0;
+  return motion_cost([angle]() { drive_pipeline.pid_turn_set(angle, SPEED); }, [sign](const sim::world& w) { return sign * w.theta; }, fabs(angle),
+                     [angle](const sim::world& w) { return fabs(ez::util::wrap_angle(w.theta - angle)); }, 3.0);
+}
+
+static double swing_cost(double angle, bool left, const tuning& t) {
+  ez::PID tuned = pid_make(t.swing, t.swing_exit);
+  double sign = angle < 0 ? -1.0 : 1.0;
+  return motion_cost([&tuned, angle, left]() { drive_pipeline.motion_set(std::make_unique<swing_motion>(tuned, angle, left)); },
+                     [sign](const sim::world& w) { return sign * w.theta; }, fabs(angle),
+                     [angle](const sim::world& w) { return fabs(ez::util::wrap_angle(w.theta - angle)); }, 3.0);
+}
+
+static double odom_cost(ez::pose target) {
+  // Progress is along the line from the start to the target
+  double length = hypot(target.x, target.y);
+  auto progress = [target, length](const sim::world& w) { return (w.x * target.x + w.y * target.y) / length; };
+  auto error = [target](const sim::world& w) {
+    double output = hypot(w.x - target.x, w.y - target.y);
+    if (target.theta != ez::ANGLE_NOT_SET) output += fabs(ez::util::wrap_angle(w.theta - target.theta)) / 10.0;
+    return output;
+  };
+  return motion_cost([target]() { drive_pipeline.pid_odom_set({target, ez::fwd, SPEED}); }, progress, length, error, 5.0);
+}
+
+static double group_cost(e_group group, tuning& t) {
+  constants_apply(t);
+  switch (group) {
+    case DRIVE:
+      return drive_cost(6.0) + drive_cost(24.0) + drive_cost(48.0) + drive_cost(-24.0);
+    case TURN:
+      return turn_cost(30.0) + turn_cost(90.0) + turn_cost(180.0);
+    case SWING:
+      return swing_cost(45.0, true, t) + swing_cost(90.0, true, t) + swing_cost(-90.0, false, t);
+    case ODOM_ANGULAR:
+      return odom_cost({12.0, 24.0, ez::ANGLE_NOT_SET}) + odom_cost({-24.0, 24.0, ez::ANGLE_NOT_SET}) + odom_cost({24.0, 6.0, ez::ANGLE_NOT_SET});
+    case BOOMERANG:
+      return odom_cost({24.0, 24.0, 90.0}) + odom_cost({-12.0, 30.0, -45.0}) + odom_cost({0.0, 36.0, 45.0});
+    default:
+      return 0.0;
+  }
+}
+
+// Answers "group value value ..." lines with their cost
+static int worker_run(int argc, char** argv) {
+  if (argc >= 5) {
+    weight_time = atof(argv[2]);
+    weight_overshoot = atof(argv[3]);
+    weight_error = atof(argv[4]);
+  }
+  sim::robot_init();
+  return sim::worker_serve([](const char* job) {
+    tuning t;
+    char* cursor = (char*)job;
+    int group = strtol(cursor, &cursor, 10);
+    for (auto& p : PARAMS) p.get(t) = strtod(cursor, &cursor);
+    char output[32];
+    snprintf(output, sizeof(output), "%.9g", group_cost((e_group)group, t));
+    return std::string(output);
+  });
+}
+
+/////
+// Parent side, runs the swarm
+/////
+// Scores every candidate across the workers
+static std::vector<double> costs_get(std::vector<sim::worker>& workers, e_group group, const std::vector<tuning>& candidates) {
+  std::vector<std::string> jobs;
+  for (tuning t : candidates) {
+    std::string job = std::to_string(group);
+    char value[32];
+    for (auto& p : PARAMS) {
+      snprintf(value, sizeof(value), " %.17g", p.get(t));
+      job += value;
+    }
+    jobs.push_back(job);
+  }
+  std::vector<double> output;
+  for (auto& answer : sim::jobs_run(workers, jobs)) output.push_back(strtod(answer.c_str(), nullptr));
+  return output;
+}
+
+struct particle {
+  std::vector<double> position, velocity, best;
+  double best_cost = INFINITY;
+};
+
+static tuning tuning_with(tuning base, const std::vector<int>& dims, const std::vector<double>& position) {
+  for (size_t i = 0; i < dims.size(); i++) PARAMS[dims[i]].get(base) = position[i];
+  return base;
+}
+
+// Standard constriction-factor swarm.  Particle 0 starts on the current constants so the result is never worse
+static tuning group_tune(std::vector<sim::worker>& workers, e_group group, tuning base, int particles, int iterations, std::mt19937& rng) {
+  std::vector<int> dims;
+  for (int i = 0; i < PARAM_COUNT; i++)
+    if (PARAMS[i].group == group) dims.push_back(i);
+
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<particle> swarm(particles);
+  for (int i = 0; i < particles; i++) {
+    for (int d : dims) {
+      const param& p = PARAMS[d];
+      double range = p.high - p.low;
+      swarm[i].position.push_back(i == 0 ? p.get(base) : p.low + unit(rng) * range);
+      swarm[i].velocity.push_back((unit(rng) - 0.5) * range * 0.2);
+    }
+  }
+
+  std::vector<double> global_best;
+  double global_cost = INFINITY, start_cost = INFINITY;
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    std::vector<tuning> candidates;
+    for (auto& s : swarm) candidates.push_back(tuning_with(base, dims, s.position));
+    std::vector<double> costs = costs_get(workers, group, candidates);
+    if (iteration == 0) start_cost = costs[0];
+
+    for (int i = 0; i < particles; i++) {
+      if (costs[i] < swarm[i].best_cost) {
+        swarm[i].best_cost = costs[i];
+        swarm[i].best = swarm[i].position;
+      }
+      if (costs[i] < global_cost) {
+        global_cost = costs[i];
+        global_best = swarm[i].position;
+      }
+    }
+    fprintf(stderr, "\r%-12s iteration %3d/%d  cost %.3f -> %.3f", GROUP_NAMES[group], iteration + 1, iterations, start_cost, global_cost);
+
+    for (auto& s : swarm) {
+      for (size_t d = 0; d < dims.size(); d++) {
+        const param& p = PARAMS[dims[d]];
+        double range = p.high - p.low;
+        s.velocity[d] = 0.7298 * s.velocity[d] + 1.49618 * unit(rng) * (s.best[d] - s.position[d]) + 1.49618 * unit(rng) * (global_best[d] - s.position[d]);
+        s.velocity[d] = ez::util::clamp(s.velocity[d], range * 0.2);
+        s.position[d] = ez::util::clamp(s.position[d] + s.velocity[d], p.high, p.low);
+      }
+    }
+  }
+  fprintf(stderr, "\n");
+  return tuning_with(base, dims, global_best);
+}
+
+static void exit_print(const char* name, const exit_tuning& e, const char* unit) {
+  printf("  chassis.pid_%s_exit_condition_set(%.0f_ms, %.2g_%s, %.0f_ms, %.2g_%s, %.0f_ms, %.0f_ms);\n", name, e.small_time, e.small_error, unit,
+         e.big_time, e.big_error, unit, e.velocity_time, e.mA_time);
+}
+
+static void constants_print(const char* name, const ez::PID::Constants& c, const char* comment) {
+  char call[128];
+  if (c.start_i != 0.0)
+    snprintf(call, sizeof(call), "chassis.pid_%s_constants_set(%.2f, %.3f, %.2f, %.1f);", name, c.kp, c.ki, c.kd, c.start_i);
+  else
+    snprintf(call, sizeof(call), "chassis.pid_%s_constants_set(%.2f, %.3f, %.2f);", name, c.kp, c.ki, c.kd);
+  printf("  %-62s // %s\n", call, comment);
+}
+
+// Same layout as default_constants() in src/autons.cpp
+static void default_constants_print(const tuning& t) {
+  printf("void default_constants() {\n");
+  printf("  // P, I, D, and Start I\n");
+  constants_print("drive", t.drive, "Fwd/rev constants, used for odom and non odom motions");
+  constants_print("heading", t.heading, "Holds the robot straight while going forward without odom");
+  constants_print("turn", t.turn, "Turn in place constants");
+  constants_print("swing", t.swing, "Swing constants");
+  constants_print("odom_angular", t.odom_angular, "Angular control for odom motions");
+  constants_print("odom_boomerang", t.boomerang, "Angular control for boomerang motions");
+  printf("\n  // Exit conditions\n");
+  exit_print("turn", t.turn_exit, "deg");
+  exit_print("swing", t.swing_exit, "deg");
+  exit_print("drive", t.drive_exit, "in");
+  printf("  chassis.pid_odom_turn_exit_condition_set(90_ms, 3_deg, 250_ms, 7_deg, 500_ms, 750_ms);\n");
+  printf("  chassis.pid_odom_drive_exit_condition_set(90_ms, 1_in, 250_ms, 3_in, 500_ms, 750_ms);\n");
+  printf("  chassis.pid_turn_chain_constant_set(3_deg);\n");
+  printf("  chassis.pid_swing_chain_constant_set(5_deg);\n");
+  printf("  chassis.pid_drive_chain_constant_set(3_in);\n");
+  printf("\n  // Slew constants\n");
+  printf("  chassis.slew_turn_constants_set(3_deg, 70);\n");
+  printf("  chassis.slew_drive_constants_set(3_in, 70);\n");
+  printf("  chassis.slew_swing_constants_set(3_in, 80);\n");
+  printf("\n  chassis.odom_turn_bias_set(0.9);\n");
+  printf("  chassis.odom_look_ahead_set(7_in);\n");
+  printf("  chassis.odom_boomerang_distance_set(16_in);\n");
+  printf("  chassis.odom_boomerang_dlead_set(0.625);\n");
+  printf("\n  chassis.pid_angle_behavior_set(ez::shortest);\n");
+  printf("}\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1 && strcmp(argv[1], "--worker") == 0) return worker_run(argc, argv);
+
+  int particles = 24, iterations = 30, jobs = std::thread::hardware_concurrency();
+  unsigned seed = 1;
+  std::vector<e_group> groups;
+  for (int i = 1; i < argc; i++) {
+    auto number = [&](double& out) {
+      if (i + 1 < argc) out = atof(argv[++i]);
+    };
+    double value = 0.0;
+    if (strcmp(argv[i], "--particles") == 0) {
+      number(value);
+      particles = value;
+    } else if (strcmp(argv[i], "--iterations") == 0) {
+      number(value);
+      iterations = value;
+    } else if (strcmp(argv[i], "--jobs") == 0) {
+      number(value);
+      jobs = value;
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      number(value);
+      seed = value;
+    } else if (strcmp(argv[i], "--time") == 0) {
+      number(weight_time);
+    } else if (strcmp(argv[i], "--overshoot") == 0) {
+      number(weight_overshoot);
+    } else if (strcmp(argv[i], "--error") == 0) {
+      number(weight_error);
+    } else {
+      int found = -1;
+      for (int g = 0; g < GROUPS; g++)
+        if (strcmp(argv[i], GROUP_NAMES[g]) == 0) found = g;
+      if (found == -1) {
+        printf("unknown group %s, pick from:", argv[i]);
+        for (auto name : GROUP_NAMES) printf(" %s", name);
+        printf("\n");
+        return 1;
+      }
+      groups.push_back((e_group)found);
+    }
+  }
+  if (groups.empty())
+    for (int g = 0; g < GROUPS; g++) groups.push_back((e_group)g);
+  if (particles < 2) particles = 2;
+  if (jobs < 1) jobs = 1;
+
+  // Workers get the cost weights on their command line
+  std::vector<sim::worker> workers =
+      sim::workers_start(jobs, {std::to_string(weight_time), std::to_string(weight_overshoot), std::to_string(weight_error)});
+  if (workers.empty()) {
+    printf("couldn't start any workers\n");
+    return 1;
+  }
+  fprintf(stderr, "%d particles, %d iterations, %d workers, seed %u\n", particles, iterations, (int)workers.size(), seed);
+
+  std::mt19937 rng(seed);
+  tuning tuned;
+  for (e_group g : groups) tuned = group_tune(workers, g, tuned, particles, iterations, rng);
+
+  sim::workers_stop(workers);
+  default_constants_print(tuned);
+  return 0;
+}
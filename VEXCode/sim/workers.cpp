@@ -0,0 +1,106 @@
+#include "workers.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+extern char** environ;
+
+std::vector<sim::worker> sim::workers_start(int count, const std::vector<std::string>& args) {
+  std::vector<worker> output;
+  for (int i = 0; i < count; i++) {
+    int to[2], from[2];
+    if (pipe(to) != 0) break;
+    if (pipe(from) != 0) {
+      close(to[0]);
+      close(to[1]);
+      break;
+    }
+    // Host threads already exist by the time main runs, so spawn a fresh copy instead of forking
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, to[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, from[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, to[1]);
+    posix_spawn_file_actions_addclose(&actions, from[0]);
+    std::vector<std::string> strings = {"/proc/self/exe", "--worker"};
+    strings.insert(strings.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    for (auto& s : strings) argv.push_back(s.data());
+    argv.push_back(nullptr);
+    pid_t pid;
+    int failed = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(to[0]);
+    close(from[1]);
+    if (failed) {
+      close(to[1]);
+      close(from[0]);
+      break;
+    }
+    // Later workers shouldn't inherit this one's pipes, or it never sees its input close
+    fcntl(to[1], F_SETFD, FD_CLOEXEC);
+    fcntl(from[0], F_SETFD, FD_CLOEXEC);
+    output.push_back({pid, fdopen(to[1], "w"), fdopen(from[0], "r")});
+  }
+  return output;
+}
+
+std::vector<std::string> sim::jobs_run(std::vector<worker>& workers, const std::vector<std::string>& jobs,
+                                       std::function<void(size_t)> progress) {
+  std::vector<std::string> output(jobs.size());
+  size_t next = 0, done = 0;
+  while (done < jobs.size()) {
+    // Hand out work to idle workers
+    for (auto& w : workers) {
+      if (w.job != -1 || next >= jobs.size()) continue;
+      fprintf(w.in, "%s\n", jobs[next].c_str());
+      fflush(w.in);
+      w.job = next++;
+    }
+
+    std::vector<pollfd> fds;
+    for (auto& w : workers) fds.push_back({fileno(w.out), POLLIN, 0});
+    poll(fds.data(), fds.size(), -1);
+    for (size_t i = 0; i < workers.size(); i++) {
+      if (!(fds[i].revents & (POLLIN | POLLHUP)) || workers[i].job == -1) continue;
+      char line[4096];
+      if (!fgets(line, sizeof(line), workers[i].out)) {
+        fprintf(stderr, "worker %d stopped\n", (int)workers[i].pid);
+        exit(1);
+      }
+      std::string& answer = output[workers[i].job];
+      answer = line;
+      if (!answer.empty() && answer.back() == '\n') answer.pop_back();
+      workers[i].job = -1;
+      done++;
+      if (progress) progress(done);
+    }
+  }
+  return output;
+}
+
+void sim::workers_stop(std::vector<worker>& workers) {
+  // Workers exit when their input closes
+  for (auto& w : workers) {
+    fclose(w.in);
+    fclose(w.out);
+    waitpid(w.pid, nullptr, 0);
+  }
+  workers.clear();
+}
+
+int sim::worker_serve(std::function<std::string(const char* job)> answer) {
+  FILE* answers = fdopen(dup(STDOUT_FILENO), "w");
+  if (!answers || !freopen("/dev/null", "w", stdout)) return 1;
+  char line[4096];
+  while (fgets(line, sizeof(line), stdin)) {
+    fprintf(answers, "%s\n", answer(line).c_str());
+    fflush(answers);
+  }
+  return 0;
+}
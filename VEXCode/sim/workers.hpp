@@ -0,0 +1,57 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sim {
+/**
+ * A copy of this program running as a worker, answering one line for every line it's sent.
+ *
+ * The simulator is one world per process, so host tools run jobs in parallel with worker processes instead of threads.
+ */
+struct worker {
+  pid_t pid;
+  FILE* in;   // jobs to the worker
+  FILE* out;  // answers back
+  int job = -1;
+};
+
+/**
+ * Starts workers by running this program again as "program --worker args...".
+ *
+ * \param count
+ *        how many workers, fewer start if the system runs out
+ * \param args
+ *        passed after --worker, for settings the parent was given on its command line
+ */
+std::vector<worker> workers_start(int count, const std::vector<std::string>& args = {});
+
+/**
+ * Runs every job across the workers and returns the answers in the same order.  Exits if a worker stops.
+ *
+ * \param jobs
+ *        one line each, without the newline
+ * \param progress
+ *        called with the number done after each answer, can be empty
+ */
+std::vector<std::string> jobs_run(std::vector<worker>& workers, const std::vector<std::string>& jobs,
+                                  std::function<void(size_t)> progress = nullptr);
+
+/**
+ * Closes every worker's input and waits for it to exit.
+ */
+void workers_stop(std::vector<worker>& workers);
+
+/**
+ * The worker side.  Answers each line from the parent until it closes the pipe.  stdout goes to /dev/null while
+ * answering, so anything the job prints can't mix into the answers.
+ *
+ * \param answer
+ *        turns one job line into its answer, without the newline
+ */
+int worker_serve(std::function<std::string(const char* job)> answer);
+}  // namespace sim
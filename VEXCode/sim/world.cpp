@@ -0,0 +1,191 @@
+#include "world.hpp"
+
+#include <cmath>
+
+using namespace sim;
+
+static const double DT = 0.001;         // s
+static const double METERS = 0.0254;    // per inch
+static const double GRAVITY = 9.81;     // m/s^2
+static const double RESISTANCE = 3.0;   // ohms, at the cartridge output
+static const double BLUE_STALL = 0.35;  // Nm at the 600 rpm cartridge output, at the 2.5 A limit
+
+static double cartridge_rpm(pros::v5::MotorGears gearing) {
+  switch (gearing) {
+    case pros::v5::MotorGears::red:
+      return 100.0;
+    case pros::v5::MotorGears::green:
+      return 200.0;
+    default:
+      return 600.0;
+  }
+}
+
+static double counts_per_rev(pros::v5::MotorGears gearing) {
+  switch (gearing) {
+    case pros::v5::MotorGears::red:
+      return 1800.0;
+    case pros::v5::MotorGears::green:
+      return 900.0;
+    default:
+      return 300.0;
+  }
+}
+
+static int sgn(double in) { return (in > 0) - (in < 0); }
+
+// Applies a friction force to a drive force, sticking when friction is enough to hold still
+static double friction_apply(double force, double friction, double velocity, double mass, double dt) {
+  if (velocity == 0.0) {
+    if (fabs(force) <= friction) return 0.0;
+    return force - sgn(force) * friction;
+  }
+  double net = force - sgn(velocity) * friction;
+  // Friction can stop the robot but can't push it backwards
+  if (sgn(velocity + net / mass * dt) != sgn(velocity) && fabs(force) <= friction) return -velocity * mass / dt;
+  return net;
+}
+
+world& world::get() {
+  static world instance;
+  return instance;
+}
+
+void world::reset(const drivetrain_config& new_config) {
+  config = new_config;
+  motors.clear();
+  trackers.clear();
+  x = y = theta = 0.0;
+  velocity = angular_velocity = 0.0;
+  imu_rotation = 0.0;
+  left_wheel = right_wheel = 0.0;
+  for (auto port : config.left_ports)
+    motor_get(port).gearing = config.cartridge;
+  for (auto port : config.right_ports)
+    motor_get(port).gearing = config.cartridge;
+  for (auto& tracker : config.trackers)
+    trackers[tracker.port] = 0.0;
+  random.seed(config.seed);
+}
+
+motor_state& world::motor_get(int port) { return motors[std::abs(port)]; }
+
+int world::distance_get(int port) {
+  for (auto& sensor : config.distance_sensors) {
+    if (sensor.port != port) continue;
+    double heading = theta * M_PI / 180.0;
+    double sensor_x = x + sensor.x * cos(heading) + sensor.y * sin(heading);
+    double sensor_y = y - sensor.x * sin(heading) + sensor.y * cos(heading);
+    double beam = heading + sensor.angle * M_PI / 180.0;
+    double beam_x = sin(beam), beam_y = cos(beam);
+    double range_x = beam_x > 0.0 ? (config.field_right - sensor_x) / beam_x : beam_x < 0.0 ? (config.field_left - sensor_x) / beam_x : INFINITY;
+    double range_y = beam_y > 0.0 ? (config.field_top - sensor_y) / beam_y : beam_y < 0.0 ? (config.field_bottom - sensor_y) / beam_y : INFINITY;
+    double mm = fmin(range_x, range_y) * METERS * 1000.0;
+    if (!(mm >= 0.0) || mm > 2000.0) return 9999;
+    std::normal_distribution<double> noise(0.0, config.distance_noise * fmax(15.0, 0.05 * mm));
+    return std::clamp((int)std::lround(mm + noise(random)), 0, 2000);
+  }
+  return 9999;
+}
+
+void world::pose_set(double new_x, double new_y, double new_theta) {
+  x = new_x;
+  y = new_y;
+  theta = new_theta;
+}
+
+void world::step_to(uint64_t us) {
+  while (time + 1000 <= us) {
+    step(DT);
+    time += 1000;
+  }
+}
+
+void world::step(double dt) {
+  double radius = config.wheel_diameter / 2.0 * METERS;
+  double half_track = config.track_width / 2.0 * METERS;
+  double cartridge = cartridge_rpm(config.cartridge);
+  double gear = cartridge / config.wheel_rpm;  // cartridge turns per wheel turn
+  double free_speed = cartridge / 60.0 * 2.0 * M_PI;
+  double ke = 12.0 / free_speed;
+  double kt = BLUE_STALL * (600.0 / cartridge) / config.current_limit;
+
+  // Forward speed of each side in m/s
+  double v = velocity * METERS;
+  double w = angular_velocity * M_PI / 180.0;
+  double side_speed[2] = {v + w * half_track, v - w * half_track};
+  const std::vector<int>* side_ports[2] = {&config.left_ports, &config.right_ports};
+
+  double force[2] = {0.0, 0.0};
+  for (int side = 0; side < 2; side++) {
+    double motor_speed = side_speed[side] / radius * gear;
+    for (auto port : *side_ports[side]) {
+      motor_state& motor = motor_get(port);
+      int direction = port < 0 ? -1 : 1;
+      // Reversed motors are mounted backwards, so they drive forward with reversed voltage
+      double volts = direction * motor.voltage / 1000.0;
+      double current = std::clamp((volts - ke * motor_speed) / RESISTANCE, -config.current_limit, config.current_limit);
+      force[side] += kt * current * gear / radius;
+      motor.current = direction * current;
+    }
+  }
+
+  // Rolling resistance against driving, scrub at the wheels against turning
+  double mass = config.mass;
+  double length = config.length * METERS;
+  double width = config.track_width * METERS;
+  double inertia = mass * (width * width + length * length) / 12.0;
+  double rolling = config.rolling_resistance * mass * GRAVITY;
+  double scrub = config.turning_scrub * mass * GRAVITY * length / 4.0;
+
+  double linear = friction_apply(force[0] + force[1], rolling, v, mass, dt);
+  double torque = friction_apply((force[0] - force[1]) * half_track, scrub, w, inertia, dt);
+  v += linear / mass * dt;
+  w += torque / inertia * dt;
+
+  // Semi-implicit, move with the new velocities along the average heading
+  double old_theta = theta;
+  theta += w * 180.0 / M_PI * dt;
+  double heading = (old_theta + theta) / 2.0 * M_PI / 180.0;
+  x += v / METERS * sin(heading) * dt;
+  y += v / METERS * cos(heading) * dt;
+  velocity = v / METERS;
+  angular_velocity = w * 180.0 / M_PI;
+  imu_rotation += (angular_velocity + config.imu_drift) * dt;
+
+  // Drive motor encoders
+  double wheel_speed[2] = {(v + w * half_track) / radius, (v - w * half_track) / radius};
+  left_wheel += wheel_speed[0] * dt;
+  right_wheel += wheel_speed[1] * dt;
+  for (int side = 0; side < 2; side++) {
+    double wheel = side == 0 ? left_wheel : right_wheel;
+    for (auto port : *side_ports[side]) {
+      motor_state& motor = motor_get(port);
+      int direction = port < 0 ? -1 : 1;
+      motor.position = direction * wheel / (2.0 * M_PI) * gear * counts_per_rev(motor.gearing);
+      motor.velocity = direction * wheel_speed[side] * gear * 60.0 / (2.0 * M_PI);
+    }
+  }
+
+  // Anything else spins freely at the speed its voltage asks for
+  for (auto& [port, motor] : motors) {
+    bool drive = false;
+    for (int side = 0; side < 2; side++)
+      for (auto drive_port : *side_ports[side])
+        if (std::abs(drive_port) == port) drive = true;
+    if (drive) continue;
+    motor.velocity = motor.voltage / 12000.0 * cartridge_rpm(motor.gearing);
+    motor.position += motor.velocity / 60.0 * counts_per_rev(motor.gearing) * dt;
+    motor.current = 0.0;
+  }
+
+  // Tracking wheels
+  for (auto& tracker : config.trackers) {
+    double travel;
+    if (tracker.horizontal)
+      travel = w * tracker.offset * METERS;
+    else
+      travel = v - w * tracker.offset * METERS;
+    trackers[tracker.port] += travel / METERS * dt / (tracker.wheel_diameter * M_PI) * 360.0;
+  }
+}
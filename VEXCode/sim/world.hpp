@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "pros/abstract_motor.hpp"
+
+namespace sim {
+/**
+ * A tracking wheel on the simulated robot.
+ */
+struct tracker_config {
+  int port = 0;                // smart port of a rotation sensor, or the top ADI port of an encoder as passed to its constructor
+  bool adi = false;            // true for an ADI encoder
+  bool horizontal = false;     // true when the wheel rolls sideways
+  double wheel_diameter = 2.75;  // in
+  double offset = 0.0;         // in, to the right of center for vertical wheels, in front of center for horizontal wheels
+};
+
+/**
+ * A distance sensor on the simulated robot.
+ */
+struct distance_config {
+  int port = 0;
+  double x = 0.0;      // in, right of center
+  double y = 0.0;      // in, forward of center
+  double angle = 0.0;  // deg the beam points, clockwise from forward
+};
+
+/**
+ * The simulated robot.  Defaults match the chassis in main.cpp.
+ */
+struct drivetrain_config {
+  std::vector<int> left_ports = {4, 2, -3};
+  std::vector<int> right_ports = {-10, -9, 8};
+  int imu_port = 6;
+  double wheel_diameter = 3.25;  // in
+  double wheel_rpm = 360.0;
+  pros::v5::MotorGears cartridge = pros::v5::MotorGears::blue;
+  double mass = 6.8;            // kg
+  double track_width = 11.5;    // in
+  double length = 14.0;         // in, used for the moment of inertia and turning scrub
+  double current_limit = 2.5;   // A per motor
+  double rolling_resistance = 0.02;  // fraction of weight
+  double turning_scrub = 0.25;       // fraction of weight resisting turns at the wheel contacts
+  double imu_drift = 0.0;            // deg/s the IMU reads turning while the robot doesn't
+  int encoder_step = 1;              // raw motor counts per encoder step, more for a coarser encoder
+  std::vector<tracker_config> trackers;
+  std::vector<distance_config> distance_sensors;
+  double distance_noise = 1.0;  // times the V5 distance sensor's rated error, 15 mm under 200 mm and 5% past it
+  unsigned seed = 1;            // for sensor noise
+
+  // Field walls, distance sensors range off these
+  double field_left = -72.0;
+  double field_right = 72.0;
+  double field_bottom = -72.0;
+  double field_top = 72.0;
+};
+
+/**
+ * State of one motor, by port.
+ */
+struct motor_state {
+  int32_t voltage = 0;    // mV, after reversing
+  double position = 0.0;  // raw counts, not reversed or tared
+  double velocity = 0.0;  // rpm of the cartridge output
+  double current = 0.0;   // A
+  double zero = 0.0;      // raw counts at tare
+  pros::v5::MotorGears gearing = pros::v5::MotorGears::green;
+  pros::v5::MotorUnits units = pros::v5::MotorUnits::degrees;
+};
+
+/**
+ * Physics for a skid steer drive and state for every simulated device.
+ *
+ * Each drive motor is a DC motor with a current limit, geared to the wheels.  The robot is a rigid body on the field with
+ * rolling resistance and scrub against turning.  Everything is stepped at 1 ms.
+ */
+class world {
+ public:
+  /**
+   * Returns the world every simulated device reads from.
+   */
+  static world& get();
+
+  /**
+   * Starts over with a new robot at {0, 0, 0}.
+   *
+   * \param config
+   *        robot to simulate
+   */
+  void reset(const drivetrain_config& config);
+
+  /**
+   * Steps the physics up to a time.
+   *
+   * \param us
+   *        time in microseconds
+   */
+  void step_to(uint64_t us);
+
+  /**
+   * Moves the robot without changing any sensors, like picking it up and putting it down.
+   */
+  void pose_set(double x, double y, double theta);
+
+  drivetrain_config config;
+  std::map<int, motor_state> motors;
+
+  // Robot on the field.  Inches, degrees, theta 0 is +y and clockwise is positive
+  double x = 0.0;
+  double y = 0.0;
+  double theta = 0.0;
+  double velocity = 0.0;          // in/s forward
+  double angular_velocity = 0.0;  // deg/s clockwise
+
+  // Sensors
+  double imu_rotation = 0.0;         // deg
+  std::map<int, double> trackers;    // deg of wheel rotation by port
+
+  /**
+   * Returns the state of a motor, making it if it doesn't exist yet.
+   *
+   * \param port
+   *        smart port, reversing is ignored
+   */
+  motor_state& motor_get(int port);
+
+  /**
+   * Returns what a distance sensor reads right now, with noise.  Range to the nearest wall in mm, or 9999 past 2 m like
+   * the real sensor.
+   *
+   * \param port
+   *        smart port of a sensor in config.distance_sensors
+   */
+  int distance_get(int port);
+
+ private:
+  std::mt19937 random;
+  uint64_t time = 0;
+  double left_wheel = 0.0;   // rad of wheel rotation
+  double right_wheel = 0.0;
+  void step(double dt);
+};
+}  // namespace sim
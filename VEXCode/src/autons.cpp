@@ -1,5 +1,7 @@
 #include "main.h"
 
+#include <optional>
+
 
 /////
 // For installation, upgrading, documentations, and tutorials, check out our website!
@@ -7,12 +9,6 @@
 /////
 
 
-// These are out of 127
-const int DRIVE_SPEED = 50;
-const int TURN_SPEED = 40;
-const int SWING_SPEED = 110;
-
-
 // Intake speeds
 const int INTAKE_SPEED = 127;
 
@@ -90,7 +86,23 @@ inline void wall_extend()  { wall.set_value(true);  }
 inline void wall_retract() { wall.set_value(false); }
 
 
+// Where the distance sensors sit from the center of rotation, measure these on the robot.  Sensors that aren't plugged
+// in are skipped
+static const std::vector<control::wall_sensor> WALL_SENSORS = {
+    {&back_distance, {0.0, -7.0, 180.0}},
+    {&left_distance, {-6.0, 0.0, -90.0}},
+};
+static control::particle_filter wall_filter;
+
+// Relocalize during match loads.  Off until WALL_SENSORS are measured on the robot and this has run there
+const bool MATCH_LOAD_RELOCALIZE = false;
+
 void match_load_procedure(int times, double wiggle_amount) {
+  // Relocalize off the walls while the robot sits at the loader.  The walls are in field coordinates, so this only
+  // finds the pose when odometry started in field coordinates, otherwise it gives up and leaves odometry alone
+  std::optional<pros::Task> relocalizer;
+  if (MATCH_LOAD_RELOCALIZE) relocalizer.emplace([]() { control::relocalize(drive_pipeline, wall_filter, WALL_SENSORS); });
+
   // Extend wall to grab matchload (per field image)
   wall.set_value(true);
 
@@ -110,6 +122,9 @@ void match_load_procedure(int times, double wiggle_amount) {
 
   // Stop intake after matchload
   intake_motor_a.move(0);
+
+  // Don't drive off until relocalizing is done, it takes about as long as the wiggles
+  if (relocalizer) relocalizer->join();
 }
 
 float get_heading(float current_x, float current_y, float dest_x, float dest_y) {
@@ -126,8 +141,7 @@ float get_heading(float current_x, float current_y, float dest_x, float dest_y)
 
   if (delta_x > 0) {
     theta = 90 - alpha;
-  }
-  if (delta_x < 0) {
+  } else {
     theta = 270 - alpha;
   }
   
@@ -531,6 +545,29 @@ void measure_offsets() {
 }
 
 
+///
+// Calculate the offsets of your tracking wheels from a few seconds of spinning
+///
+void measure_offsets_fit() {
+  // Hold so the robot stops where the spin ends
+  chassis.drive_brake_set(MOTOR_BRAKE_HOLD);
+
+
+  // Spin both ways and fit every tracker at once, the print shows how much to trust each one
+  control::offset_calibration calibration;
+  control::offset_calibration_result result = control::offsets_measure(chassis_backend, calibration);
+  calibration.print();
+  if (!result.solved) return;
+
+
+  // Set new offsets to trackers that exist
+  if (chassis.odom_tracker_left != nullptr) chassis.odom_tracker_left->distance_to_center_set(result.left.offset);
+  if (chassis.odom_tracker_right != nullptr) chassis.odom_tracker_right->distance_to_center_set(result.right.offset);
+  if (chassis.odom_tracker_back != nullptr) chassis.odom_tracker_back->distance_to_center_set(result.back.offset);
+  if (chassis.odom_tracker_front != nullptr) chassis.odom_tracker_front->distance_to_center_set(result.front.offset);
+}
+
+
 // . . .
 // Make your own autonomous functions here!
 // . . .
@@ -977,3 +1014,36 @@ void autonomous_skills() {
   wall_retract(); // retract piston at end
   stop_intakes(); // make sure intakes are off
 }
+
+
+///
+// Auton selector pages, in order.  Skills gets the whole 60 s, everything else the 15 s autonomous period
+///
+const std::vector<auton_page> AUTON_PAGES = {
+    // ========== COMPETITION ROUTINES ==========
+    {"LEFT SIDE\n\nLeft side scoring", autonomous_left_side, 15000},
+    {"LEFT SIDE FULL\n\nLeft side full routine", autonomous_left_side_full, 15000},
+    {"RIGHT SIDE FULL\n\nRight side full routine", autonomous_right_side_full, 15000},
+    {"RIGHT SIDE\n\nRight side scoring", autonomous_right_side, 15000},
+    {"SAFE\n\nSingle piece fallback", autonomous_safe, 15000},
+    {"SKILLS\n\nSkills challenge", autonomous_skills, 60000},
+
+    // ========== TEST/DEBUG ROUTINES ==========
+    {"Drive\n\nDrive forward and come back", drive_example, 15000},
+    {"Turn\n\nTurn 3 times.", turn_example, 15000},
+    {"Drive and Turn\n\nDrive forward, turn, come back", drive_and_turn, 15000},
+    {"Drive and Turn\n\nSlow down during drive", wait_until_change_speed, 15000},
+    {"Swing Turn\n\nSwing in an 'S' curve", swing_example, 15000},
+    {"Motion Chaining\n\nDrive forward, turn, and come back, but blend everything together :D", motion_chaining, 15000},
+    {"Combine all 3 movements", combining_movements, 15000},
+    {"Interference\n\nAfter driving forward, robot performs differently if interfered or not", interfered_example, 15000},
+    {"Simple Odom\n\nThis is the same as the drive example, but it uses odom instead!", odom_drive_example, 15000},
+    {"Pure Pursuit\n\nGo to (0, 30) and pass through (6, 10) on the way.  Come back to (0, 0)", odom_pure_pursuit_example, 15000},
+    {"Pure Pursuit Wait Until\n\nGo to (24, 24) but start running an intake once the robot passes (12, 24)", odom_pure_pursuit_wait_until_example, 15000},
+    {"Boomerang\n\nGo to (0, 24, 45) then come back to (0, 0, 0)", odom_boomerang_example, 15000},
+    {"Boomerang Pure Pursuit\n\nGo to (0, 24, 45) on the way to (24, 24) then come back to (0, 0, 0)", odom_boomerang_injected_pure_pursuit_example, 15000},
+    {"Pipeline Boomerang\n\nBoomerang with odom and control in one task, prints latency", pipeline_boomerang_example, 15000},
+    {"Pipeline Queue\n\nQueue a drive, turn, path and boomerang, prints handoff gaps", pipeline_queue_example, 15000},
+    {"Measure Offsets\n\nThis will turn the robot a bunch of times and calculate your offsets for your tracking wheels.", measure_offsets, 15000},
+    {"Measure Offsets Fit\n\nSpins both ways for a few seconds and fits every tracking wheel offset at once, prints how good the fit is", measure_offsets_fit, 15000},
+};
@@ -0,0 +1,110 @@
+#include "control/devices_backend.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace control;
+
+// Raw encoder counts for one turn of the cartridge output
+static double counts_per_rev(pros::v5::MotorGears gearing) {
+  switch (gearing) {
+    case pros::v5::MotorGears::red:
+      return 1800.0;
+    case pros::v5::MotorGears::green:
+      return 900.0;
+    default:
+      return 300.0;
+  }
+}
+
+// Output rpm of each cartridge
+static double cartridge_rpm(pros::v5::MotorGears gearing) {
+  switch (gearing) {
+    case pros::v5::MotorGears::red:
+      return 100.0;
+    case pros::v5::MotorGears::green:
+      return 200.0;
+    default:
+      return 600.0;
+  }
+}
+
+devices_backend::devices_backend(std::vector<int> left_motor_ports, std::vector<int> right_motor_ports, int imu_port, double wheel_diameter, double wheel_rpm)
+    : imu(imu_port), wheel_diameter(wheel_diameter), wheel_rpm(wheel_rpm) {
+  for (auto port : left_motor_ports)
+    left_motors.push_back(pros::Motor(port));
+  for (auto port : right_motor_ports)
+    right_motors.push_back(pros::Motor(port));
+}
+
+void devices_backend::zero() {
+  pros::Motor& left = left_motors.front();
+  pros::Motor& right = right_motors.front();
+  pros::v5::MotorGears gearing = left.get_gearing();
+  double cartridge = cartridge_rpm(gearing);
+  tick_per_inch = counts_per_rev(gearing) * (cartridge / wheel_rpm) / (wheel_diameter * M_PI);
+
+  // Raw positions ignore tare and reversing, so everything starts from 0 here
+  left_sign = left.is_reversed() ? -1 : 1;
+  right_sign = right.is_reversed() ? -1 : 1;
+  left_offset = left_sign * left.get_raw_position(nullptr);
+  right_offset = right_sign * right.get_raw_position(nullptr);
+  drive_snapshot start;
+  start.imu = imu_get();
+  ez::pose current = odometry.pose_get();
+  odometry.reset({current.x, current.y, start.imu}, start);
+  zeroed = true;
+  reads_add(6);
+}
+
+void devices_backend::odom_integrator_set(odom_integrator integrator) { odometry.integrator_set(integrator); }
+odom_integrator devices_backend::odom_integrator_get() { return odometry.integrator_get(); }
+wheel_odometry* devices_backend::odometry_get() { return &odometry; }
+
+// Motors update every 10 ms regardless
+void devices_backend::data_rate_set(int ms) { imu.set_data_rate(std::max(ms, 5)); }
+
+void devices_backend::pose_set(ez::pose itarget) {
+  if (itarget.theta == ez::ANGLE_NOT_SET) itarget.theta = odometry.pose_get().theta;
+  imu_offset = itarget.theta - imu.get_rotation();
+  // The IMU reads the new heading from here, the drive sensors carry on
+  wheel_odometry_state state = odometry.state_get();
+  state.pose = {itarget.x, itarget.y, itarget.theta};
+  state.imu = itarget.theta;
+  state.heading_offset = 0.0;
+  state.last_turn = 0.0;
+  odometry.state_set(state);
+}
+
+drive_snapshot devices_backend::capture(bool batch) {
+  // Every value comes from its own device call either way, so batch changes nothing here
+  if (!zeroed) zero();
+  drive_snapshot output;
+  output.timestamp = pros::micros();
+
+  pros::Motor& left = left_motors.front();
+  pros::Motor& right = right_motors.front();
+  output.left = (left_sign * left.get_raw_position_all(&output.left_timestamp)[0] - left_offset) / tick_per_inch;
+  output.right = (right_sign * right.get_raw_position_all(&output.right_timestamp)[0] - right_offset) / tick_per_inch;
+  output.left_velocity = left.get_actual_velocity();
+  output.right_velocity = right.get_actual_velocity();
+  output.left_mA = left.get_current_draw();
+  output.right_mA = right.get_current_draw();
+  output.imu = imu.get_rotation() + imu_offset;
+  // The gyro is counterclockwise positive, headings are clockwise positive
+  output.imu_rate = -imu.get_gyro_rate().z;
+  reads_add(8);
+  return output;
+}
+
+ez::pose devices_backend::odom_update(const drive_snapshot& sensors) { return odometry.update(sensors); }
+ez::pose devices_backend::pose_get() { return odometry.pose_get(); }
+
+double devices_backend::imu_get() { return imu.get_rotation() + imu_offset; }
+
+void devices_backend::drive_set(double left, double right) {
+  for (auto& motor : left_motors)
+    motor.move(left);
+  for (auto& motor : right_motors)
+    motor.move(right);
+}
@@ -0,0 +1,38 @@
+#include "control/drive_backend.hpp"
+
+#include <stdio.h>
+
+using namespace control;
+
+void drive_backend::read_counter::end() {
+  last = now;
+  total += now;
+  now = 0;
+  ticks++;
+}
+
+double drive_backend::read_counter::mean_get() const { return ticks == 0 ? 0.0 : (double)total / ticks; }
+
+void drive_backend::reads_add(int amount) { counting->now += amount; }
+void drive_backend::tick_end() { tick_reads.end(); }
+
+void drive_backend::odom_tick_begin() { counting = &odom_reads; }
+
+void drive_backend::odom_tick_end() {
+  odom_reads.end();
+  counting = &tick_reads;
+}
+
+uint32_t drive_backend::reads_get() { return counting->last; }
+double drive_backend::reads_mean_get() { return tick_reads.mean_get(); }
+
+void drive_backend::reads_reset() {
+  tick_reads = read_counter();
+  odom_reads = read_counter();
+}
+
+void drive_backend::reads_print() {
+  printf(" device reads  %.2f per tick over %lu ticks\n", tick_reads.mean_get(), (unsigned long)tick_reads.ticks);
+  if (odom_reads.ticks > 0)
+    printf("               %.2f per odometry update over %lu updates\n", odom_reads.mean_get(), (unsigned long)odom_reads.ticks);
+}
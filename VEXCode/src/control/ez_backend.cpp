@@ -0,0 +1,203 @@
+#include "control/ez_backend.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "control/motion.hpp"
+
+using namespace control;
+
+ez_backend::ez_backend(ez::Drive& drive) : drive(drive) {}
+
+void ez_backend::enable() {
+  drive.drive_mode_set(ez::DISABLE);
+  drive.ez_auto.suspend();
+}
+
+void ez_backend::disable() {
+  drive.drive_set(0, 0);
+  drive.ez_auto.resume();
+}
+
+void ez_backend::odom_integrator_set(odom_integrator integrator) {
+  odometry.integrator_set(integrator);
+  integrating = true;
+  integrator_primed = false;
+}
+
+void ez_backend::constants_get(motion_constants& constants) {
+  constants.drive = drive.fwd_rev_drivePID;
+  constants.heading = drive.headingPID;
+  constants.turn = drive.turnPID;
+  constants.odom_xy = drive.xyPID;
+  constants.odom_angular = drive.odom_angularPID;
+  constants.boomerang = drive.boomerangPID;
+  constants.slew_drive = drive.slew_forward;
+  constants.slew_turn = drive.slew_turn;
+  constants.turn_bias = drive.odom_turn_bias_get();
+  constants.look_ahead = drive.odom_look_ahead_get();
+  constants.spacing = drive.odom_path_spacing_get();
+  constants.dlead = drive.odom_boomerang_dlead_get();
+  constants.boomerang_distance = drive.odom_boomerang_distance_get();
+  std::vector<double> smooth = drive.odom_path_smooth_constants_get();
+  if (smooth.size() == 3) {
+    constants.smooth_weight_smooth = smooth[0];
+    constants.smooth_weight_data = smooth[1];
+    constants.smooth_tolerance = smooth[2];
+  }
+}
+
+ez::e_angle_behavior ez_backend::turn_behavior_get() { return drive.pid_turn_behavior_get(); }
+
+void ez_backend::data_rate_set(int ms) {
+  drive.imu.set_data_rate(std::max(ms, 5));
+  // ez::tracking_wheel doesn't say which sensor a tracker reads, so every tracker's rotation sensor gets the rate.  ADI
+  // encoders don't take one.  An ADI tracker's rotation sensor is never read, but it's on port 1, so a rotation sensor
+  // plugged in there gets the rate too
+  for (ez::tracking_wheel* tracker : {drive.odom_tracker_left, drive.odom_tracker_right, drive.odom_tracker_front, drive.odom_tracker_back})
+    if (tracker) tracker->smart_encoder.set_data_rate(ms);
+}
+
+void ez_backend::zero() {
+  // Raw positions ignore tare and reversing, so line them up with what ez::Drive reads
+  pros::Motor& left = drive.left_motors.front();
+  pros::Motor& right = drive.right_motors.front();
+  left_sign = left.is_reversed() ? -1 : 1;
+  right_sign = right.is_reversed() ? -1 : 1;
+  left_offset = left_sign * left.get_raw_position(nullptr) - drive.drive_sensor_left_raw();
+  right_offset = right_sign * right.get_raw_position(nullptr) - drive.drive_sensor_right_raw();
+  zeroed = true;
+  integrator_primed = false;
+  reads_add(6);
+}
+
+void ez_backend::trackers_read(drive_snapshot& output) {
+  if (drive.odom_tracker_left) {
+    output.tracker_left = drive.odom_tracker_left->get();
+    reads_add(1);
+  }
+  if (drive.odom_tracker_right) {
+    output.tracker_right = drive.odom_tracker_right->get();
+    reads_add(1);
+  }
+  if (drive.odom_tracker_front) {
+    output.tracker_front = drive.odom_tracker_front->get();
+    reads_add(1);
+  }
+  if (drive.odom_tracker_back) {
+    output.tracker_back = drive.odom_tracker_back->get();
+    reads_add(1);
+  }
+}
+
+drive_snapshot ez_backend::capture(bool batch) {
+  if (!batch) return capture_direct();
+  if (!zeroed) zero();
+  drive_snapshot output;
+  output.timestamp = pros::micros();
+
+  pros::Motor& left = drive.left_motors.front();
+  pros::Motor& right = drive.right_motors.front();
+  double tick_per_inch = drive.drive_tick_per_inch();
+  output.left = (left_sign * left.get_raw_position_all(&output.left_timestamp)[0] - left_offset) / tick_per_inch;
+  output.right = (right_sign * right.get_raw_position_all(&output.right_timestamp)[0] - right_offset) / tick_per_inch;
+  output.left_velocity = left.get_actual_velocity();
+  output.right_velocity = right.get_actual_velocity();
+  output.left_mA = left.get_current_draw();
+  output.right_mA = right.get_current_draw();
+  output.imu = drive.imu.get_rotation() * drive.drive_imu_scaler_get();
+  // The gyro is counterclockwise positive, headings are clockwise positive
+  output.imu_rate = -drive.imu.get_gyro_rate().z;
+  reads_add(8);
+
+  trackers_read(output);
+  if (drive.odom_tracker_left) output.left = output.tracker_left;
+  if (drive.odom_tracker_right) output.right = output.tracker_right;
+  return output;
+}
+
+drive_snapshot ez_backend::capture_direct() {
+  // One read per ez::Drive getter, the way every consumer read sensors before snapshots
+  drive_snapshot output;
+  output.timestamp = pros::micros();
+  output.left = drive.drive_sensor_left();
+  output.right = drive.drive_sensor_right();
+  output.left_velocity = drive.drive_velocity_left();
+  output.right_velocity = drive.drive_velocity_right();
+  output.left_mA = drive.drive_mA_left();
+  output.right_mA = drive.drive_mA_right();
+  output.imu = drive.drive_imu_get();
+  output.imu_rate = -drive.imu.get_gyro_rate().z;
+  reads_add(8);
+  trackers_read(output);
+  return output;
+}
+
+// Inches a tracker sits from center, right or forward positive.  ez::Drive takes the distance and places it by which
+// side the tracker is set on, flipped with distance_to_center_flip_set()
+static double tracker_offset(ez::tracking_wheel* tracker, int side) {
+  double distance = fabs(tracker->distance_to_center_get());
+  return (tracker->distance_to_center_flip_get() ? -side : side) * distance;
+}
+
+static bool wheels_same(const odom_wheels& a, const odom_wheels& b) {
+  return a.left == b.left && a.right == b.right && a.front == b.front && a.back == b.back && a.front_used == b.front_used &&
+         a.back_used == b.back_used;
+}
+
+odom_wheels ez_backend::wheels_read() {
+  double half_width = drive.drive_width_get() / 2.0;
+  odom_wheels wheels;
+  wheels.left = drive.odom_tracker_left ? tracker_offset(drive.odom_tracker_left, -1) : -half_width;
+  wheels.right = drive.odom_tracker_right ? tracker_offset(drive.odom_tracker_right, 1) : half_width;
+  wheels.front_used = drive.odom_tracker_front != nullptr;
+  wheels.back_used = drive.odom_tracker_back != nullptr;
+  if (wheels.front_used) wheels.front = tracker_offset(drive.odom_tracker_front, 1);
+  if (wheels.back_used) wheels.back = tracker_offset(drive.odom_tracker_back, -1);
+  return wheels;
+}
+
+ez::pose ez_backend::odom_update(const drive_snapshot& sensors) {
+  if (!integrating) {
+    // EZ-Template's odometry reads both drive sensors, the IMU and the horizontal trackers on its own
+    drive.ez_tracking_task();
+    reads_add(3 + (drive.odom_tracker_front != nullptr) + (drive.odom_tracker_back != nullptr));
+    return drive.odom_pose_get();
+  }
+
+  // Wheels can be set on the drive any time, start over from the drive's pose when they are
+  odom_wheels wheels = wheels_read();
+  if (!integrator_primed || !wheels_same(wheels, odometry.wheels_get())) {
+    odometry.wheels_set(wheels);
+    odometry.reset(drive.odom_pose_get(), sensors);
+    integrator_primed = true;
+    return odometry.pose_get();
+  }
+
+  ez::pose output = odometry.update(sensors);
+  drive.odom_pose_set(output);
+  return output;
+}
+
+wheel_odometry* ez_backend::odometry_get() { return integrating ? &odometry : nullptr; }
+
+ez::pose ez_backend::pose_get() { return drive.odom_pose_get(); }
+
+void ez_backend::pose_set(ez::pose itarget) {
+  if (itarget.theta == ez::ANGLE_NOT_SET) itarget.theta = drive.odom_pose_get().theta;
+  drive.odom_pose_set(itarget);
+  if (!integrating || !integrator_primed) return;
+
+  // Keep the last readings so the next update still counts this tick's motion, only the pose moves.  Setting the
+  // drive's heading can set the IMU too, so the offset is taken from what it reads now
+  wheel_odometry_state state = odometry.state_get();
+  state.imu = drive.drive_imu_get();
+  reads_add(1);
+  state.pose = {itarget.x, itarget.y, itarget.theta};
+  state.heading_offset = itarget.theta - state.imu;
+  state.last_turn = 0.0;
+  odometry.state_set(state);
+}
+
+double ez_backend::imu_get() { return drive.drive_imu_get(); }
+void ez_backend::drive_set(double left, double right) { drive.drive_set(left, right); }
@@ -0,0 +1,157 @@
+#include "control/flight_recorder.hpp"
+
+#include <string.h>
+
+using namespace control;
+
+drive_snapshot control::flight_snapshot(const flight_record& record) {
+  drive_snapshot output;
+  output.timestamp = record.timestamp;
+  output.left = record.update.left;
+  output.right = record.update.right;
+  output.imu = record.update.imu;
+  output.imu_rate = record.update.imu_rate;
+  output.tracker_left = record.update.tracker_left;
+  output.tracker_right = record.update.tracker_right;
+  output.tracker_front = record.update.tracker_front;
+  output.tracker_back = record.update.tracker_back;
+  return output;
+}
+
+flight_recorder::flight_recorder()
+    : task([this]() { writer(); }, TASK_PRIORITY_DEFAULT - 2, TASK_STACK_DEPTH_DEFAULT, "flight recorder") {}
+
+flight_recorder::~flight_recorder() {
+  close();
+  // The writer runs on this recorder, so it ends before the buffers go
+  stopping = true;
+  task.notify();
+  task.join();
+}
+
+bool flight_recorder::open(const char* path) {
+  if (is_open) close();
+  file = fopen(path, "wb");
+  if (!file) return false;
+  started = false;
+  header_written = false;
+  following = false;
+  active = 0;
+  fill = 0;
+  full = -1;
+  written = 0;
+  dropped = 0;
+  is_open = true;
+  return true;
+}
+
+void flight_recorder::close() {
+  if (!is_open) return;
+  // Odometry runs above any task that would call this, so once this is false no add() is partway through
+  is_open = false;
+  closing = true;
+  task.notify();
+  while (closing) pros::delay(1);
+}
+
+bool flight_recorder::recording() { return is_open; }
+uint32_t flight_recorder::written_get() { return written; }
+uint32_t flight_recorder::dropped_get() { return dropped; }
+
+/////
+// Recording, from whichever task runs odometry
+/////
+void flight_recorder::push(const flight_record& record) {
+  if (fill == BUFFER) {
+    // The writer still has the other buffer, drop this rather than wait
+    if (full.load(std::memory_order_acquire) != -1) {
+      dropped++;
+      return;
+    }
+    full.store(active, std::memory_order_release);
+    active ^= 1;
+    fill = 0;
+    task.notify();
+  }
+  buffers[active][fill++] = record;
+}
+
+void flight_recorder::odometry_check(const wheel_odometry* odometry) {
+  if (!is_open || !following || !odometry) return;
+  wheel_odometry_state now = odometry->state_get();
+  if (memcmp(&now, &expected, sizeof(now)) == 0) return;
+
+  // Something moved odometry since its last update, replay has to be moved the same way
+  flight_record record;
+  record.timestamp = pros::micros();
+  record.type = FLIGHT_MOVED;
+  record.moved = now;
+  push(record);
+}
+
+void flight_recorder::add(const drive_snapshot& sensors, const ez::pose& pose, uint32_t reads, const wheel_odometry* odometry) {
+  if (!is_open) return;
+  if (!started) {
+    memcpy(header.magic, "FLIGHT\0\0", sizeof(header.magic));
+    header.version = VERSION;
+    header.record_size = sizeof(flight_record);
+    header.replayable = odometry != nullptr;
+    header.integrator = odometry ? odometry->integrator_get() : ODOM_MIDPOINT;
+    header.wheels = odometry ? odometry->wheels_get() : odom_wheels();
+    started = true;
+  }
+
+  flight_record record;
+  record.timestamp = sensors.timestamp;
+  record.type = FLIGHT_UPDATE;
+  record.update = {sensors.left, sensors.right, sensors.imu, sensors.tracker_left, sensors.tracker_right, sensors.tracker_front,
+                   sensors.tracker_back, (float)sensors.imu_rate, reads, pose.x, pose.y, pose.theta};
+  push(record);
+
+  if (odometry) {
+    // Replay starts from the state after the first update, then follows along
+    wheel_odometry_state now = odometry->state_get();
+    if (!following) {
+      flight_record start;
+      start.timestamp = sensors.timestamp;
+      start.type = FLIGHT_MOVED;
+      start.moved = now;
+      push(start);
+      following = true;
+    }
+    expected = now;
+  }
+}
+
+/////
+// Writing, from the recorder's own task
+/////
+void flight_recorder::write(const flight_record* records, int count) {
+  if (!header_written) {
+    fwrite(&header, sizeof(header), 1, file);
+    header_written = true;
+  }
+  fwrite(records, sizeof(flight_record), count, file);
+  // Flushed every buffer so pulling the battery loses one buffer at most
+  fflush(file);
+  written += count;
+}
+
+void flight_recorder::writer() {
+  while (true) {
+    pros::Task::notify_take(true, TIMEOUT_MAX);
+    if (stopping) return;
+    int buffer = full.load(std::memory_order_acquire);
+    if (buffer != -1) {
+      write(buffers[buffer].data(), BUFFER);
+      full.store(-1, std::memory_order_release);
+    }
+    if (closing) {
+      // Nothing is adding anymore, the active buffer is ours
+      if (started) write(buffers[active].data(), fill);
+      fclose(file);
+      file = nullptr;
+      closing = false;
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#include "control/gain_schedule.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace control;
+
+static ez::PID::Constants lerp(const ez::PID::Constants& a, const ez::PID::Constants& b, double t) {
+  return {a.kp + (b.kp - a.kp) * t, a.ki + (b.ki - a.ki) * t, a.kd + (b.kd - a.kd) * t, a.start_i + (b.start_i - a.start_i) * t};
+}
+
+void gain_schedule::set(std::vector<gain_point> ipoints) {
+  points = std::move(ipoints);
+  std::sort(points.begin(), points.end(), [](const gain_point& a, const gain_point& b) {
+    return a.target != b.target ? a.target < b.target : a.speed < b.speed;
+  });
+}
+
+bool gain_schedule::empty() const { return points.empty(); }
+
+// Interpolates along speed inside the row [first, last)
+ez::PID::Constants gain_schedule::row_get(size_t first, size_t last, double speed) const {
+  if (speed <= points[first].speed) return points[first].constants;
+  for (size_t i = first + 1; i < last; i++) {
+    if (speed <= points[i].speed) {
+      double t = (speed - points[i - 1].speed) / (points[i].speed - points[i - 1].speed);
+      return lerp(points[i - 1].constants, points[i].constants, t);
+    }
+  }
+  return points[last - 1].constants;
+}
+
+ez::PID::Constants gain_schedule::get(double target, double speed) const {
+  if (points.empty()) return {0.0, 0.0, 0.0, 0.0};
+  target = fabs(target);
+
+  // Find the rows on either side of target
+  size_t below = 0, below_end = 0, above = points.size(), above_end = points.size();
+  for (size_t i = 0; i < points.size();) {
+    size_t end = i;
+    while (end < points.size() && points[end].target == points[i].target) end++;
+    if (points[i].target <= target) {
+      below = i;
+      below_end = end;
+    } else {
+      above = i;
+      above_end = end;
+      break;
+    }
+    i = end;
+  }
+
+  if (below_end == 0) return row_get(above, above_end, speed);
+  if (above == points.size()) return row_get(below, below_end, speed);
+  double t = (target - points[below].target) / (points[above].target - points[below].target);
+  return lerp(row_get(below, below_end, speed), row_get(above, above_end, speed), t);
+}
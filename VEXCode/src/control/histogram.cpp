@@ -0,0 +1,62 @@
+#include "control/histogram.hpp"
+
+#include <stdio.h>
+
+#include <cmath>
+
+using namespace control;
+
+histogram::histogram(int bin_width) : bin_width(bin_width) { reset(); }
+
+void histogram::reset() {
+  bins.fill(0);
+  overflow = 0;
+  count = 0;
+  sum = 0;
+  min = UINT32_MAX;
+  max = 0;
+}
+
+void histogram::add(uint32_t us) {
+  uint32_t bin = us / bin_width;
+  // Kept out of the bins so a stall doesn't print as the last bin's range
+  if (bin >= BINS)
+    overflow++;
+  else
+    bins[bin]++;
+  count++;
+  sum += us;
+  if (us < min) min = us;
+  if (us > max) max = us;
+}
+
+uint32_t histogram::count_get() { return count; }
+double histogram::mean_get() { return count == 0 ? 0.0 : (double)sum / count; }
+uint32_t histogram::min_get() { return count == 0 ? 0 : min; }
+uint32_t histogram::max_get() { return max; }
+int histogram::bin_width_get() { return bin_width; }
+
+uint32_t histogram::percentile_get(double percent) {
+  if (count == 0) return 0;
+  uint32_t needed = std::ceil(count * percent);
+  uint32_t seen = 0;
+  for (int i = 0; i < BINS; i++) {
+    seen += bins[i];
+    // Report the top of the bin so percentiles are never optimistic
+    if (seen >= needed) return (i + 1) * bin_width;
+  }
+  // Past the last bin, the only top known is the largest sample
+  return max;
+}
+
+void histogram::print(const char* name) {
+  printf(" %s  n %lu  mean %.3f ms  min %.3f ms  max %.3f ms  p99 %.2f ms\n", name, (unsigned long)count,
+         mean_get() / 1000.0, min_get() / 1000.0, max_get() / 1000.0, percentile_get(0.99) / 1000.0);
+  for (int i = 0; i < BINS; i++) {
+    if (bins[i] == 0) continue;
+    printf("  %6.2f - %6.2f ms  %7lu  %5.1f%%\n", i * bin_width / 1000.0, (i + 1) * bin_width / 1000.0,
+           (unsigned long)bins[i], 100.0 * bins[i] / count);
+  }
+  if (overflow > 0)
+    printf("  %8s %6.2f ms  %7lu  %5.1f%%\n", ">", BINS * bin_width / 1000.0, (unsigned long)overflow, 100.0 * overflow / count);
+}
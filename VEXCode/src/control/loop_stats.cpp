@@ -0,0 +1,43 @@
+#include "control/loop_stats.hpp"
+
+#include <stdio.h>
+
+#include <cstdlib>
+
+using namespace control;
+
+loop_stats::loop_stats(int target_period) {
+  target_period_set(target_period);
+  reset();
+}
+
+void loop_stats::reset() {
+  period.reset();
+  exec.reset();
+  jitter_sum = 0;
+  overruns = 0;
+}
+
+void loop_stats::target_period_set(int ms) { target_period = ms; }
+int loop_stats::target_period_get() { return target_period; }
+
+void loop_stats::period_add(uint32_t us) {
+  period.add(us);
+  jitter_sum += std::abs((int64_t)us - (int64_t)target_period * 1000);
+}
+
+void loop_stats::exec_add(uint32_t us) { exec.add(us); }
+
+void loop_stats::overrun_add() { overruns++; }
+
+double loop_stats::jitter_mean_get() { return period.count_get() == 0 ? 0.0 : (double)jitter_sum / period.count_get(); }
+uint32_t loop_stats::overruns_get() { return overruns; }
+
+void loop_stats::print(const char* name) {
+  uint32_t count = period.count_get();
+  printf("\n%s loop, target %i ms, %lu iterations\n", name, target_period, (unsigned long)count);
+  if (count == 0) return;
+  printf(" jitter %.3f ms  overruns %lu (%.2f%%)\n", jitter_mean_get() / 1000.0, (unsigned long)overruns, 100.0 * overruns / count);
+  period.print("period");
+  exec.print("exec");
+}
@@ -0,0 +1,412 @@
+#include "control/motions.hpp"
+
+#include <cmath>
+
+using namespace control;
+
+// Odom motions stop correcting their heading this close to the target so the robot doesn't spin on top of it
+static const double ANGLE_LOCK_DISTANCE = 3.0;
+
+// Prepared paths are rebuilt if the robot starts further than this from where the path was prepared
+static const double PREPARED_TOLERANCE = 2.0;
+
+// Fastest drive motor, for telling when the robot has stopped
+static double motor_rpm_get(const drive_state& state) { return fmax(fabs(state.left_velocity), fabs(state.right_velocity)); }
+
+/////
+// Drive
+/////
+drive_motion::drive_motion(const motion_constants& constants, double target, int speed, bool slew_on, double heading)
+    : drivePID(constants.drive, constants.derivative, constants.period), headingPID(constants.heading, constants.derivative, constants.period), slew(constants.slew_drive, constants.slew_drive_limits, constants.period), target(target), speed(speed), slew_on(slew_on), heading(heading), settle(constants.drive, constants.settle) {
+  if (!constants.drive_schedule.empty()) {
+    ez::PID::Constants c = constants.drive_schedule.get(target, speed);
+    drivePID.constants_set(c.kp, c.ki, c.kd, c.start_i);
+  }
+}
+
+ez::pose drive_motion::end_get(const ez::pose& start) {
+  double angle = ez::util::to_rad(heading);
+  return {start.x + target * sin(angle), start.y + target * cos(angle), heading};
+}
+
+void drive_motion::initialize(const drive_state& state) {
+  double current = (state.left + state.right) / 2.0;
+  drivePID.start(current + target, current);
+  headingPID.start(heading, state.imu);
+  slew.initialize(slew_on, speed, current + target, current);
+  settle.start();
+}
+
+drive_output drive_motion::iterate(const drive_state& state) {
+  double current = (state.left + state.right) / 2.0;
+  double out = slew.iterate(drivePID.compute(current), current, state.timestamp);
+  double h = headingPID.compute(state.imu);
+  if (exit == ez::RUNNING) exit = drivePID.exit_condition();
+  if (exit == ez::RUNNING && settle.iterate(drivePID.error, motor_rpm_get(state), state.timestamp)) exit = ez::SMALL_EXIT;
+  return {out + h, out - h};
+}
+
+ez::exit_output drive_motion::exit_condition() { return exit; }
+int drive_motion::saved_get() { return settle.saved_get(); }
+const char* drive_motion::name_get() { return "drive"; }
+
+/////
+// Profiled drive
+/////
+profiled_drive_motion::profiled_drive_motion(const motion_constants& constants, double target, int speed, double heading)
+    : drivePID(constants.drive, constants.derivative, constants.period), trackingPID(constants.drive_tracking, constants.derivative, constants.period), headingPID(constants.heading, constants.derivative, constants.period), ff(constants.drive_feedforward), target(target), heading(heading), settle(constants.drive, constants.settle) {
+  profile_constraints limits = constants.drive_limits;
+  limits.max_velocity *= ez::util::clamp(speed, 127, 0) / 127.0;
+  profile.generate(target, limits);
+}
+
+ez::pose profiled_drive_motion::end_get(const ez::pose& start) {
+  double angle = ez::util::to_rad(heading);
+  return {start.x + target * sin(angle), start.y + target * cos(angle), heading};
+}
+
+void profiled_drive_motion::initialize(const drive_state& state) {
+  start = (state.left + state.right) / 2.0;
+  start_time = state.timestamp;
+  drivePID.start(start + target, start);
+  trackingPID.start(0.0, 0.0);
+  headingPID.start(heading, state.imu);
+  settle.start();
+}
+
+drive_output profiled_drive_motion::iterate(const drive_state& state) {
+  double current = (state.left + state.right) / 2.0;
+  double t = (state.timestamp - start_time) / 1000000.0;
+  profile_point point = profile.sample(t);
+
+  // Passing the error as the measurement puts D on the error, so it damps the robot against the profile instead of against moving
+  double error = start + point.position - current;
+  double correction = trackingPID.compute_error(error, -error);
+  double out = ez::util::clamp(ff.output(point.velocity, point.acceleration) + correction, 127);
+  double h = headingPID.compute(state.imu);
+
+  // Exit timers only start once the profile is done
+  drivePID.compute(current);
+  if (exit == ez::RUNNING && t >= profile.duration_get()) {
+    exit = drivePID.exit_condition();
+    if (exit == ez::RUNNING && settle.iterate(drivePID.error, motor_rpm_get(state), state.timestamp)) exit = ez::SMALL_EXIT;
+  }
+  return {out + h, out - h};
+}
+
+ez::exit_output profiled_drive_motion::exit_condition() { return exit; }
+int profiled_drive_motion::saved_get() { return settle.saved_get(); }
+const char* profiled_drive_motion::name_get() { return "profiled drive"; }
+
+/////
+// Turn
+/////
+double control::turn_target_get(double target, double current, ez::e_angle_behavior behavior) {
+  switch (behavior) {
+    case ez::shortest:
+      return ez::util::turn_shortest(target, current);
+    case ez::longest:
+      return ez::util::turn_longest(target, current);
+    case ez::left_turn:
+      // Left turns make the heading smaller
+      while (target > current) target -= 360.0;
+      while (target < current - 360.0) target += 360.0;
+      return target;
+    case ez::right_turn:
+      while (target < current) target += 360.0;
+      while (target > current + 360.0) target -= 360.0;
+      return target;
+    default:
+      return target;
+  }
+}
+
+turn_motion::turn_motion(const motion_constants& constants, double target, int speed, ez::e_angle_behavior behavior, bool slew_on)
+    : turnPID(constants.turn, constants.derivative, constants.period), slew(constants.slew_turn, constants.slew_turn_limits, constants.period), target(target), speed(speed), behavior(behavior), slew_on(slew_on), schedule(constants.turn_schedule), settle(constants.turn, constants.settle) {}
+
+ez::pose turn_motion::end_get(const ez::pose& start) { return {start.x, start.y, target}; }
+
+void turn_motion::initialize(const drive_state& state) {
+  double new_target = turn_target_get(target, state.imu, behavior);
+  // How far the turn is isn't known until it starts
+  if (!schedule.empty()) {
+    ez::PID::Constants c = schedule.get(new_target - state.imu, speed);
+    turnPID.constants_set(c.kp, c.ki, c.kd, c.start_i);
+  }
+  turnPID.start(new_target, state.imu);
+  slew.initialize(slew_on, speed, new_target, state.imu);
+  settle.start();
+}
+
+drive_output turn_motion::iterate(const drive_state& state) {
+  double out = slew.iterate(turnPID.compute(state.imu), state.imu, state.timestamp);
+  if (exit == ez::RUNNING) exit = turnPID.exit_condition();
+  // The error shrinks as fast as the gyro turns
+  if (exit == ez::RUNNING && settle.iterate(turnPID.error, -state.imu_rate, motor_rpm_get(state), state.timestamp)) exit = ez::SMALL_EXIT;
+  return {out, -out};
+}
+
+ez::exit_output turn_motion::exit_condition() { return exit; }
+int turn_motion::saved_get() { return settle.saved_get(); }
+const char* turn_motion::name_get() { return "turn"; }
+
+/////
+// Profiled turn
+/////
+profiled_turn_motion::profiled_turn_motion(const motion_constants& constants, double target, int speed, ez::e_angle_behavior behavior)
+    : turnPID(constants.turn, constants.derivative, constants.period), trackingPID(constants.turn_tracking, constants.derivative, constants.period), ff(constants.turn_feedforward), limits(constants.turn_limits), rate_kp(constants.turn_rate_kp), target(target), behavior(behavior), settle(constants.turn, constants.settle) {
+  limits.max_velocity *= ez::util::clamp(speed, 127, 0) / 127.0;
+}
+
+ez::pose profiled_turn_motion::end_get(const ez::pose& start) { return {start.x, start.y, target}; }
+
+void profiled_turn_motion::initialize(const drive_state& state) {
+  // How far to turn depends on the heading when the turn starts
+  double new_target = turn_target_get(target, state.imu, behavior);
+  start = state.imu;
+  start_time = state.timestamp;
+  profile.generate(new_target - start, limits);
+  turnPID.start(new_target, state.imu);
+  trackingPID.start(0.0, 0.0);
+  settle.start();
+}
+
+drive_output profiled_turn_motion::iterate(const drive_state& state) {
+  double t = (state.timestamp - start_time) / 1000000.0;
+  profile_point point = profile.sample(t);
+
+  double error = start + point.position - state.imu;
+  double correction = trackingPID.compute_error(error, -error) + rate_kp * (point.velocity - state.imu_rate);
+  double out = ez::util::clamp(ff.output(point.velocity, point.acceleration) + correction, 127);
+
+  // Exit timers only start once the profile is done
+  turnPID.compute(state.imu);
+  if (exit == ez::RUNNING && t >= profile.duration_get()) {
+    exit = turnPID.exit_condition();
+    if (exit == ez::RUNNING && settle.iterate(turnPID.error, -state.imu_rate, motor_rpm_get(state), state.timestamp)) exit = ez::SMALL_EXIT;
+  }
+  return {out, -out};
+}
+
+ez::exit_output profiled_turn_motion::exit_condition() { return exit; }
+int profiled_turn_motion::saved_get() { return settle.saved_get(); }
+const char* profiled_turn_motion::name_get() { return "profiled turn"; }
+
+/////
+// Odom
+/////
+odom_motion::odom_motion(const motion_constants& constants, const ez::PID& angular, bool slew_on)
+    : xyPID(constants.odom_xy, constants.derivative, constants.period), angularPID(angular, constants.derivative, constants.period), slew(constants.slew_drive, constants.slew_drive_limits, constants.period), turn_bias(constants.turn_bias), slew_on(slew_on), settle(constants.odom_xy, constants.settle) {}
+
+void odom_motion::slew_initialize(int speed, double distance) {
+  slew.initialize(slew_on, speed, distance, 0.0);
+}
+
+drive_output odom_motion::ptp_output(const drive_state& state, ez::pose target, ez::drive_directions dir, int speed, bool final, double heading) {
+  ez::pose current = state.pose;
+  double distance = ez::util::distance_to_point(target, current);
+  double face = ez::util::absolute_angle_to_point(target, current) + (dir == ez::rev ? 180.0 : 0.0);
+  double angle_error = ez::util::wrap_angle(face - current.theta);
+
+  // Signed distance along the heading, so driving past the point makes the error negative
+  double xy_error = distance * cos(ez::util::to_rad(angle_error));
+
+  // Close to the final point, hold a heading instead of chasing the point
+  if (final && distance < ANGLE_LOCK_DISTANCE) {
+    if (locked_heading == ez::ANGLE_NOT_SET) locked_heading = heading == ez::ANGLE_NOT_SET ? current.theta : heading;
+    angle_error = ez::util::wrap_angle(locked_heading - current.theta);
+  }
+
+  if (!started) {
+    xyPID.start(0.0, -xy_error);
+    angularPID.start(0.0, current.theta);
+    settle.start();
+    started = true;
+  }
+
+  double xy_out = slew.iterate(xyPID.compute_error(xy_error, -xy_error), ez::util::distance_to_point(current, start), state.timestamp);
+  double angular_out = ez::util::clamp(angularPID.compute_error(angle_error, current.theta), speed);
+  if (dir == ez::rev) xy_out = -xy_out;
+
+  // When both can't fit under max speed, turning gets turn_bias of the room
+  double over = fabs(xy_out) + fabs(angular_out) - speed;
+  if (over > 0) {
+    xy_out -= ez::util::sgn(xy_out) * over * turn_bias;
+    angular_out -= ez::util::sgn(angular_out) * over * (1.0 - turn_bias);
+  }
+
+  if (final && exit == ez::RUNNING) {
+    exit = xyPID.exit_condition();
+    if (exit == ez::RUNNING && settle.iterate(xy_error, motor_rpm_get(state), state.timestamp)) exit = ez::SMALL_EXIT;
+  }
+  return {xy_out + angular_out, xy_out - angular_out};
+}
+
+ez::exit_output odom_motion::exit_condition() { return exit; }
+int odom_motion::saved_get() { return settle.saved_get(); }
+
+/////
+// Point to point
+/////
+point_motion::point_motion(const motion_constants& constants, ez::odom imovement, bool slew_on)
+    : odom_motion(constants, constants.odom_angular, slew_on), movement(imovement) {}
+
+ez::pose point_motion::end_get(const ez::pose& start) {
+  ez::pose output = movement.target;
+  output.theta = ez::util::absolute_angle_to_point(movement.target, start) + (movement.drive_direction == ez::rev ? 180.0 : 0.0);
+  return output;
+}
+
+void point_motion::initialize(const drive_state& state) {
+  start = state.pose;
+  slew_initialize(movement.max_xy_speed, ez::util::distance_to_point(movement.target, start));
+}
+
+drive_output point_motion::iterate(const drive_state& state) {
+  return ptp_output(state, movement.target, movement.drive_direction, movement.max_xy_speed, true);
+}
+
+const char* point_motion::name_get() { return "point to point"; }
+
+/////
+// Boomerang
+/////
+boomerang_motion::boomerang_motion(const motion_constants& constants, ez::odom imovement, bool slew_on)
+    : odom_motion(constants, constants.boomerang, slew_on), movement(imovement), dlead(constants.dlead), max_carrot(constants.boomerang_distance) {}
+
+ez::pose boomerang_motion::end_get(const ez::pose& start) { return movement.target; }
+
+void boomerang_motion::initialize(const drive_state& state) {
+  start = state.pose;
+  slew_initialize(movement.max_xy_speed, ez::util::distance_to_point(movement.target, start));
+}
+
+drive_output boomerang_motion::iterate(const drive_state& state) {
+  ez::pose target = movement.target;
+  double distance = ez::util::distance_to_point(target, state.pose);
+
+  // The carrot sits behind the target along the final heading and slides into it as the robot gets closer
+  double lead = fmin(dlead * distance, max_carrot);
+  ez::pose facing = target;
+  if (movement.drive_direction == ez::rev) facing.theta += 180.0;
+  ez::pose carrot = ez::util::vector_off_point(-lead, facing);
+
+  if (distance < ANGLE_LOCK_DISTANCE) carrot = target;
+  return ptp_output(state, carrot, movement.drive_direction, movement.max_xy_speed, distance < ANGLE_LOCK_DISTANCE, target.theta);
+}
+
+const char* boomerang_motion::name_get() { return "boomerang"; }
+
+/////
+// Pure pursuit
+/////
+std::vector<ez::odom> control::path_inject(const std::vector<ez::odom>& imovements, double spacing, std::vector<int>* injected_index) {
+  std::vector<ez::odom> output;
+  if (injected_index) injected_index->clear();
+  if (imovements.empty()) return output;
+
+  output.push_back(imovements[0]);
+  if (injected_index) injected_index->push_back(0);
+  for (size_t i = 1; i < imovements.size(); i++) {
+    ez::pose from = imovements[i - 1].target;
+    ez::pose to = imovements[i].target;
+    double length = ez::util::distance_to_point(to, from);
+    int count = std::max(1, (int)ceil(length / spacing));
+    for (int j = 1; j <= count; j++) {
+      ez::odom point = imovements[i];
+      point.target.x = from.x + (to.x - from.x) * j / count;
+      point.target.y = from.y + (to.y - from.y) * j / count;
+      if (j != count) point.target.theta = ez::ANGLE_NOT_SET;
+      output.push_back(point);
+    }
+    if (injected_index) injected_index->push_back(output.size() - 1);
+  }
+  return output;
+}
+
+std::vector<ez::odom> control::path_smooth(const std::vector<ez::odom>& ipath, double weight_smooth, double weight_data, double tolerance) {
+  std::vector<ez::odom> output = ipath;
+  if (ipath.size() < 3) return output;
+
+  double change = tolerance;
+  int passes = 0;
+  // Passes are capped so a bad tolerance can't stall a motion
+  while (change >= tolerance && passes++ < 1000) {
+    change = 0.0;
+    for (size_t i = 1; i < ipath.size() - 1; i++) {
+      double x = output[i].target.x;
+      double y = output[i].target.y;
+      output[i].target.x += weight_data * (ipath[i].target.x - x) + weight_smooth * (output[i - 1].target.x + output[i + 1].target.x - 2.0 * x);
+      output[i].target.y += weight_data * (ipath[i].target.y - y) + weight_smooth * (output[i - 1].target.y + output[i + 1].target.y - 2.0 * y);
+      change += fabs(x - output[i].target.x) + fabs(y - output[i].target.y);
+    }
+  }
+  return output;
+}
+
+pursuit_motion::pursuit_motion(const motion_constants& constants, std::vector<ez::odom> imovements, bool slew_on)
+    : odom_motion(constants, constants.odom_angular, slew_on), movements(imovements), path_constants(constants) {}
+
+void pursuit_motion::prepare(const ez::pose& start) {
+  // The path starts where the robot is
+  std::vector<ez::odom> input = movements;
+  ez::odom first = {start, movements.empty() ? ez::fwd : movements[0].drive_direction, 0};
+  input.insert(input.begin(), first);
+  std::vector<ez::odom> injected = path_inject(input, path_constants.spacing, &injected_index);
+  path = path_smooth(injected, path_constants.smooth_weight_smooth, path_constants.smooth_weight_data, path_constants.smooth_tolerance);
+
+  // Injected indexes include the start point, index_get() shouldn't
+  injected_index.erase(injected_index.begin());
+
+  prepared_start = start;
+  prepared = true;
+}
+
+ez::pose pursuit_motion::end_get(const ez::pose& start) {
+  if (movements.empty()) return start;
+  ez::pose output = movements.back().target;
+  if (output.theta == ez::ANGLE_NOT_SET) {
+    ez::pose from = movements.size() > 1 ? movements[movements.size() - 2].target : start;
+    output.theta = ez::util::absolute_angle_to_point(output, from) + (movements.back().drive_direction == ez::rev ? 180.0 : 0.0);
+  }
+  return output;
+}
+
+void pursuit_motion::initialize(const drive_state& state) {
+  start = state.pose;
+
+  // A path prepared from somewhere else would make the robot cut back to where it thought it would be
+  if (!prepared || ez::util::distance_to_point(prepared_start, start) > PREPARED_TOLERANCE)
+    prepare(start);
+
+  look_index = 0;
+  closest_index = 0;
+  passed_index = -1;
+  double length = 0.0;
+  for (size_t i = 1; i < path.size(); i++)
+    length += ez::util::distance_to_point(path[i].target, path[i - 1].target);
+  slew_initialize(movements.empty() ? 0 : movements[0].max_xy_speed, length);
+}
+
+drive_output pursuit_motion::iterate(const drive_state& state) {
+  if (path.empty()) return {0.0, 0.0};
+  int last = path.size() - 1;
+
+  // The closest point only moves forward, so the robot can't jump back along a path that crosses itself
+  while (closest_index < last &&
+         ez::util::distance_to_point(path[closest_index + 1].target, state.pose) <= ez::util::distance_to_point(path[closest_index].target, state.pose))
+    closest_index++;
+  while (passed_index + 1 < (int)injected_index.size() && closest_index >= injected_index[passed_index + 1])
+    passed_index++;
+
+  // Look at the farthest point within look ahead
+  if (look_index < closest_index) look_index = closest_index;
+  while (look_index < last && ez::util::distance_to_point(path[look_index + 1].target, state.pose) <= path_constants.look_ahead)
+    look_index++;
+
+  ez::odom target = path[look_index];
+  return ptp_output(state, target.target, target.drive_direction, target.max_xy_speed, look_index == last, target.target.theta);
+}
+
+int pursuit_motion::index_get() { return passed_index; }
+const char* pursuit_motion::name_get() { return "pure pursuit"; }
@@ -0,0 +1,54 @@
+#include "control/odometry.hpp"
+
+using namespace control;
+
+wheel_odometry::wheel_odometry(const odom_wheels& wheels, odom_integrator integrator) : wheels(wheels), integrator(integrator) {}
+
+void wheel_odometry::wheels_set(const odom_wheels& new_wheels) { wheels = new_wheels; }
+odom_wheels wheel_odometry::wheels_get() const { return wheels; }
+void wheel_odometry::integrator_set(odom_integrator new_integrator) { integrator = new_integrator; }
+odom_integrator wheel_odometry::integrator_get() const { return integrator; }
+
+void wheel_odometry::reset(const ez::pose& pose, const drive_snapshot& sensors) {
+  state.pose = {pose.x, pose.y, pose.theta};
+  state.heading_offset = pose.theta - sensors.imu;
+  state.last_turn = 0.0;
+  state.left = sensors.left;
+  state.right = sensors.right;
+  state.imu = sensors.imu;
+  state.front = sensors.tracker_front;
+  state.back = sensors.tracker_back;
+}
+
+ez::pose wheel_odometry::update(const drive_snapshot& sensors) {
+  // Every wheel says how far the center moved, average what each one says
+  double turn = sensors.imu - state.imu;
+  double forward = (odom_forward(sensors.left - state.left, wheels.left, turn) + odom_forward(sensors.right - state.right, wheels.right, turn)) / 2.0;
+  double right = 0.0;
+  int horizontal = 0;
+  if (wheels.front_used) {
+    right += odom_sideways(sensors.tracker_front - state.front, wheels.front, turn);
+    horizontal++;
+  }
+  if (wheels.back_used) {
+    right += odom_sideways(sensors.tracker_back - state.back, wheels.back, turn);
+    horizontal++;
+  }
+  if (horizontal > 0) right /= horizontal;
+
+  state.pose.theta = state.imu + state.heading_offset;
+  odom_integrate(state.pose, right, forward, turn, integrator, state.last_turn);
+  state.pose.theta = sensors.imu + state.heading_offset;
+
+  state.last_turn = turn;
+  state.left = sensors.left;
+  state.right = sensors.right;
+  state.imu = sensors.imu;
+  state.front = sensors.tracker_front;
+  state.back = sensors.tracker_back;
+  return pose_get();
+}
+
+ez::pose wheel_odometry::pose_get() const { return {state.pose.x, state.pose.y, state.pose.theta}; }
+wheel_odometry_state wheel_odometry::state_get() const { return state; }
+void wheel_odometry::state_set(const wheel_odometry_state& new_state) { state = new_state; }
@@ -0,0 +1,161 @@
+#include "control/offset_calibration.hpp"
+
+#include <stdio.h>
+
+#include <cmath>
+
+#include "EZ-Template/util.hpp"
+
+using namespace control;
+
+void offset_calibration::clear() { *this = offset_calibration(); }
+
+int offset_calibration::samples_get() const { return n; }
+
+/////
+// Samples
+/////
+void offset_calibration::add(const drive_snapshot& sensors) {
+  if (n == 0) {
+    first = sensors;
+    last_imu = sensors.imu;
+  }
+  n++;
+  turned += fabs(sensors.imu - last_imu);
+  last_imu = sensors.imu;
+
+  double heading = ez::util::to_rad(sensors.imu - first.imu);
+  double rate = ez::util::to_rad(sensors.imu_rate);
+  t += heading;
+  r += rate;
+  tt += heading * heading;
+  tr += heading * rate;
+  rr += rate * rate;
+
+  const double now[4] = {sensors.tracker_left, sensors.tracker_right, sensors.tracker_front, sensors.tracker_back};
+  const double start[4] = {first.tracker_left, first.tracker_right, first.tracker_front, first.tracker_back};
+  for (int i = 0; i < 4; i++) {
+    sums& s = trackers[i];
+    // A tracker that doesn't exist reads 0 the whole time
+    if (now[i] != 0.0) s.used = true;
+    double d = now[i] - start[i];
+    s.d += d;
+    s.dd += d * d;
+    s.td += heading * d;
+    s.rd += rate * d;
+  }
+}
+
+/////
+// Fitting
+/////
+offset_fit offset_calibration::fit(const sums& s) const {
+  offset_fit output;
+  output.used = s.used;
+  if (!s.used) return output;
+
+  // Centered sums, so the constant each tracker started at drops out
+  double stt = tt - t * t / n;
+  double srr = rr - r * r / n;
+  double str = tr - t * r / n;
+  double sdt = s.td - t * s.d / n;
+  double srd = s.rd - r * s.d / n;
+  double sdd = s.dd - s.d * s.d / n;
+
+  // Heading and rate together, unless the rate barely changed and can't be told apart from a constant
+  double det = stt * srr - str * str;
+  double rss, variance_scale;
+  int terms;
+  if (srr > 0.0 && det > 1e-6 * stt * srr) {
+    double rate_term = (stt * srd - str * sdt) / det;
+    output.offset = (srr * sdt - str * srd) / det;
+    rss = sdd - output.offset * sdt - rate_term * srd;
+    variance_scale = srr / det;
+    terms = 3;
+  } else {
+    output.offset = sdt / stt;
+    rss = sdd - output.offset * sdt;
+    variance_scale = 1.0 / stt;
+    terms = 2;
+  }
+  rss = fmax(rss, 0.0);
+  output.residual = sqrt(rss / n);
+  output.std_error = n > terms ? sqrt(rss / (n - terms) * variance_scale) : 0.0;
+  return output;
+}
+
+offset_calibration_result offset_calibration::solve() const {
+  offset_calibration_result output;
+  output.samples = n;
+  output.turned = turned;
+  if (n < 10 || turned < TURN_MIN) return output;
+  output.solved = true;
+
+  offset_fit* fits[4] = {&output.left, &output.right, &output.front, &output.back};
+  for (int i = 0; i < 4; i++) *fits[i] = fit(trackers[i]);
+
+  // Each tracker's rate term is its offset times the IMU's lag, fit one lag across all of them
+  double stt = tt - t * t / n;
+  double srr = rr - r * r / n;
+  double str = tr - t * r / n;
+  double det = stt * srr - str * str;
+  if (srr > 0.0 && det > 1e-6 * stt * srr) {
+    double lag = 0.0, weight = 0.0;
+    for (int i = 0; i < 4; i++) {
+      const sums& s = trackers[i];
+      if (!s.used) continue;
+      double sdt = s.td - t * s.d / n;
+      double srd = s.rd - r * s.d / n;
+      double rate_term = (stt * srd - str * sdt) / det;
+      lag += rate_term * fits[i]->offset;
+      weight += fits[i]->offset * fits[i]->offset;
+    }
+    if (weight > 0.0) output.latency = lag / weight * 1000.0;
+  }
+  return output;
+}
+
+void offset_calibration::print() const {
+  offset_calibration_result result = solve();
+  printf("offset calibration: %d samples, %.0f deg turned", result.samples, result.turned);
+  if (!result.solved) {
+    printf(", needs at least 10 samples and %.0f deg of turning\n", TURN_MIN);
+    return;
+  }
+  printf(", IMU lags %.1f ms\n", result.latency);
+
+  const char* NAMES[] = {"left", "right", "front", "back"};
+  const offset_fit* fits[4] = {&result.left, &result.right, &result.front, &result.back};
+  if (!result.left.used && !result.right.used && !result.front.used && !result.back.used) printf("  no tracking wheels read anything\n");
+  for (int i = 0; i < 4; i++) {
+    if (!fits[i]->used) continue;
+    printf("  %-6s %8.3f in  +/- %.3f  residual %.3f in%s\n", NAMES[i], fits[i]->offset, fits[i]->std_error, fits[i]->residual,
+           fits[i]->residual > 0.1 ? "  (slipping, or the robot slid)" : "");
+  }
+}
+
+/////
+// Spinning
+/////
+offset_calibration_result control::offsets_measure(drive_backend& backend, offset_calibration& calibration, int speed) {
+  // Fraction of speed and how long, clockwise positive.  Two speeds each way so the IMU's lag shows up, then a stop
+  struct spin {
+    double power;
+    int time;  // ms
+  };
+  static const spin SPINS[] = {{0.6, 900}, {1.0, 700}, {-0.6, 900}, {-1.0, 700}, {0.0, 400}};
+
+  calibration.clear();
+  backend.enable();
+  for (const spin& s : SPINS) {
+    double power = s.power * speed;
+    for (int elapsed = 0; elapsed < s.time; elapsed += ez::util::DELAY_TIME) {
+      backend.drive_set(power, -power);
+      calibration.add(backend.capture(false));
+      pros::delay(ez::util::DELAY_TIME);
+    }
+  }
+  backend.drive_set(0, 0);
+  backend.disable();
+  return calibration.solve();
+}
@@ -0,0 +1,284 @@
+#include "control/particle_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "control/pipeline.hpp"
+
+using namespace control;
+
+// Four floats at once, NEON on the brain and SSE on a host
+typedef float float4 __attribute__((vector_size(16)));
+
+static float4 load(const std::array<float, particle_filter::CAPACITY>& a, int i) { return *(const float4*)&a[i]; }
+static void store(std::array<float, particle_filter::CAPACITY>& a, int i, float4 v) { *(float4*)&a[i] = v; }
+static float4 splat(float v) { return float4{v, v, v, v}; }
+
+// Distance sensors read up to 2 m, and 9999 when they see nothing
+static const int DISTANCE_MAX = 2000;  // mm
+
+// Distance sensors update about this often, reading faster only counts the same reading twice
+static const int DISTANCE_PERIOD = 33;  // ms
+
+
+// relocalize() waits until the readings' noise averages down to converged this many times over in variance
+static const double AVERAGED = 4.0;
+
+// Standard deviations, RMS over the sensors, the readings can be off from the pose relocalize() settles on
+static const double RESIDUAL_MAX = 2.0;
+
+particle_filter::particle_filter(int count, const particle_constants& constants, uint32_t seed)
+    : constants(constants), count(std::clamp((count + 3) / 4 * 4, 4, CAPACITY)), random_state(seed == 0 ? 1 : seed) {
+  reset({0.0, 0.0, 0.0}, 0.0, 0.0);
+}
+
+void particle_filter::constants_set(const particle_constants& new_constants) { constants = new_constants; }
+particle_constants particle_filter::constants_get() { return constants; }
+int particle_filter::count_get() { return count; }
+
+/////
+// Noise
+/////
+float particle_filter::uniform() {
+  // xorshift32
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return (random_state >> 8) * (1.0f / 16777216.0f);
+}
+
+float particle_filter::gaussian() {
+  // Sum of 4 uniforms is close enough to normal for particle noise, with no log or sqrt
+  return (uniform() + uniform() + uniform() + uniform() - 2.0f) * 1.7320508f;
+}
+
+/////
+// Filter
+/////
+void particle_filter::reset(const ez::pose& pose, double position_std, double heading_std) {
+  particles& p = sets[current];
+  float heading = ez::util::to_rad(pose.theta);
+  float heading_noise = ez::util::to_rad(heading_std);
+  for (int i = 0; i < count; i++) {
+    p.x[i] = pose.x + gaussian() * position_std;
+    p.y[i] = pose.y + gaussian() * position_std;
+    float theta = heading + gaussian() * heading_noise;
+    p.sin[i] = sinf(theta);
+    p.cos[i] = cosf(theta);
+    p.weight[i] = 1.0f / count;
+  }
+}
+
+void particle_filter::predict(const ez::pose& motion) {
+  particles& p = sets[current];
+  float right = motion.x, forward = motion.y, turn = ez::util::to_rad(motion.theta);
+  float right_std = constants.tracker * fabs(right) + constants.jitter;
+  float forward_std = constants.tracker * fabs(forward) + constants.jitter;
+  float turn_std = constants.heading * fabs(turn) + ez::util::to_rad(constants.jitter_heading);
+  float turn_sin = sinf(turn), turn_cos = cosf(turn);
+
+  for (int i = 0; i < count; i++) {
+    float s = p.sin[i], c = p.cos[i];
+    float f = forward + gaussian() * forward_std;
+    float r = right + gaussian() * right_std;
+    p.x[i] += f * s + r * c;
+    p.y[i] += f * c - r * s;
+
+    // Turn by odometry's turn, then by a small noise angle where the series is plenty
+    float n = gaussian() * turn_std;
+    float noise_sin = n - n * n * n / 6.0f, noise_cos = 1.0f - n * n / 2.0f;
+    float rotate_sin = turn_sin * noise_cos + turn_cos * noise_sin;
+    float rotate_cos = turn_cos * noise_cos - turn_sin * noise_sin;
+    float new_sin = s * rotate_cos + c * rotate_sin;
+    float new_cos = c * rotate_cos - s * rotate_sin;
+    // One Newton step back to unit length, the series and float rounding both drift
+    float scale = 1.5f - 0.5f * (new_sin * new_sin + new_cos * new_cos);
+    p.sin[i] = new_sin * scale;
+    p.cos[i] = new_cos * scale;
+  }
+}
+
+void particle_filter::update(const distance_mount* mounts, const double* ranges, int sensors) {
+  particles& p = sets[current];
+  const field_walls& f = constants.field;
+  const float4 zero = splat(0.0f), infinite = splat(INFINITY);
+  const float4 left = splat(f.left), right = splat(f.right), bottom = splat(f.bottom), top = splat(f.top);
+  const float4 cap = splat(constants.outlier * constants.outlier);
+  for (int i = 0; i < count; i += 4) store(error, i, zero);
+
+  int used = 0;
+  for (int sensor = 0; sensor < std::min(sensors, SENSORS); sensor++) {
+    if (ranges[sensor] <= 0.0) continue;
+    used++;
+    const distance_mount& m = mounts[sensor];
+    float std_dev = noise_get(ranges[sensor]);
+    const float4 range = splat(ranges[sensor]), inverse_variance = splat(1.0f / (std_dev * std_dev));
+    const float4 mount_x = splat(m.x), mount_y = splat(m.y);
+    const float4 mount_sin = splat(sinf(ez::util::to_rad(m.angle))), mount_cos = splat(cosf(ez::util::to_rad(m.angle)));
+
+    for (int i = 0; i < count; i += 4) {
+      float4 s = load(p.sin, i), c = load(p.cos, i);
+      float4 sensor_x = load(p.x, i) + mount_x * c + mount_y * s;
+      float4 sensor_y = load(p.y, i) - mount_x * s + mount_y * c;
+      float4 beam_x = s * mount_cos + c * mount_sin;
+      float4 beam_y = c * mount_cos - s * mount_sin;
+
+      // Range to the wall the beam is heading for on each axis, the nearer one is what the sensor sees
+      float4 range_x = ((beam_x > zero ? right : left) - sensor_x) / beam_x;
+      float4 range_y = ((beam_y > zero ? top : bottom) - sensor_y) / beam_y;
+      range_x = beam_x == zero ? infinite : range_x;
+      range_y = beam_y == zero ? infinite : range_y;
+      float4 expected = range_x < range_y ? range_x : range_y;
+
+      // Capped, so a robot in front of one sensor can't wipe out the right particles
+      float4 e = range - expected;
+      float4 e2 = e * e * inverse_variance;
+      store(error, i, load(error, i) + (e2 < cap ? e2 : cap));
+    }
+  }
+  if (used == 0) return;
+
+  double total = 0.0;
+  for (int i = 0; i < count; i++) {
+    p.weight[i] *= expf(-0.5f * error[i]);
+    total += p.weight[i];
+  }
+  if (!(total > 1e-30)) {
+    // Nothing matched, start the weights over rather than divide by 0
+    for (int i = 0; i < count; i++) p.weight[i] = 1.0f / count;
+    return;
+  }
+  double squares = 0.0;
+  for (int i = 0; i < count; i++) {
+    p.weight[i] /= total;
+    squares += p.weight[i] * p.weight[i];
+  }
+
+  // Resample once fewer than half the particles are doing the work
+  if (1.0 / squares < count / 2.0) resample();
+}
+
+void particle_filter::resample() {
+  // Low variance resampling, one random draw spaced out evenly across the weights
+  const particles& from = sets[current];
+  particles& to = sets[current ^ 1];
+  float step = 1.0f / count;
+  float target = uniform() * step;
+  float sum = from.weight[0];
+  int j = 0;
+  for (int i = 0; i < count; i++) {
+    while (target > sum && j < count - 1) sum += from.weight[++j];
+    to.x[i] = from.x[j];
+    to.y[i] = from.y[j];
+    to.sin[i] = from.sin[j];
+    to.cos[i] = from.cos[j];
+    to.weight[i] = step;
+    target += step;
+  }
+  current ^= 1;
+}
+
+ez::pose particle_filter::estimate_get() {
+  const particles& p = sets[current];
+  double x = 0.0, y = 0.0, s = 0.0, c = 0.0;
+  for (int i = 0; i < count; i++) {
+    x += p.weight[i] * p.x[i];
+    y += p.weight[i] * p.y[i];
+    s += p.weight[i] * p.sin[i];
+    c += p.weight[i] * p.cos[i];
+  }
+  return {x, y, ez::util::to_deg(atan2(s, c))};
+}
+
+double particle_filter::spread_get() {
+  const particles& p = sets[current];
+  ez::pose mean = estimate_get();
+  double sum = 0.0;
+  for (int i = 0; i < count; i++) sum += p.weight[i] * (pow(p.x[i] - mean.x, 2) + pow(p.y[i] - mean.y, 2));
+  return sqrt(sum);
+}
+
+double particle_filter::noise_get(double range) { return fmax(constants.distance_floor, constants.distance_fraction * range); }
+
+double particle_filter::residual_get(const distance_mount* mounts, const double* ranges, int sensors) {
+  const field_walls& f = constants.field;
+  ez::pose pose = estimate_get();
+  double s = sin(ez::util::to_rad(pose.theta)), c = cos(ez::util::to_rad(pose.theta));
+  double sum = 0.0;
+  int used = 0;
+  for (int sensor = 0; sensor < std::min(sensors, SENSORS); sensor++) {
+    if (ranges[sensor] <= 0.0) continue;
+    const distance_mount& m = mounts[sensor];
+    double sensor_x = pose.x + m.x * c + m.y * s;
+    double sensor_y = pose.y - m.x * s + m.y * c;
+    double mount_s = sin(ez::util::to_rad(m.angle)), mount_c = cos(ez::util::to_rad(m.angle));
+    double beam_x = s * mount_c + c * mount_s;
+    double beam_y = c * mount_c - s * mount_s;
+    double range_x = beam_x > 0.0 ? (f.right - sensor_x) / beam_x : beam_x < 0.0 ? (f.left - sensor_x) / beam_x : INFINITY;
+    double range_y = beam_y > 0.0 ? (f.top - sensor_y) / beam_y : beam_y < 0.0 ? (f.bottom - sensor_y) / beam_y : INFINITY;
+    double e = (ranges[sensor] - fmin(range_x, range_y)) / noise_get(ranges[sensor]);
+    sum += e * e;
+    used++;
+  }
+  return used == 0 ? 0.0 : sqrt(sum / used);
+}
+
+/////
+// Relocalizing odometry
+/////
+bool control::relocalize(pipeline& drive, particle_filter& filter, const std::vector<wall_sensor>& sensors, double position_std,
+                         double heading_std, int timeout, double converged) {
+  distance_mount mounts[particle_filter::SENSORS];
+  pros::Distance* devices[particle_filter::SENSORS];
+  int amount = 0;
+  for (const wall_sensor& s : sensors) {
+    if (amount == particle_filter::SENSORS) break;
+    if (!s.sensor->is_installed()) continue;
+    mounts[amount] = s.mount;
+    devices[amount++] = s.sensor;
+  }
+  if (amount == 0) return false;
+
+  pose_snapshot last = drive.odom_pose_current_get();
+  filter.reset(last.pose, position_std, heading_std);
+  uint32_t start = pros::millis();
+  int updates = 0;
+  // 1 / in^2 added up over every reading, along x and y.  A wall only tells the filter how far away it is
+  double information_x = 0.0, information_y = 0.0;
+  while (pros::millis() - start < (uint32_t)timeout) {
+    // Carry the particles along with whatever odometry saw since the last reading
+    pose_snapshot now = drive.odom_pose_current_get();
+    double theta = ez::util::to_rad(last.pose.theta);
+    double dx = now.pose.x - last.pose.x, dy = now.pose.y - last.pose.y;
+    filter.predict({dx * cos(theta) - dy * sin(theta), dx * sin(theta) + dy * cos(theta), now.pose.theta - last.pose.theta});
+    last = now;
+
+    double ranges[particle_filter::SENSORS];
+    double heading = filter.estimate_get().theta;
+    for (int i = 0; i < amount; i++) {
+      int32_t mm = devices[i]->get_distance();
+      ranges[i] = mm > 0 && mm < DISTANCE_MAX ? mm / 25.4 : 0.0;
+      if (ranges[i] <= 0.0) continue;
+      double beam = ez::util::to_rad(heading + mounts[i].angle);
+      double information = 1.0 / pow(filter.noise_get(ranges[i]), 2);
+      information_x += information * pow(sin(beam), 2);
+      information_y += information * pow(cos(beam), 2);
+    }
+    filter.update(mounts, ranges, amount);
+    updates++;
+
+    // Particles bunch up faster than the readings pin the pose down, so also wait for the sensors' noise to average down
+    // to converged both ways, and check the readings fit where the particles ended up
+    double averaged = AVERAGED / (converged * converged);
+    if (updates >= 3 && information_x >= averaged && information_y >= averaged && filter.spread_get() < converged &&
+        filter.residual_get(mounts, ranges, amount) < RESIDUAL_MAX) {
+      ez::pose found = filter.estimate_get();
+      // The heading comes back wrapped, keep odometry's turn count
+      found.theta = now.pose.theta + ez::util::wrap_angle(found.theta - now.pose.theta);
+      drive.odom_pose_set(found, now.timestamp);
+      return true;
+    }
+    pros::delay(DISTANCE_PERIOD);
+  }
+  return false;
+}
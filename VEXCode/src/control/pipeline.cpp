@@ -0,0 +1,671 @@
+#include "control/pipeline.hpp"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "control/flight_recorder.hpp"
+
+using namespace control;
+
+pipeline::pipeline(drive_backend& backend, int period)
+    : loop("pipeline", period),
+      latency(50),
+      pose_age(50),
+      wake_latency(50),
+      handoff(period * 4000 / histogram::BINS),
+      odom_loop("odometry", 5),
+      backend(backend),
+      task([this]() { loop.run([this]() { if (is_enabled) tick(); }); }, TASK_PRIORITY_DEFAULT + 2, TASK_STACK_DEPTH_DEFAULT, "pipeline"),
+      prepare_task([this]() { queue_task(); }, TASK_PRIORITY_DEFAULT - 1, TASK_STACK_DEPTH_DEFAULT, "pipeline prepare"),
+      odom_task([this]() { odom_loop.run([this]() { if (is_enabled && odom_separate) odom_tick(); }); }, TASK_PRIORITY_DEFAULT + 3,
+                TASK_STACK_DEPTH_DEFAULT, "pipeline odometry") {}
+
+void pipeline::constants_sync() {
+  mutex.take();
+  backend.constants_get(constants);
+  constants.period = loop.period_get();
+  mutex.give();
+}
+
+void pipeline::enable() {
+  if (is_enabled) return;
+  constants_sync();
+
+  backend.enable();
+
+  mutex.take();
+  current = nullptr;
+  pending = nullptr;
+  queue.clear();
+  exit = ez::RUNNING;
+  exited = 0;
+  index = -1;
+  heading_target = backend.imu_get();
+  queue_end = backend.pose_get();
+  backend.zero();
+  backend.reads_reset();
+
+  // Readers get the starting pose until odometry publishes its first one
+  state = {};
+  state.pose = queue_end;
+  state.imu = heading_target;
+  state.timestamp = pros::micros();
+  poses_mutex.take();
+  poses.reset();
+  poses_mutex.give();
+  estimator_running = estimator_on;
+  if (estimator_running) {
+    ekf.constants_set(estimator_constants);
+    ekf.reset(queue_end);
+    odom_last = reckoned = queue_end;
+    reckoned_poses.reset();
+    reckoned_poses.add(state.timestamp, reckoned);
+    estimator_last = state.timestamp;
+    readings_mutex.take();
+    gps_count = distance_count = 0;
+    readings_used = readings_rejected = readings_dropped = 0;
+    readings_mutex.give();
+  }
+  readings_mutex.take();
+  move_pending = false;
+  readings_mutex.give();
+  publish(state, state.timestamp);
+  recorder_running = recorder;
+  odom_separate = odom_period > 0;
+  if (odom_separate) {
+    odom_loop.period_set(odom_period);
+    backend.data_rate_set(odom_period);
+  }
+  mutex.give();
+
+  loop.start();
+  if (odom_separate) odom_loop.start();
+  is_enabled = true;
+}
+
+void pipeline::disable() {
+  if (!is_enabled) return;
+  is_enabled = false;
+
+  mutex.take();
+  if (current && exited == 0) motion_end();
+  current = nullptr;
+  pending = nullptr;
+  queue.clear();
+  // Nothing will exit now, so let every waiting task go
+  for (auto w : waiters) {
+    w->done = true;
+    w->task.notify();
+  }
+  mutex.give();
+
+  backend.disable();
+}
+
+bool pipeline::enabled() { return is_enabled; }
+
+void pipeline::sensors_batch_set(bool batch) { sensors_batch = batch; }
+bool pipeline::sensors_batch_get() { return sensors_batch; }
+
+void pipeline::odom_period_set(int ms) {
+  // 0 turns the odometry task off, at 1 ms it would leave lower tasks almost no time
+  odom_period = ms <= 0 ? 0 : std::min(std::max(ms, 2), loop.period_get());
+}
+int pipeline::odom_period_get() { return odom_period; }
+
+pose_snapshot pipeline::odom_pose_get() {
+  uint32_t sequence;
+  estimate newest = published.read(&sequence);
+  return {newest.state.pose, sequence, newest.state.timestamp};
+}
+
+bool pipeline::odom_pose_at(uint64_t timestamp, ez::pose& output) {
+  poses_mutex.take();
+  bool found = poses.pose_at(timestamp, output);
+  poses_mutex.give();
+  return found;
+}
+
+bool pipeline::odom_pose_propagate(const ez::pose& measured, uint64_t timestamp, ez::pose& output) {
+  poses_mutex.take();
+  bool found = poses.propagate(measured, timestamp, output);
+  poses_mutex.give();
+  return found;
+}
+
+void pipeline::odom_pose_set(const ez::pose& pose, uint64_t timestamp) {
+  if (!is_enabled) {
+    backend.pose_set(pose);
+    return;
+  }
+  readings_mutex.take();
+  move_pending = true;
+  move_pose = pose;
+  move_timestamp = timestamp;
+  readings_mutex.give();
+}
+
+pose_snapshot pipeline::odom_pose_current_get() {
+  if (is_enabled) return odom_pose_get();
+  return {backend.pose_get(), 0, pros::micros()};
+}
+
+void pipeline::move_apply() {
+  readings_mutex.take();
+  bool moving = move_pending;
+  ez::pose pose = move_pose;
+  uint64_t timestamp = move_timestamp;
+  move_pending = false;
+  readings_mutex.give();
+  if (!moving) return;
+
+  // Carry the pose over whatever odometry saw since it was measured
+  if (timestamp != 0) {
+    ez::pose carried;
+    poses_mutex.take();
+    if (poses.propagate(pose, timestamp, carried)) pose = carried;
+    poses_mutex.give();
+  }
+  backend.pose_set(pose);
+  if (estimator_running) {
+    ekf.reset(pose);
+    odom_last = pose;
+  }
+}
+
+void pipeline::publish(const drive_state& now, uint64_t estimated) {
+  published.write({now, estimated});
+  poses_mutex.take();
+  poses.add(now.timestamp, now.pose);
+  poses_mutex.give();
+}
+
+/////
+// Estimator
+/////
+void pipeline::estimator_set(bool enable) { estimator_on = enable; }
+bool pipeline::estimator_get() { return estimator_on; }
+void pipeline::estimator_constants_set(const ekf_constants& constants) { estimator_constants = constants; }
+ekf_constants pipeline::estimator_constants_get() { return estimator_constants; }
+
+void pipeline::estimator_gps_add(double x, double y, double std_dev, uint64_t timestamp) {
+  readings_mutex.take();
+  if (gps_count < READINGS)
+    gps_readings[gps_count++] = {x, y, std_dev, timestamp};
+  else
+    readings_dropped++;
+  readings_mutex.give();
+}
+
+void pipeline::estimator_distance_add(const distance_mount& mount, double range, uint64_t timestamp) {
+  readings_mutex.take();
+  if (distance_count < READINGS)
+    distance_readings[distance_count++] = {mount, range, timestamp};
+  else
+    readings_dropped++;
+  readings_mutex.give();
+}
+
+void pipeline::readings_apply() {
+  // Copy them out so sensor tasks never wait on an update
+  readings_mutex.take();
+  std::array<gps_reading, READINGS> gps = gps_readings;
+  std::array<distance_reading, READINGS> distance = distance_readings;
+  int gps_new = gps_count, distance_new = distance_count;
+  gps_count = distance_count = 0;
+  readings_mutex.give();
+
+  // Each reading is compared against where the robot was when it was taken
+  ez::pose since;
+  for (int i = 0; i < gps_new; i++) {
+    const gps_reading& r = gps[i];
+    bool used = reckoned_poses.motion_since(r.timestamp, since) && ekf.gps_update(r.x, r.y, r.std_dev, since);
+    used ? readings_used++ : readings_rejected++;
+  }
+  for (int i = 0; i < distance_new; i++) {
+    const distance_reading& r = distance[i];
+    bool used = reckoned_poses.motion_since(r.timestamp, since) && ekf.distance_update(r.mount, r.range, since);
+    used ? readings_used++ : readings_rejected++;
+  }
+}
+
+/////
+// Flight recorder
+/////
+void pipeline::recorder_set(flight_recorder* new_recorder) { recorder = new_recorder; }
+flight_recorder* pipeline::recorder_get() { return recorder; }
+
+ez::pose pipeline::odom_run(const drive_state& now) {
+  wheel_odometry* odometry = recorder_running ? backend.odometry_get() : nullptr;
+  if (recorder_running) recorder_running->odometry_check(odometry);
+  ez::pose pose = backend.odom_update(now);
+  if (recorder_running) recorder_running->add(now, pose, backend.reads_get(), odometry);
+  if (!estimator_running) return pose;
+
+  // Odometry's motion this tick, relative to where the tick started
+  double theta = ez::util::to_rad(odom_last.theta);
+  double dx = pose.x - odom_last.x, dy = pose.y - odom_last.y;
+  ez::pose motion = {dx * cos(theta) - dy * sin(theta), dx * sin(theta) + dy * cos(theta), pose.theta - odom_last.theta};
+  ekf.predict(motion, (now.timestamp - estimator_last) / 1e6, now.imu_rate);
+  estimator_last = now.timestamp;
+
+  theta = ez::util::to_rad(reckoned.theta);
+  reckoned.x += motion.x * cos(theta) + motion.y * sin(theta);
+  reckoned.y += -motion.x * sin(theta) + motion.y * cos(theta);
+  reckoned.theta += motion.theta;
+  reckoned_poses.add(now.timestamp, reckoned);
+
+  // A reading moved the estimate, odometry carries on from there
+  int used = readings_used;
+  readings_apply();
+  odom_last = ekf.pose_get();
+  if (readings_used != used) backend.pose_set(odom_last);
+  return odom_last;
+}
+
+void pipeline::odom_tick() {
+  backend.odom_tick_begin();
+  // A move changes what the backend reads, so it goes in before this tick's sensors are
+  move_apply();
+  drive_state now;
+  static_cast<drive_snapshot&>(now) = backend.capture(sensors_batch);
+  now.pose = odom_run(now);
+  publish(now, pros::micros());
+  backend.odom_tick_end();
+}
+
+void pipeline::tick() {
+  uint64_t sensed, estimated;
+  drive_state now;
+  if (odom_separate) {
+    // Sense and estimate already ran in the odometry task, take the newest
+    estimate newest = published.read();
+    now = newest.state;
+    sensed = now.timestamp;
+    estimated = newest.estimated;
+  } else {
+    // Sense, after any move so the sensors are read against the new pose
+    move_apply();
+    sensed = pros::micros();
+    static_cast<drive_snapshot&>(now) = backend.capture(sensors_batch);
+
+    // Estimate
+    now.pose = odom_run(now);
+    estimated = pros::micros();
+    publish(now, estimated);
+  }
+
+  mutex.take();
+  state = now;
+
+  // Control, a new motion starts from this tick's state
+  if (pending) motion_start(std::move(pending), false);
+  drive_output output;
+  if (current) {
+    pose_age.add(pros::micros() - estimated);
+    output = current->iterate(state);
+    exit = current->exit_condition();
+    index = current->index_get();
+  }
+
+  // The next queued motion takes over on the tick this one exits, its output replaces the old motion's
+  if (exit != ez::RUNNING && exited == 0) {
+    exited = pros::micros();
+    motion_end();
+  }
+  if ((!current || exit != ez::RUNNING) && !queue.empty() && queue.front().stage == PREPARED) {
+    motion_start(std::move(queue.front().next), true);
+    queue.pop_front();
+    prepare_task.notify();
+    output = current->iterate(state);
+    exit = current->exit_condition();
+    index = current->index_get();
+  }
+  bool active = current != nullptr;
+  waiters_notify();
+  mutex.give();
+
+  // Actuate
+  if (active) {
+    backend.drive_set(output.left, output.right);
+    latency.add(pros::micros() - sensed);
+  }
+  backend.tick_end();
+}
+
+void pipeline::motion_start(std::shared_ptr<motion> next, bool queued) {
+  // A motion replaced before it exits still goes in the history
+  if (current && exited == 0) motion_end();
+  current = std::move(next);
+  current->initialize(state);
+  record = {current->name_get(), pros::millis(), 0, ez::RUNNING, current->end_get(state.pose), state.pose, 0};
+  exit = ez::RUNNING;
+  index = -1;
+  // Only a queued motion is handed off, a motion set after an exit waited on the caller
+  if (exited != 0 && queued) handoff.add(pros::micros() - exited);
+  exited = 0;
+}
+
+void pipeline::motion_end() {
+  record.end = pros::millis();
+  record.exit = exited == 0 ? ez::RUNNING : exit;
+  record.pose = state.pose;
+  record.saved = current->saved_get();
+  history.push_back(record);
+}
+
+void pipeline::motion_set(std::unique_ptr<motion> new_motion) {
+  mutex.take();
+  // Setting a motion directly replaces whatever was queued
+  queue.clear();
+  queue_end = new_motion->end_get(is_enabled ? odom_pose_get().pose : backend.pose_get());
+  pending = std::move(new_motion);
+  exit = ez::RUNNING;
+  index = -1;
+  mutex.give();
+}
+
+/////
+// Motions
+/////
+std::unique_ptr<motion> pipeline::drive_make(double target, int speed, bool slew_on) {
+  if (drive_profile) return std::make_unique<profiled_drive_motion>(constants, target, speed, heading_target);
+  return std::make_unique<drive_motion>(constants, target, speed, slew_on, heading_target);
+}
+
+void pipeline::pid_drive_constants_set(std::vector<gain_point> schedule) {
+  mutex.take();
+  constants.drive_schedule.set(std::move(schedule));
+  mutex.give();
+}
+
+void pipeline::pid_turn_constants_set(std::vector<gain_point> schedule) {
+  mutex.take();
+  constants.turn_schedule.set(std::move(schedule));
+  mutex.give();
+}
+
+void pipeline::slew_drive_constants_set(slew_limits limits) {
+  mutex.take();
+  constants.slew_drive_limits = limits;
+  mutex.give();
+}
+
+void pipeline::slew_turn_constants_set(slew_limits limits) {
+  mutex.take();
+  constants.slew_turn_limits = limits;
+  mutex.give();
+}
+
+void pipeline::pid_drive_profile_set(bool toggle) { drive_profile = toggle; }
+bool pipeline::pid_drive_profile_get() { return drive_profile; }
+
+std::unique_ptr<motion> pipeline::turn_make(double target, int speed, ez::e_angle_behavior behavior, bool slew_on) {
+  // Later drive motions hold the heading the robot was told to turn to
+  heading_target = turn_target_get(target, heading_target, behavior);
+  if (turn_profile) return std::make_unique<profiled_turn_motion>(constants, target, speed, behavior);
+  return std::make_unique<turn_motion>(constants, target, speed, behavior, slew_on);
+}
+
+void pipeline::pid_turn_profile_set(bool toggle) { turn_profile = toggle; }
+bool pipeline::pid_turn_profile_get() { return turn_profile; }
+
+void pipeline::pid_settle_predict_set(bool toggle) {
+  mutex.take();
+  constants.settle.enabled = toggle;
+  mutex.give();
+}
+bool pipeline::pid_settle_predict_get() { return constants.settle.enabled; }
+
+void pipeline::pid_derivative_set(derivative_constants d) {
+  mutex.take();
+  constants.derivative = d;
+  mutex.give();
+}
+derivative_constants pipeline::pid_derivative_get() { return constants.derivative; }
+
+std::unique_ptr<motion> pipeline::odom_make(ez::odom imovement, bool slew_on) {
+  if (imovement.target.theta == ez::ANGLE_NOT_SET)
+    return std::make_unique<point_motion>(constants, imovement, slew_on);
+  heading_target = imovement.target.theta;
+  return std::make_unique<boomerang_motion>(constants, imovement, slew_on);
+}
+
+std::unique_ptr<motion> pipeline::pursuit_make(std::vector<ez::odom> imovements, bool slew_on) {
+  if (!imovements.empty() && imovements.back().target.theta != ez::ANGLE_NOT_SET)
+    heading_target = imovements.back().target.theta;
+  return std::make_unique<pursuit_motion>(constants, imovements, slew_on);
+}
+
+void pipeline::pid_drive_set(double target, int speed, bool slew_on) { motion_set(drive_make(target, speed, slew_on)); }
+void pipeline::pid_drive_set(okapi::QLength p_target, int speed, bool slew_on) {
+  pid_drive_set(p_target.convert(okapi::inch), speed, slew_on);
+}
+
+void pipeline::pid_turn_set(double target, int speed, ez::e_angle_behavior behavior, bool slew_on) {
+  motion_set(turn_make(target, speed, behavior, slew_on));
+}
+void pipeline::pid_turn_set(double target, int speed, bool slew_on) {
+  pid_turn_set(target, speed, backend.turn_behavior_get(), slew_on);
+}
+void pipeline::pid_turn_set(okapi::QAngle p_target, int speed, bool slew_on) {
+  pid_turn_set(p_target.convert(okapi::degree), speed, slew_on);
+}
+
+void pipeline::pid_odom_set(ez::odom imovement, bool slew_on) { motion_set(odom_make(imovement, slew_on)); }
+void pipeline::pid_odom_set(ez::united_odom p_imovement, bool slew_on) {
+  pid_odom_set(ez::util::united_odom_to_odom(p_imovement), slew_on);
+}
+
+void pipeline::pid_odom_set(std::vector<ez::odom> imovements, bool slew_on) { motion_set(pursuit_make(imovements, slew_on)); }
+void pipeline::pid_odom_set(std::vector<ez::united_odom> p_imovements, bool slew_on) {
+  pid_odom_set(ez::util::united_odoms_to_odoms(p_imovements), slew_on);
+}
+
+/////
+// Queue
+/////
+void pipeline::queue_add(std::unique_ptr<motion> new_motion) {
+  mutex.take();
+  ez::pose start = queue_end;
+  queue_end = new_motion->end_get(start);
+  queue.push_back({std::move(new_motion), start, QUEUED});
+  mutex.give();
+  prepare_task.notify();
+}
+
+void pipeline::queue_drive_add(double target, int speed, bool slew_on) { queue_add(drive_make(target, speed, slew_on)); }
+void pipeline::queue_drive_add(okapi::QLength p_target, int speed, bool slew_on) {
+  queue_drive_add(p_target.convert(okapi::inch), speed, slew_on);
+}
+
+void pipeline::queue_turn_add(double target, int speed, bool slew_on) {
+  queue_add(turn_make(target, speed, backend.turn_behavior_get(), slew_on));
+}
+void pipeline::queue_turn_add(okapi::QAngle p_target, int speed, bool slew_on) {
+  queue_turn_add(p_target.convert(okapi::degree), speed, slew_on);
+}
+
+void pipeline::queue_odom_add(ez::united_odom p_imovement, bool slew_on) {
+  queue_add(odom_make(ez::util::united_odom_to_odom(p_imovement), slew_on));
+}
+void pipeline::queue_odom_add(std::vector<ez::united_odom> p_imovements, bool slew_on) {
+  queue_add(pursuit_make(ez::util::united_odoms_to_odoms(p_imovements), slew_on));
+}
+
+void pipeline::queue_clear() {
+  mutex.take();
+  queue.clear();
+  mutex.give();
+}
+
+bool pipeline::queue_prepare() {
+  mutex.take();
+  auto next = std::find_if(queue.begin(), queue.end(), [](const queued& q) { return q.stage == QUEUED; });
+  if (next == queue.end()) {
+    mutex.give();
+    return false;
+  }
+  // Holding a reference keeps the motion alive if the queue is cleared while it's being prepared
+  std::shared_ptr<motion> preparing = next->next;
+  ez::pose start = next->start;
+  next->stage = PREPARING;
+  mutex.give();
+
+  preparing->prepare(start);
+
+  mutex.take();
+  for (auto& q : queue)
+    if (q.next == preparing) q.stage = PREPARED;
+  mutex.give();
+  return true;
+}
+
+void pipeline::queue_task() {
+  while (true) {
+    pros::Task::notify_take(true, TIMEOUT_MAX);
+    while (queue_prepare()) {
+    }
+  }
+}
+
+void pipeline::queue_wait() {
+  waiter w = {pros::Task::current()};
+  w.queue = true;
+  wait(w);
+}
+
+/////
+// Waits
+/////
+bool pipeline::waiter_done(waiter& w) {
+  // A motion that hasn't started yet hasn't passed anything
+  if (pending) return false;
+  if (w.queue) return queue.empty() && (!current || exit != ez::RUNNING);
+  if (exit != ez::RUNNING) return true;
+  if (w.has_point) {
+    // The point is passed once it moves from in front of the robot to behind it, or the other way when driving backwards
+    ez::pose current = state.pose;
+    double theta = ez::util::to_rad(current.theta);
+    double along = (w.point.x - current.x) * sin(theta) + (w.point.y - current.y) * cos(theta);
+    int side = ez::util::sgn(along);
+    if (w.side == 0) w.side = side;
+    return side != w.side || ez::util::distance_to_point(w.point, current) < 0.5;
+  }
+  return w.index >= 0 && index >= w.index;
+}
+
+void pipeline::waiters_notify() {
+  for (auto w : waiters) {
+    if (w->done || !waiter_done(*w)) continue;
+    w->done = true;
+    w->woken = pros::micros();
+    w->task.notify();
+  }
+}
+
+void pipeline::wait(waiter& w) {
+  mutex.take();
+  if (!is_enabled || waiter_done(w)) {
+    mutex.give();
+    return;
+  }
+  waiters.push_back(&w);
+  mutex.give();
+
+  // The waiter lives on this stack, so it comes out of the list even if the wait is unwound by an exception
+  struct remover {
+    pipeline& p;
+    waiter& w;
+    ~remover() {
+      p.mutex.take();
+      p.waiters.erase(std::remove(p.waiters.begin(), p.waiters.end(), &w), p.waiters.end());
+      p.mutex.give();
+    }
+  } remove_on_exit{*this, w};
+
+  // The timeout only matters if a notification is missed, the pipeline normally wakes this task
+  while (!w.done)
+    pros::Task::notify_take(true, ez::util::DELAY_TIME * 10);
+  if (w.woken != 0) wake_latency.add(pros::micros() - w.woken);
+}
+
+void pipeline::pid_wait() {
+  waiter w = {pros::Task::current()};
+  wait(w);
+}
+
+void pipeline::pid_wait_until_index(int target_index) {
+  waiter w = {pros::Task::current()};
+  w.index = target_index;
+  wait(w);
+}
+
+void pipeline::pid_wait_until_point(ez::pose target) {
+  waiter w = {pros::Task::current()};
+  w.point = target;
+  w.has_point = true;
+  wait(w);
+}
+void pipeline::pid_wait_until_point(ez::united_pose p_target) {
+  pid_wait_until_point(ez::util::united_pose_to_pose(p_target));
+}
+
+ez::exit_output pipeline::exit_get() {
+  mutex.take();
+  // A motion that hasn't started yet is still running
+  ez::exit_output output = pending ? ez::RUNNING : exit;
+  mutex.give();
+  return output;
+}
+
+drive_state pipeline::state_get() {
+  mutex.take();
+  drive_state output = state;
+  mutex.give();
+  return output;
+}
+
+std::vector<motion_record> pipeline::history_get() {
+  mutex.take();
+  std::vector<motion_record> output = history;
+  mutex.give();
+  return output;
+}
+
+void pipeline::history_clear() {
+  mutex.take();
+  history.clear();
+  mutex.give();
+}
+
+void pipeline::stats_print() {
+  loop.stats_print();
+  if (odom_separate) odom_loop.stats_print();
+  latency.print("sense to actuate");
+  pose_age.print("pose age");
+  backend.reads_print();
+  handoff.print("handoff");
+  if (estimator_running) printf(" estimator readings: %d used, %d thrown out, %d dropped\n", readings_used, readings_rejected, readings_dropped);
+  if (recorder_running)
+    printf(" flight recorder: %lu records written, %lu dropped\n", (unsigned long)recorder_running->written_get(),
+           (unsigned long)recorder_running->dropped_get());
+
+  int early = 0, early_ms = 0;
+  mutex.take();
+  for (auto& r : history) {
+    if (r.saved > 0) early++;
+    early_ms += r.saved;
+  }
+  mutex.give();
+  if (early > 0) printf(" %d motions settled early, %d ms saved over the exit timers\n", early, early_ms);
+
+  // Polling every DELAY_TIME wakes half a period late on average
+  uint32_t waits = wake_latency.count_get();
+  if (waits == 0) return;
+  wake_latency.print("wake latency");
+  double saved = waits * (ez::util::DELAY_TIME * 1000.0 / 2.0 - wake_latency.mean_get());
+  printf(" %lu waits, about %.1f ms saved over polling\n", (unsigned long)waits, saved / 1000.0);
+}
@@ -0,0 +1,168 @@
+#include "control/pose_ekf.hpp"
+
+#include <cmath>
+
+using namespace control;
+
+pose_ekf::pose_ekf(const ekf_constants& constants) : constants(constants) { reset({0.0, 0.0, 0.0}); }
+
+void pose_ekf::constants_set(const ekf_constants& new_constants) { constants = new_constants; }
+ekf_constants pose_ekf::constants_get() { return constants; }
+
+void pose_ekf::reset(const ez::pose& pose, double position_std, double heading_std) {
+  state[0] = pose.x;
+  state[1] = pose.y;
+  state[2] = ez::util::to_rad(pose.theta);
+  state[3] = 0.0;
+  state[4] = 0.0;
+  for (int i = 0; i < N; i++)
+    for (int j = 0; j < N; j++) P[i][j] = 0.0;
+  P[0][0] = P[1][1] = position_std * position_std;
+  P[2][2] = pow(ez::util::to_rad(heading_std), 2);
+}
+
+/////
+// Prediction
+/////
+void pose_ekf::predict(const ez::pose& motion, double dt, double imu_rate) {
+  if (dt <= 0.0) return;
+  double right = motion.x, forward = motion.y, turn = ez::util::to_rad(motion.theta);
+
+  // Odometry already integrated along the turn, the motion is in the frame the tick started in
+  double s = sin(state[2]), c = cos(state[2]);
+  state[0] += forward * s + right * c;
+  state[1] += forward * c - right * s;
+  state[2] += turn;
+  state[3] = forward / dt;
+  state[4] = ez::util::to_rad(imu_rate);
+
+  // Jacobian against the state.  v and w come straight from the sensors, so their rows are 0
+  double dx_dtheta = forward * c - right * s;
+  double dy_dtheta = -forward * s - right * c;
+  double F[N][N] = {{1, 0, dx_dtheta, 0, 0}, {0, 1, dy_dtheta, 0, 0}, {0, 0, 1, 0, 0}, {0, 0, 0, 0, 0}, {0, 0, 0, 0, 0}};
+
+  // Jacobian against the inputs: forward, right, turn and the gyro
+  double G[N][4] = {{s, c, 0, 0},
+                    {c, -s, 0, 0},
+                    {0, 0, 1, 0},
+                    {1.0 / dt, 0, 0, 0},
+                    {0, 0, 0, 1}};
+  double input_variance[4] = {pow(constants.tracker * forward, 2), pow(constants.tracker * right, 2),
+                              pow(constants.heading * turn, 2) + pow(ez::util::to_rad(constants.heading_drift), 2) * dt,
+                              pow(ez::util::to_rad(constants.gyro), 2)};
+
+  // P = F P F' + G Q G'
+  double FP[N][N];
+  for (int i = 0; i < N; i++)
+    for (int j = 0; j < N; j++) {
+      double sum = 0.0;
+      for (int k = 0; k < N; k++) sum += F[i][k] * P[k][j];
+      FP[i][j] = sum;
+    }
+  for (int i = 0; i < N; i++)
+    for (int j = i; j < N; j++) {
+      double sum = 0.0;
+      for (int k = 0; k < N; k++) sum += FP[i][k] * F[j][k];
+      for (int k = 0; k < 4; k++) sum += G[i][k] * input_variance[k] * G[j][k];
+      P[i][j] = P[j][i] = sum;
+    }
+}
+
+/////
+// Updates
+/////
+void pose_ekf::pose_then(const double* s, const ez::pose& since, double output[3]) {
+  output[2] = s[2] - ez::util::to_rad(since.theta);
+  double sin_then = sin(output[2]), cos_then = cos(output[2]);
+  output[0] = s[0] - (since.x * cos_then + since.y * sin_then);
+  output[1] = s[1] - (-since.x * sin_then + since.y * cos_then);
+}
+
+template <typename F>
+bool pose_ekf::update(double measured, double variance, F h) {
+  double expected = h(state);
+  if (std::isnan(expected)) return false;
+
+  // Measurements only see x, y and theta
+  const double STEP[3] = {1e-3, 1e-3, 1e-5};
+  double H[N] = {0.0};
+  for (int i = 0; i < 3; i++) {
+    double high[N], low[N];
+    for (int j = 0; j < N; j++) high[j] = low[j] = state[j];
+    high[i] += STEP[i];
+    low[i] -= STEP[i];
+    double a = h(high), b = h(low);
+    if (std::isnan(a) || std::isnan(b)) return false;
+    H[i] = (a - b) / (2.0 * STEP[i]);
+  }
+
+  double PH[N];
+  for (int i = 0; i < N; i++) {
+    PH[i] = 0.0;
+    for (int j = 0; j < 3; j++) PH[i] += P[i][j] * H[j];
+  }
+  double innovation_variance = variance;
+  for (int i = 0; i < 3; i++) innovation_variance += H[i] * PH[i];
+
+  // Something between the sensor and what it should see, or a bad fix
+  double residual = measured - expected;
+  if (residual * residual > constants.gate * constants.gate * innovation_variance) return false;
+
+  // P = P - K H P, with K = P H' / S
+  for (int i = 0; i < N; i++) state[i] += PH[i] / innovation_variance * residual;
+  for (int i = 0; i < N; i++)
+    for (int j = i; j < N; j++) P[i][j] = P[j][i] = P[i][j] - PH[i] * PH[j] / innovation_variance;
+  return true;
+}
+
+bool pose_ekf::gps_update(double x, double y, double std_dev, const ez::pose& since) {
+  double variance = std_dev * std_dev;
+  bool used_x = update(x, variance, [&since](const double* s) {
+    double then[3];
+    pose_then(s, since, then);
+    return then[0];
+  });
+  bool used_y = update(y, variance, [&since](const double* s) {
+    double then[3];
+    pose_then(s, since, then);
+    return then[1];
+  });
+  return used_x || used_y;
+}
+
+double pose_ekf::range_expected(const double* s, const distance_mount& mount, const ez::pose& since) {
+  double then[3];
+  pose_then(s, since, then);
+  double sin_theta = sin(then[2]), cos_theta = cos(then[2]);
+  double sensor_x = then[0] + mount.x * cos_theta + mount.y * sin_theta;
+  double sensor_y = then[1] - mount.x * sin_theta + mount.y * cos_theta;
+  double beam = then[2] + ez::util::to_rad(mount.angle);
+  double beam_x = sin(beam), beam_y = cos(beam);
+
+  // Nearest wall along the beam
+  const field_walls& f = constants.field;
+  double range_x = beam_x > 0.0 ? (f.right - sensor_x) / beam_x : beam_x < 0.0 ? (f.left - sensor_x) / beam_x : INFINITY;
+  double range_y = beam_y > 0.0 ? (f.top - sensor_y) / beam_y : beam_y < 0.0 ? (f.bottom - sensor_y) / beam_y : INFINITY;
+  bool x_wall = range_x < range_y;
+  double range = x_wall ? range_x : range_y;
+  if (range < 0.0) return NAN;
+
+  // Glancing readings scatter off the wall, and near a corner the wall could be either one
+  double square = fabs(x_wall ? beam_x : beam_y);
+  if (square < cos(ez::util::to_rad(constants.max_incidence))) return NAN;
+  return range;
+}
+
+bool pose_ekf::distance_update(const distance_mount& mount, double range, const ez::pose& since) {
+  double std_dev = fmax(constants.distance_floor, constants.distance_fraction * range);
+  return update(range, std_dev * std_dev, [this, &mount, &since](const double* s) { return range_expected(s, mount, since); });
+}
+
+/////
+// Getters
+/////
+ez::pose pose_ekf::pose_get() { return {state[0], state[1], ez::util::to_deg(state[2])}; }
+double pose_ekf::velocity_get() { return state[3]; }
+double pose_ekf::angular_velocity_get() { return ez::util::to_deg(state[4]); }
+double pose_ekf::position_std_get() { return sqrt(fmax(P[0][0], P[1][1])); }
+double pose_ekf::heading_std_get() { return ez::util::to_deg(sqrt(P[2][2])); }
@@ -0,0 +1,77 @@
+#include "control/pose_history.hpp"
+
+#include <cmath>
+
+using namespace control;
+
+void pose_history::reset() {
+  start = 0;
+  count = 0;
+}
+
+void pose_history::add(uint64_t timestamp, const ez::pose& pose) {
+  if (count > 0 && timestamp <= newest_get()) return;
+  if (count < CAPACITY) {
+    entries[(start + count) % CAPACITY] = {timestamp, pose};
+    count++;
+  } else {
+    // Full, the newest takes the oldest's place
+    entries[start] = {timestamp, pose};
+    start = (start + 1) % CAPACITY;
+  }
+}
+
+int pose_history::count_get() { return count; }
+uint64_t pose_history::oldest_get() { return count == 0 ? 0 : at(0).timestamp; }
+uint64_t pose_history::newest_get() { return count == 0 ? 0 : at(count - 1).timestamp; }
+
+bool pose_history::pose_at(uint64_t timestamp, ez::pose& output) {
+  if (count == 0 || timestamp < at(0).timestamp) return false;
+  if (timestamp >= at(count - 1).timestamp) {
+    output = at(count - 1).pose;
+    return true;
+  }
+
+  // Last entry at or before timestamp, the one after it is past timestamp
+  int low = 0, high = count - 1;
+  while (high - low > 1) {
+    int middle = (low + high) / 2;
+    if (at(middle).timestamp <= timestamp)
+      low = middle;
+    else
+      high = middle;
+  }
+  const entry& a = at(low);
+  const entry& b = at(high);
+  double t = (double)(timestamp - a.timestamp) / (b.timestamp - a.timestamp);
+  output.x = a.pose.x + (b.pose.x - a.pose.x) * t;
+  output.y = a.pose.y + (b.pose.y - a.pose.y) * t;
+  // Turn the short way, odometry headings aren't always wrapped
+  output.theta = a.pose.theta + ez::util::wrap_angle(b.pose.theta - a.pose.theta) * t;
+  return true;
+}
+
+bool pose_history::motion_since(uint64_t timestamp, ez::pose& output) {
+  ez::pose then;
+  if (!pose_at(timestamp, then)) return false;
+  ez::pose now = at(count - 1).pose;
+
+  double theta = ez::util::to_rad(then.theta);
+  double dx = now.x - then.x, dy = now.y - then.y;
+  output.x = dx * cos(theta) - dy * sin(theta);
+  output.y = dx * sin(theta) + dy * cos(theta);
+  output.theta = now.theta - then.theta;
+  return true;
+}
+
+bool pose_history::propagate(const ez::pose& measured, uint64_t timestamp, ez::pose& output) {
+  ez::pose motion;
+  if (!motion_since(timestamp, motion)) return false;
+
+  // The same motion starting from the measured pose
+  double theta = ez::util::to_rad(measured.theta);
+  output.x = measured.x + motion.x * cos(theta) + motion.y * sin(theta);
+  output.y = measured.y - motion.x * sin(theta) + motion.y * cos(theta);
+  output.theta = measured.theta + motion.theta;
+  return true;
+}
@@ -0,0 +1,94 @@
+#include "control/profile.hpp"
+
+#include <cmath>
+
+using namespace control;
+
+double feedforward::output(double velocity, double acceleration) const {
+  double sign = velocity > 0 ? 1.0 : velocity < 0 ? -1.0 : 0.0;
+  double volts = kS * sign + kV * velocity + kA * acceleration;
+  return volts * 127.0 / 12.0;
+}
+
+// Time to speed up from rest to a velocity, and how that time is split
+struct accel_phase {
+  double time;
+  double jerk_time;
+  double peak_acceleration;
+};
+
+static accel_phase accel_phase_get(double velocity, const profile_constraints& c) {
+  if (c.max_jerk <= 0.0) return {velocity / c.max_acceleration, 0.0, c.max_acceleration};
+  // Reaches max acceleration with time to spare
+  if (velocity >= c.max_acceleration * c.max_acceleration / c.max_jerk)
+    return {velocity / c.max_acceleration + c.max_acceleration / c.max_jerk, c.max_acceleration / c.max_jerk, c.max_acceleration};
+  // Acceleration ramps up and straight back down
+  double jerk_time = sqrt(velocity / c.max_jerk);
+  return {2.0 * jerk_time, jerk_time, c.max_jerk * jerk_time};
+}
+
+void motion_profile::generate(double idistance, const profile_constraints& constraints) {
+  sign = idistance < 0 ? -1 : 1;
+  distance = fabs(idistance);
+  peak_velocity = constraints.max_velocity;
+
+  // Speeding up covers velocity * time / 2, and so does slowing down
+  accel_phase phase = accel_phase_get(peak_velocity, constraints);
+  if (peak_velocity * phase.time > distance) {
+    // Too short to reach max velocity, find the peak it can reach
+    double low = 0.0, high = peak_velocity;
+    for (int i = 0; i < 50; i++) {
+      double mid = (low + high) / 2.0;
+      if (mid * accel_phase_get(mid, constraints).time > distance)
+        high = mid;
+      else
+        low = mid;
+    }
+    peak_velocity = low;
+    phase = accel_phase_get(peak_velocity, constraints);
+  }
+
+  accel_time = phase.time;
+  jerk_time = phase.jerk_time;
+  peak_acceleration = phase.peak_acceleration;
+  jerk = jerk_time > 0.0 ? peak_acceleration / jerk_time : 0.0;
+  cruise_time = peak_velocity > 0.0 ? (distance - peak_velocity * accel_time) / peak_velocity : 0.0;
+  if (cruise_time < 0.0) cruise_time = 0.0;
+}
+
+double motion_profile::duration_get() const { return 2.0 * accel_time + cruise_time; }
+
+profile_point motion_profile::accel_sample(double t) const {
+  if (t <= 0.0) return {0.0, 0.0, 0.0};
+  if (t >= accel_time) return {peak_velocity * accel_time / 2.0, peak_velocity, 0.0};
+
+  // Acceleration ramping up
+  if (t < jerk_time) return {jerk * t * t * t / 6.0, jerk * t * t / 2.0, jerk * t};
+
+  // Constant acceleration
+  if (t < accel_time - jerk_time) {
+    double v1 = peak_acceleration * jerk_time / 2.0;
+    double p1 = peak_acceleration * jerk_time * jerk_time / 6.0;
+    double tau = t - jerk_time;
+    return {p1 + v1 * tau + peak_acceleration * tau * tau / 2.0, v1 + peak_acceleration * tau, peak_acceleration};
+  }
+
+  // Acceleration ramping down mirrors ramping up
+  double s = accel_time - t;
+  return {peak_velocity * accel_time / 2.0 - (peak_velocity * s - jerk * s * s * s / 6.0), peak_velocity - jerk * s * s / 2.0, jerk * s};
+}
+
+profile_point motion_profile::sample(double t) const {
+  profile_point output;
+  double decel_start = accel_time + cruise_time;
+  if (t < accel_time) {
+    output = accel_sample(t);
+  } else if (t < decel_start) {
+    output = {peak_velocity * accel_time / 2.0 + peak_velocity * (t - accel_time), peak_velocity, 0.0};
+  } else {
+    // Slowing down is speeding up backwards in time from the end
+    profile_point mirror = accel_sample(duration_get() - t);
+    output = {distance - mirror.position, mirror.velocity, -mirror.acceleration};
+  }
+  return {sign * output.position, sign * output.velocity, sign * output.acceleration};
+}
@@ -0,0 +1,78 @@
+#include "control/scheduler.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace control;
+
+// Every scheduler registers itself here so timing can be dumped in one call
+static std::vector<scheduler*>& schedulers() {
+  static std::vector<scheduler*> all;
+  return all;
+}
+
+scheduler::scheduler(std::string name, int period) : stats(period), name(name), period(period) {
+  schedulers().push_back(this);
+}
+
+scheduler::~scheduler() {
+  std::vector<scheduler*>& all = schedulers();
+  all.erase(std::remove(all.begin(), all.end(), this), all.end());
+}
+
+void scheduler::start() {
+  wake_time = pros::millis();
+  tick_start = pros::micros();
+  started = true;
+}
+
+void scheduler::wait() {
+  if (!started) start();
+
+  uint64_t now = pros::micros();
+  uint32_t exec = now - tick_start;
+  stats.exec_add(exec);
+
+  // When the body took longer than a whole period, delay_until would return immediately
+  // until it caught up.  Drop the missed periods instead of bursting through them
+  if (exec > (uint32_t)period * 1000) {
+    stats.overrun_add();
+    wake_time = pros::millis();
+  }
+  pros::Task::delay_until(&wake_time, period);
+
+  now = pros::micros();
+  stats.period_add(now - tick_start);
+  tick_start = now;
+}
+
+void scheduler::run(std::function<void()> body) {
+  start();
+  while (true) {
+    body();
+    wait();
+  }
+}
+
+void scheduler::period_set(int ms) {
+  period = ms;
+  stats.target_period_set(ms);
+  stats.reset();
+}
+int scheduler::period_get() { return period; }
+
+uint64_t scheduler::tick_start_get() { return tick_start; }
+
+std::string scheduler::name_get() { return name; }
+
+void scheduler::stats_print() { stats.print(name.c_str()); }
+
+void control::schedulers_print() {
+  for (auto loop : schedulers())
+    loop->stats_print();
+}
+
+void control::schedulers_reset() {
+  for (auto loop : schedulers())
+    loop->stats.reset();
+}
@@ -0,0 +1,53 @@
+#include "control/settle.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace control;
+
+settle_predictor::settle_predictor(const ez::PID& pid, const settle_constants& constants) : exit(pid.exit), constants(constants) {}
+
+void settle_predictor::start() {
+  last_time = 0;
+  small_since = 0;
+  big_since = 0;
+  count = 0;
+  saved = 0;
+  settled = false;
+}
+
+bool settle_predictor::iterate(double error, double motor_rpm, uint64_t timestamp) {
+  // The first call has nothing to take a rate from, so it projects the error as holding still
+  double rate = 0.0;
+  if (last_time != 0 && timestamp > last_time) rate = (error - last_error) / ((timestamp - last_time) / 1000000.0);
+  return iterate(error, rate, motor_rpm, timestamp);
+}
+
+bool settle_predictor::iterate(double error, double rate, double motor_rpm, uint64_t timestamp) {
+  last_error = error;
+  last_time = timestamp;
+  if (!constants.enabled || settled || exit.small_error <= 0.0) return settled;
+
+  // Track when the error went inside each band, the same way the exit timers do
+  small_since = fabs(error) < exit.small_error ? (small_since == 0 ? timestamp : small_since) : 0;
+  big_since = fabs(error) < exit.big_error ? (big_since == 0 ? timestamp : big_since) : 0;
+
+  // The error moves in a straight line, so it stays inside small_error if both ends of the projection are inside
+  double projected = error + rate * constants.horizon;
+  bool inside = small_since != 0 && fabs(projected) < exit.small_error && fabs(motor_rpm) < constants.motor_rpm;
+  count = inside ? count + 1 : 0;
+  if (count < constants.ticks) return false;
+
+  // The timers would have exited once either band's time ran out
+  settled = true;
+  int small_left = exit.small_exit_time - (int)((timestamp - small_since) / 1000);
+  int left = small_left;
+  if (exit.big_exit_time > 0 && exit.big_error > 0.0) {
+    int big_left = exit.big_exit_time - (int)((timestamp - big_since) / 1000);
+    left = std::min(left, big_left);
+  }
+  saved = std::max(0, left);
+  return true;
+}
+
+int settle_predictor::saved_get() const { return saved; }
@@ -0,0 +1,48 @@
+#include "control/slew.hpp"
+
+#include <cmath>
+
+#include "EZ-Template/util.hpp"
+
+using namespace control;
+
+slew_limiter::slew_limiter(const ez::slew& distance, const slew_limits& limits, int period)
+    : distance(distance), limits(limits), period(period) {}
+
+void slew_limiter::initialize(bool ienabled, double imax_speed, double target, double current) {
+  enabled = ienabled;
+  max_speed = fabs(imax_speed);
+  speed = 0.0;
+  acceleration = 0.0;
+  last = 0;
+  if (limits.acceleration <= 0.0) distance.initialize(ienabled, imax_speed, target, current);
+}
+
+double slew_limiter::iterate(double output, double current, uint64_t timestamp) {
+  if (limits.acceleration <= 0.0) return ez::util::clamp(output, distance.iterate(current));
+  output = ez::util::clamp(output, max_speed);
+  if (!enabled) return output;
+
+  double dt = last == 0 ? period / 1000.0 : (timestamp - last) / 1000000.0;
+  last = timestamp;
+  double error = output - speed;
+  if (limits.jerk <= 0.0) {
+    double step = limits.acceleration * dt;
+    speed += ez::util::clamp(error, step, -step);
+    return speed;
+  }
+
+  // Head for the acceleration that can still ease out to 0 as speed reaches the output, either direction
+  double wanted = ez::util::sgn(error) * fmin(limits.acceleration, sqrt(2.0 * limits.jerk * fabs(error)));
+  double change = limits.jerk * dt;
+  acceleration += ez::util::clamp(wanted - acceleration, change, -change);
+  double step = acceleration * dt;
+  if (step * error > 0.0 && fabs(step) >= fabs(error)) {
+    // Landed on the output
+    speed = output;
+    acceleration = 0.0;
+  } else {
+    speed += step;
+  }
+  return speed;
+}
@@ -19,6 +19,11 @@ ez::Drive chassis(
     360);   // Wheel RPM = cartridge * (motor gear / wheel gear)
 
 
+// Runs odometry and the active motion in one task, see pipeline_boomerang_example()
+control::ez_backend chassis_backend(chassis);
+control::pipeline drive_pipeline(chassis_backend);
+
+
 // Uncomment the trackers you're using here!
 // - `8` and `9` are smart ports (making these negative will reverse the sensor)
 //  - you should get positive values on the encoders going FORWARD and RIGHT
@@ -67,34 +72,10 @@ void initialize() {
   // chassis.opcontrol_curve_buttons_right_set(pros::E_CONTROLLER_DIGITAL_Y, pros::E_CONTROLLER_DIGITAL_A);
 
 
-  // Autonomous Selector using LLEMU
-  ez::as::auton_selector.autons_add({
-      // ========== COMPETITION ROUTINES ==========
-      {"LEFT SIDE\n\nLeft side scoring", autonomous_left_side},
-      {"LEFT SIDE FULL\n\nLeft side full routine", autonomous_left_side_full},
-      {"RIGHT SIDE FULL\n\nRight side full routine", autonomous_right_side_full},
-      {"RIGHT SIDE\n\nRight side scoring", autonomous_right_side},
-      {"SAFE\n\nSingle piece fallback", autonomous_safe},
-      {"SKILLS\n\nSkills challenge", autonomous_skills},
-
-
-     
-      // ========== TEST/DEBUG ROUTINES ==========
-      {"Drive\n\nDrive forward and come back", drive_example},
-      {"Turn\n\nTurn 3 times.", turn_example},
-      {"Drive and Turn\n\nDrive forward, turn, come back", drive_and_turn},
-      {"Drive and Turn\n\nSlow down during drive", wait_until_change_speed},
-      {"Swing Turn\n\nSwing in an 'S' curve", swing_example},
-      {"Motion Chaining\n\nDrive forward, turn, and come back, but blend everything together :D", motion_chaining},
-      {"Combine all 3 movements", combining_movements},
-      {"Interference\n\nAfter driving forward, robot performs differently if interfered or not", interfered_example},
-      {"Simple Odom\n\nThis is the same as the drive example, but it uses odom instead!", odom_drive_example},
-      {"Pure Pursuit\n\nGo to (0, 30) and pass through (6, 10) on the way.  Come back to (0, 0)", odom_pure_pursuit_example},
-      {"Pure Pursuit Wait Until\n\nGo to (24, 24) but start running an intake once the robot passes (12, 24)", odom_pure_pursuit_wait_until_example},
-      {"Boomerang\n\nGo to (0, 24, 45) then come back to (0, 0, 0)", odom_boomerang_example},
-      {"Boomerang Pure Pursuit\n\nGo to (0, 24, 45) on the way to (24, 24) then come back to (0, 0, 0)", odom_boomerang_injected_pure_pursuit_example},
-      {"Measure Offsets\n\nThis will turn the robot a bunch of times and calculate your offsets for your tracking wheels.", measure_offsets},  
-  });
+  // Autonomous Selector using LLEMU, the pages are in autons.cpp so the sim runs the same ones
+  std::vector<ez::Auton> autons;
+  for (const auton_page& page : AUTON_PAGES) autons.push_back(ez::Auton(page.name, page.run));
+  ez::as::auton_selector.autons_add(autons);
 
 
   // Initialize chassis and auton selector
@@ -121,6 +102,13 @@ void initialize() {
  * the robot is enabled, this task will exit.
  */
 void disabled() {
+  // Dump loop timing from the mode that just ended
+  control::schedulers_print();
+  control::schedulers_reset();
+
+  // Give the drive back to EZ-Template if an auton ended mid pipeline motion
+  drive_pipeline.disable();
+
   // Stop all drive motors
   chassis.drive_brake_set(MOTOR_BRAKE_HOLD);
  
@@ -198,12 +186,31 @@ void screen_print_tracker(ez::tracking_wheel *tracker, std::string name, int lin
 }
 
 
+/**
+ * Simplifies printing loop timing to the brain screen
+ */
+void screen_print_loop(control::scheduler &loop, int line) {
+  control::loop_stats &stats = loop.stats;
+  ez::screen_print(loop.name_get() + " " + util::to_string_with_precision(stats.period.mean_get() / 1000.0) +
+                       " " + util::to_string_with_precision(stats.period.max_get() / 1000.0) +
+                       " " + util::to_string_with_precision(stats.exec.mean_get() / 1000.0) +
+                       " " + std::to_string(stats.overruns_get()),
+                   line);
+}
+
+
+// Fixed rate loops, these are measured and printed in disabled()
+control::scheduler screen_loop("screen");
+control::scheduler opcontrol_loop("opcontrol");
+
+
 /**
  * Ez screen task
  * Adding new pages here will let you view them during user control or autonomous
  * and will help you debug problems you're having
  */
 void ez_screen_task() {
+  screen_loop.start();
   while (true) {
     // Only run this when not connected to a competition switch
     if (!pros::competition::is_connected()) {
@@ -211,10 +218,11 @@ void ez_screen_task() {
       if (chassis.odom_enabled() && !chassis.pid_tuner_enabled()) {
         // If we're on the first blank page...
         if (ez::as::page_blank_is_on(0)) {
-          // Display X, Y, and Theta
-          ez::screen_print("x: " + util::to_string_with_precision(chassis.odom_x_get()) +
-                               "\ny: " + util::to_string_with_precision(chassis.odom_y_get()) +
-                               "\na: " + util::to_string_with_precision(chassis.odom_theta_get()),
+          // Display X, Y, and Theta, all from the same odometry update
+          ez::pose current = drive_pipeline.enabled() ? drive_pipeline.odom_pose_get().pose : chassis.odom_pose_get();
+          ez::screen_print("x: " + util::to_string_with_precision(current.x) +
+                               "\ny: " + util::to_string_with_precision(current.y) +
+                               "\na: " + util::to_string_with_precision(current.theta),
                            1);  // Don't override the top Page line
 
 
@@ -233,6 +241,14 @@ void ez_screen_task() {
         ez::screen_print("Intake B: " + std::to_string((int)intake_motor_b.get_temperature()) + "C", 3);
         ez::screen_print("Battery: " + std::to_string((int)pros::battery::get_capacity()) + "%", 7);
       }
+
+      // Loop timing page
+      if (ez::as::page_blank_is_on(2)) {
+        ez::screen_print("mean max exec(ms) overruns", 1);
+        screen_print_loop(opcontrol_loop, 2);
+        screen_print_loop(screen_loop, 3);
+        screen_print_loop(drive_pipeline.loop, 4);
+      }
     }
 
 
@@ -243,7 +259,7 @@ void ez_screen_task() {
     }
 
 
-    pros::delay(ez::util::DELAY_TIME);
+    screen_loop.wait();
   }
 }
 pros::Task ezScreenTask(ez_screen_task);
@@ -306,10 +322,13 @@ void ez_template_extras() {
  * task, not resume it from where it left off.
  */
 void opcontrol() {
+  drive_pipeline.disable();
+
   // This is preference to what you like to drive on
   chassis.drive_brake_set(MOTOR_BRAKE_COAST);
 
 
+  opcontrol_loop.start();
   while (true) {
     // Gives you some extras to make EZ-Template ezier
     ez_template_extras();
@@ -386,6 +405,6 @@ void opcontrol() {
     }
 
 
-    pros::delay(ez::util::DELAY_TIME);  // This is used for timer calculations!  Keep this ez::util::DELAY_TIME
+    opcontrol_loop.wait();  // Runs at ez::util::DELAY_TIME, this is used for timer calculations!
   }
 }
@@ -0,0 +1,56 @@
+#include "autons.hpp"
+#include "control/pipeline.hpp"
+
+// Defined in main.cpp on the robot and in sim/main.cpp in the simulator.  These autons only use the pipeline, so they
+// run in both.
+extern control::pipeline drive_pipeline;
+
+using ez::fwd;
+using ez::rev;
+
+
+///
+// Pipeline Boomerang
+///
+void pipeline_boomerang_example() {
+  // Odometry and the motion run in one task, so boomerang always uses this tick's pose
+  drive_pipeline.enable();
+
+
+  drive_pipeline.pid_odom_set({{0_in, 24_in, 45_deg}, fwd, DRIVE_SPEED},
+                              true);
+  drive_pipeline.pid_wait();
+
+
+  drive_pipeline.pid_odom_set({{0_in, 0_in, 0_deg}, rev, DRIVE_SPEED},
+                              true);
+  drive_pipeline.pid_wait();
+
+
+  drive_pipeline.stats_print();
+  drive_pipeline.disable();
+}
+
+
+///
+// Pipeline Queue
+///
+void pipeline_queue_example() {
+  drive_pipeline.enable();
+
+
+  // Everything is queued up front, each motion starts on the tick the one before it exits
+  drive_pipeline.queue_drive_add(24_in, DRIVE_SPEED, true);
+  drive_pipeline.queue_turn_add(90_deg, TURN_SPEED);
+  drive_pipeline.queue_odom_add({{{24_in, 24_in}, fwd, DRIVE_SPEED},
+                                 {{24_in, 0_in}, fwd, DRIVE_SPEED}},
+                                true);
+  drive_pipeline.queue_odom_add({{0_in, 0_in, 0_deg}, rev, DRIVE_SPEED},
+                                true);
+  drive_pipeline.queue_wait();
+
+
+  drive_pipeline.stats_print();
+  drive_pipeline.disable();
+}
+